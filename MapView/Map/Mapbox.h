@@ -47,6 +47,7 @@
 #import "RMPointAnnotation.h"
 #import "RMPolygonAnnotation.h"
 #import "RMPolylineAnnotation.h"
+#import "RMReprojectedTileSource.h"
 #import "RMShape.h"
 #import "RMStaticMapView.h"
 #import "RMTileCache.h"
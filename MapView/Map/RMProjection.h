@@ -70,4 +70,22 @@
                     northing:(double)northing
                 toCoordinate:(CLLocationCoordinate2D *)coordinate;
 
+// C array versions of the above for #count points at once, with any mix of zones. These go through PROJ.4's
+// transverse Mercator (WGS84) in a single pass. Points that can't be converted come back as HUGE_VAL
+// eastings/northings, or kCLLocationCoordinate2DInvalid. Each call works on its own copy of the projection, so
+// these are safe to call from any number of threads at once.
++ (void)convertCoordinates:(const CLLocationCoordinate2D *)coordinates
+                     count:(NSUInteger)count
+          toUTMZoneNumbers:(int *)utmZoneNumbers
+     isNorthernHemisphere:(BOOL *)isNorthernHemisphere // may be NULL
+                  eastings:(double *)eastings
+                 northings:(double *)northings;
+
++ (void)convertUTMZoneNumbers:(const int *)utmZoneNumbers
+         isNorthernHemisphere:(const BOOL *)isNorthernHemisphere
+                     eastings:(const double *)eastings
+                    northings:(const double *)northings
+                        count:(NSUInteger)count
+                toCoordinates:(CLLocationCoordinate2D *)coordinates;
+
 @end
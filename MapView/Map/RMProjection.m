@@ -199,6 +199,32 @@ static RMProjection *_latitudeLongitudeProjection = nil;
 #define deg2rad (M_PI / 180.0)
 #define rad2deg (180.0 / M_PI)
 
+static double RMUTMNormalizedLongitude(double longitude)
+{
+    return (longitude + 180.0) - (floor((longitude + 180.0) / 360.0) * 360.0) - 180.0;
+}
+
+// UTM zone for a latitude and a longitude already normalized to -180.00 .. 179.9, including the
+// exceptions for southern Norway and Svalbard.
+static int RMUTMZoneNumber(double latitude, double longitude)
+{
+    int zoneNumber = floor((longitude + 180.0) / 6.0) + 1;
+
+    if (latitude >= 56.0 && latitude < 64.0 && longitude >= 3.0 && longitude < 12.0)
+        zoneNumber = 32;
+
+    // Special zones for Svalbard
+    if (latitude >= 72.0 && latitude < 84.0)
+    {
+        if (longitude >= 0.0 && longitude < 9.0) zoneNumber = 31;
+        else if (longitude >= 9.0 && longitude < 21.0) zoneNumber = 33;
+        else if (longitude >= 21.0 && longitude < 33.0) zoneNumber = 35;
+        else if (longitude >= 33.0 && longitude < 42.0) zoneNumber = 37;
+    }
+
+    return zoneNumber;
+}
+
 // This routine determines the correct UTM letter designator for the given latitude.
 // Returns 'Z' if latitude is outside the UTM limits of 84N to 80S
 // Written by Chuck Gantz- chuck.gantz@globalstar.com
@@ -252,23 +278,11 @@ static RMProjection *_latitudeLongitudeProjection = nil;
     double N, T, C, A, M;
 
     // Make sure the longitude is between -180.00 .. 179.9
-    double longitudeTemp = (coordinate.longitude + 180.0) - (floor((coordinate.longitude + 180.0) / 360.0) * 360.0) - 180.0;
+    double longitudeTemp = RMUTMNormalizedLongitude(coordinate.longitude);
     double latitudeRad = coordinate.latitude * deg2rad;
     double longitudeRad = longitudeTemp * deg2rad;
 
-    *utmZoneNumber = floor((longitudeTemp + 180.0) / 6.0) + 1;
-
-    if (coordinate.latitude >= 56.0 && coordinate.latitude < 64.0 && longitudeTemp >= 3.0 && longitudeTemp < 12.0)
-        *utmZoneNumber = 32;
-
-    // Special zones for Svalbard
-    if (coordinate.latitude >= 72.0 && coordinate.latitude < 84.0)
-    {
-        if (longitudeTemp >= 0.0 && longitudeTemp < 9.0) *utmZoneNumber = 31;
-        else if (longitudeTemp >= 9.0 && longitudeTemp < 21.0) *utmZoneNumber = 33;
-        else if (longitudeTemp >= 21.0 && longitudeTemp < 33.0) *utmZoneNumber = 35;
-        else if (longitudeTemp >= 33.0 && longitudeTemp < 42.0) *utmZoneNumber = 37;
-    }
+    *utmZoneNumber = RMUTMZoneNumber(coordinate.latitude, longitudeTemp);
 
     longitudeOrigin = (*utmZoneNumber - 1) * 6 - 180 + 3;  //+3 puts origin in middle of zone
     longitudeOriginRad = longitudeOrigin * deg2rad;
@@ -368,4 +382,142 @@ static RMProjection *_latitudeLongitudeProjection = nil;
     (*coordinate).longitude = longitude;
 }
 
+// PROJ.4 definition the C array conversions work from. Only its ellipsoid is used, the zone is given per point.
+static projPJ RMUTMProjection(void)
+{
+    static projPJ utmProjection = NULL;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        utmProjection = pj_init_plus("+proj=utm +zone=1 +ellps=WGS84 +units=m +no_defs");
+    });
+
+    return utmProjection;
+}
+
+// A copy of the above on a context of its own. The batch routines keep their error state in the context, so
+// each call gets a copy and calls from different threads can't clear or set each other's errors.
+static projPJ RMUTMProjectionCopy(void)
+{
+    projPJ utmProjection = RMUTMProjection();
+    projCtx context;
+    projPJ copy;
+
+    if (utmProjection == NULL || (context = pj_ctx_alloc()) == NULL)
+        return NULL;
+
+    if ((copy = pj_clone_ctx(context, utmProjection)) == NULL)
+        pj_ctx_free(context);
+
+    return copy;
+}
+
+static void RMUTMProjectionCopyFree(projPJ copy)
+{
+    if (copy == NULL)
+        return;
+
+    projCtx context = pj_get_ctx(copy);
+
+    pj_free(copy);
+    pj_ctx_free(context);
+}
+
++ (void)convertCoordinates:(const CLLocationCoordinate2D *)coordinates
+                     count:(NSUInteger)count
+          toUTMZoneNumbers:(int *)utmZoneNumbers
+     isNorthernHemisphere:(BOOL *)isNorthernHemisphere
+                  eastings:(double *)eastings
+                 northings:(double *)northings
+{
+    if (count == 0)
+        return;
+
+    int *zones = malloc(count * sizeof(int));
+    projPJ utmProjection = (zones != NULL ? RMUTMProjectionCopy() : NULL);
+
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        double longitude = RMUTMNormalizedLongitude(coordinates[i].longitude);
+        BOOL isNorthern = (coordinates[i].latitude >= 0);
+
+        utmZoneNumbers[i] = RMUTMZoneNumber(coordinates[i].latitude, longitude);
+
+        if (zones != NULL)
+            zones[i] = (isNorthern ? utmZoneNumbers[i] : -utmZoneNumbers[i]);
+
+        if (isNorthernHemisphere != NULL)
+            isNorthernHemisphere[i] = isNorthern;
+
+        eastings[i]  = longitude * DEG_TO_RAD;
+        northings[i] = coordinates[i].latitude * DEG_TO_RAD;
+    }
+
+    if (utmProjection != NULL)
+    {
+        pj_utm_fwd_array(utmProjection, count, 1, zones, eastings, northings);
+    }
+    else
+    {
+        RMLog(@"Unable to set up the UTM conversion of %lu coordinates", (unsigned long)count);
+
+        for (NSUInteger i = 0; i < count; i++)
+            eastings[i] = northings[i] = HUGE_VAL;
+    }
+
+    RMUTMProjectionCopyFree(utmProjection);
+    free(zones);
+}
+
++ (void)convertUTMZoneNumbers:(const int *)utmZoneNumbers
+         isNorthernHemisphere:(const BOOL *)isNorthernHemisphere
+                     eastings:(const double *)eastings
+                    northings:(const double *)northings
+                        count:(NSUInteger)count
+                toCoordinates:(CLLocationCoordinate2D *)coordinates
+{
+    if (count == 0)
+        return;
+
+    int *zones = malloc(count * sizeof(int));
+    projPJ utmProjection = (zones != NULL ? RMUTMProjectionCopy() : NULL);
+
+    if (utmProjection == NULL)
+    {
+        RMLog(@"Unable to set up the UTM conversion of %lu points", (unsigned long)count);
+
+        for (NSUInteger i = 0; i < count; i++)
+            coordinates[i] = kCLLocationCoordinate2DInvalid;
+
+        free(zones);
+        return;
+    }
+
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        zones[i] = (isNorthernHemisphere[i] ? utmZoneNumbers[i] : -utmZoneNumbers[i]);
+
+        coordinates[i].longitude = eastings[i];
+        coordinates[i].latitude  = northings[i];
+    }
+
+    // CLLocationCoordinate2D is {latitude, longitude}, so both run through the array two doubles apart
+    pj_utm_inv_array(utmProjection, count, sizeof(CLLocationCoordinate2D) / sizeof(double), zones, &coordinates[0].longitude, &coordinates[0].latitude);
+
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        if (coordinates[i].longitude == HUGE_VAL)
+        {
+            coordinates[i] = kCLLocationCoordinate2DInvalid;
+            continue;
+        }
+
+        coordinates[i].latitude  *= RAD_TO_DEG;
+        coordinates[i].longitude *= RAD_TO_DEG;
+    }
+
+    RMUTMProjectionCopyFree(utmProjection);
+    free(zones);
+}
+
 @end
@@ -0,0 +1,57 @@
+//
+//  RMReprojectedTileSource.h
+//  MapView
+//
+// Copyright (c) 2008-2013, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+
+#import "RMAbstractMercatorTileSource.h"
+#import "RMTileReprojection.h"
+
+/** RMReprojectedTileSource displays the tiles of another tile source that is not in spherical Mercator, such as a national grid, by reprojecting them into spherical Mercator tiles as they are needed.
+*
+*   The wrapped tile source's projection gives the coordinate system of its tiles, and the planet bounds of that projection the area covered by its single tile at zoom level 0. Each zoom level splits every tile in four, with rows counted from the top, the same as for spherical Mercator tiles. The wrapped source is asked for its tiles by those coordinates.
+*
+*   The result is cached under its own tile cache key, so the wrapped tile source is best left uncached. */
+@interface RMReprojectedTileSource : RMAbstractMercatorTileSource
+
+/** @name Creating Tile Sources */
+
+/** Initialize a reprojecting tile source.
+*
+*   @param tileSource The tile source to be reprojected. Its projection must have been created with bounds.
+*   @param tileCacheKey A tile cache key for storage of reprojected tiles, or `nil` to not cache them.
+*   @return An initialized reprojecting tile source, or `nil` if the tile source's projection can't be used. */
+- (id)initWithTileSource:(id <RMTileSource>)tileSource tileCacheKey:(NSString *)tileCacheKey;
+
+/** @name Querying Tile Source Information */
+
+/** The tile source being reprojected. */
+@property (nonatomic, readonly) id <RMTileSource> tileSource;
+
+/** @name Configuring Resampling */
+
+/** How source pixels are resampled. Defaults to `RMTileResamplingBilinear`. */
+@property (nonatomic, assign) RMTileResampling resampling;
+
+@end
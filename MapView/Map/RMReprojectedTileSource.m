@@ -0,0 +1,299 @@
+//
+//  RMReprojectedTileSource.m
+//  MapView
+//
+// Copyright (c) 2008-2013, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+
+#import "RMReprojectedTileSource.h"
+#import "RMTileCache.h"
+#import "RMProjection.h"
+
+#import "proj_api.h"
+
+// What the source tile callback needs to fetch a tile and turn it into RGBA pixels
+typedef struct {
+    __unsafe_unretained id <RMTileSource> tileSource;
+    __unsafe_unretained RMTileCache *tileCache;
+    CGContextRef bitmap;
+    uint8_t *pixels;
+    size_t sideLength;
+} RMReprojectedTileSourceFetch;
+
+static const uint8_t *RMReprojectedTileSourceTile(void *context, uint32_t x, uint32_t y, short zoom)
+{
+    RMReprojectedTileSourceFetch *fetch = (RMReprojectedTileSourceFetch *)context;
+    RMTile tile = RMTileMake(x, y, zoom);
+
+    if ( ! [fetch->tileSource tileSourceHasTile:tile])
+        return NULL;
+
+    UIImage *tileImage = [fetch->tileSource imageForTile:tile inCache:fetch->tileCache];
+
+    // sources return NSNull for missing tiles
+    if ( ! [tileImage isKindOfClass:[UIImage class]])
+        return NULL;
+
+    CGRect rect = CGRectMake(0, 0, fetch->sideLength, fetch->sideLength);
+
+    CGContextClearRect(fetch->bitmap, rect);
+    CGContextDrawImage(fetch->bitmap, rect, tileImage.CGImage);
+
+    return fetch->pixels;
+}
+
+// Premultiplied RGBA, in that byte order, which is what RMTileReprojection expects
+static CGContextRef RMReprojectedTileSourceCreateBitmap(uint8_t *pixels, size_t sideLength)
+{
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef bitmap = CGBitmapContextCreate(pixels, sideLength, sideLength, 8, sideLength * 4, colorSpace, kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+
+    CGColorSpaceRelease(colorSpace);
+
+    return bitmap;
+}
+
+@implementation RMReprojectedTileSource
+{
+    id <RMTileSource> _tileSource;
+    NSString *_uniqueTilecacheKey;
+
+    char *_sourceDefinition;
+    RMProjectedRect _sourceBounds;
+
+    // Idle RMTileReprojection pointers. A reprojection can only be used by one thread at a time, and tiles
+    // are drawn on several, so each takes one from here or makes a new one.
+    NSMutableArray *_reprojections;
+}
+
+@synthesize tileSource = _tileSource;
+@synthesize resampling = _resampling;
+
+- (id)initWithTileSource:(id <RMTileSource>)tileSource tileCacheKey:(NSString *)tileCacheKey
+{
+    if (!(self = [super init]))
+        return nil;
+
+    NSAssert(tileSource != nil, @"Empty tileSource parameter not allowed");
+
+    _tileSource = tileSource;
+    _sourceBounds = tileSource.projection.planetBounds;
+    _sourceDefinition = pj_get_def(tileSource.projection.internalProjection, 0);
+    _reprojections = [NSMutableArray new];
+
+    if (tileCacheKey)
+    {
+        _uniqueTilecacheKey = tileCacheKey;
+    }
+    else
+    {
+        self.cacheable = NO;
+        _uniqueTilecacheKey = nil;
+    }
+
+    // check that the source can be reprojected at all
+    RMTileReprojection *reprojection = [self dequeueReprojection];
+
+    if ( ! reprojection)
+    {
+        RMLog(@"Can't reproject tile source %@ with bounds %f,%f %fx%f", tileSource, _sourceBounds.origin.x, _sourceBounds.origin.y, _sourceBounds.size.width, _sourceBounds.size.height);
+        return nil;
+    }
+
+    [self enqueueReprojection:reprojection];
+
+    // Spherical Mercator zoom levels that show the source's zoom levels at about the same scale, going by the
+    // size on the ground of a source pixel in the middle of the source's bounds
+    RMProjectedPoint center = RMProjectedPointMake(_sourceBounds.origin.x + _sourceBounds.size.width / 2.0, _sourceBounds.origin.y + _sourceBounds.size.height / 2.0);
+    double pixelSize = _sourceBounds.size.width / tileSource.tileSideLength;
+
+    CLLocationCoordinate2D west = [tileSource.projection projectedPointToCoordinate:RMProjectedPointMake(center.x - pixelSize / 2.0, center.y)];
+    CLLocationCoordinate2D east = [tileSource.projection projectedPointToCoordinate:RMProjectedPointMake(center.x + pixelSize / 2.0, center.y)];
+
+    CLLocationDistance sourcePixelDistance = [[[CLLocation alloc] initWithLatitude:west.latitude longitude:west.longitude] distanceFromLocation:[[CLLocation alloc] initWithLatitude:east.latitude longitude:east.longitude]];
+    double mercatorPixelDistance = 2.0 * 20037508.34 / kRMTileReprojectionSideLength * cos((west.latitude + east.latitude) / 2.0 * M_PI / 180.0);
+    double zoomOffset = 0.0;
+
+    if (sourcePixelDistance > 0.0 && mercatorPixelDistance > 0.0)
+        zoomOffset = round(log2(mercatorPixelDistance / sourcePixelDistance));
+
+    self.minZoom = MAX(0.0, tileSource.minZoom + zoomOffset);
+    self.maxZoom = MAX(self.minZoom, tileSource.maxZoom + zoomOffset);
+    self.opaque = NO;
+    self.resampling = RMTileResamplingBilinear;
+
+    return self;
+}
+
+- (void)dealloc
+{
+    for (NSValue *reprojection in _reprojections)
+        RMTileReprojectionFree([reprojection pointerValue]);
+
+    if (_sourceDefinition)
+        pj_dalloc(_sourceDefinition);
+}
+
+- (RMTileReprojection *)dequeueReprojection
+{
+    @synchronized (_reprojections)
+    {
+        NSValue *reprojection = [_reprojections lastObject];
+
+        if (reprojection)
+        {
+            [_reprojections removeLastObject];
+            return [reprojection pointerValue];
+        }
+    }
+
+    if ( ! _sourceDefinition)
+        return NULL;
+
+    return RMTileReprojectionCreate(_sourceDefinition, _sourceBounds, (uint32_t)_tileSource.tileSideLength, (short)_tileSource.minZoom, (short)_tileSource.maxZoom);
+}
+
+- (void)enqueueReprojection:(RMTileReprojection *)reprojection
+{
+    @synchronized (_reprojections)
+    {
+        [_reprojections addObject:[NSValue valueWithPointer:reprojection]];
+    }
+}
+
+- (NSString *)uniqueTilecacheKey
+{
+    return _uniqueTilecacheKey;
+}
+
+- (NSString *)shortName
+{
+	return [_tileSource shortName];
+}
+
+- (NSString *)longDescription
+{
+	return [_tileSource longDescription];
+}
+
+- (NSString *)shortAttribution
+{
+	return [_tileSource shortAttribution];
+}
+
+- (NSString *)longAttribution
+{
+	return [_tileSource longAttribution];
+}
+
+- (void)cancelAllDownloads
+{
+    [_tileSource cancelAllDownloads];
+}
+
+- (void)didReceiveMemoryWarning
+{
+    [super didReceiveMemoryWarning];
+
+    [_tileSource didReceiveMemoryWarning];
+
+    // the idle reprojections hold on to a mosaic of source tiles each
+    @synchronized (_reprojections)
+    {
+        for (NSValue *reprojection in _reprojections)
+            RMTileReprojectionFree([reprojection pointerValue]);
+
+        [_reprojections removeAllObjects];
+    }
+}
+
+- (UIImage *)imageForTile:(RMTile)tile inCache:(RMTileCache *)tileCache
+{
+    UIImage *image = nil;
+
+	tile = [[self mercatorToTileProjection] normaliseTile:tile];
+
+    if (RMTileIsDummy(tile))
+        return nil;
+
+    if (self.isCacheable)
+    {
+        image = [tileCache cachedImage:tile withCacheKey:[self uniqueTilecacheKey]];
+
+        if (image)
+            return image;
+    }
+
+    RMTileReprojection *reprojection = [self dequeueReprojection];
+
+    if ( ! reprojection)
+        return nil;
+
+    dispatch_async(dispatch_get_main_queue(), ^(void)
+    {
+        [[NSNotificationCenter defaultCenter] postNotificationName:RMTileRequested object:[NSNumber numberWithUnsignedLongLong:RMTileKey(tile)]];
+    });
+
+    size_t sourceSideLength = _tileSource.tileSideLength;
+    uint8_t *sourcePixels = malloc(sourceSideLength * sourceSideLength * 4);
+    uint8_t *pixels = malloc(kRMTileReprojectionSideLength * kRMTileReprojectionSideLength * 4);
+
+    RMReprojectedTileSourceFetch fetch = {
+        .tileSource = _tileSource,
+        .tileCache = tileCache,
+        .bitmap = (sourcePixels ? RMReprojectedTileSourceCreateBitmap(sourcePixels, sourceSideLength) : NULL),
+        .pixels = sourcePixels,
+        .sideLength = sourceSideLength,
+    };
+
+    if (fetch.bitmap && pixels && RMTileReprojectionRenderTile(reprojection, tile.x, tile.y, tile.zoom, self.resampling, RMReprojectedTileSourceTile, &fetch, pixels))
+    {
+        CGContextRef bitmap = RMReprojectedTileSourceCreateBitmap(pixels, kRMTileReprojectionSideLength);
+        CGImageRef imageRef = CGBitmapContextCreateImage(bitmap);
+
+        image = [UIImage imageWithCGImage:imageRef];
+
+        CGImageRelease(imageRef);
+        CGContextRelease(bitmap);
+    }
+
+    [self enqueueReprojection:reprojection];
+
+    if (fetch.bitmap)
+        CGContextRelease(fetch.bitmap);
+
+    free(sourcePixels);
+    free(pixels);
+
+    if (image && self.isCacheable)
+        [tileCache addImage:image forTile:tile withCacheKey:[self uniqueTilecacheKey]];
+
+    dispatch_async(dispatch_get_main_queue(), ^(void)
+    {
+        [[NSNotificationCenter defaultCenter] postNotificationName:RMTileRetrieved object:[NSNumber numberWithUnsignedLongLong:RMTileKey(tile)]];
+    });
+
+    return image;
+}
+
+@end
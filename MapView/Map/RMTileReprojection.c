@@ -0,0 +1,355 @@
+//
+//  RMTileReprojection.c
+//
+// Copyright (c) 2008-2013, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "RMTileReprojection.h"
+#include "proj_api.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The same definition and bounds as +[RMProjection googleProjection]
+#define kRMTileReprojectionMercatorDefinition "+proj=merc +a=6378137 +b=6378137 +lat_ts=0.0 +lon_0=0.0 +x_0=0.0 +y_0=0 +k=1.0 +units=m +nadgrids=@null +no_defs"
+#define kRMTileReprojectionMercatorExtent 20037508.34
+
+// Largest number of source tiles across or down one tile is built from before a coarser source zoom is used
+#define kRMTileReprojectionMaxSourceTiles 4
+
+// Transformed pixel centres are interpolated to within this fraction of a source pixel
+#define kRMTileReprojectionTolerance 0.125
+
+struct RMTileReprojection {
+    projCtx context;
+    projPJ mercator, source;
+
+    RMProjectedRect sourceBounds;
+    uint32_t sourceTileSideLength;
+    short sourceMinZoom, sourceMaxZoom;
+
+    // pixel centres of the tile being built, in source pixels relative to the mosaic
+    double *x, *y;
+
+    // the source tiles under the tile being built, pasted together
+    uint8_t *mosaic;
+    size_t mosaicCapacity;
+};
+
+#pragma mark - Pixels
+
+// Bilinear blending works on the four channels of a pixel at once. With GCC and clang that's a
+// vector, which becomes SSE on the simulator and NEON on devices.
+
+#if defined(__GNUC__) || defined(__clang__)
+
+typedef float RMPixelVector __attribute__((vector_size(16)));
+typedef uint8_t RMPixelBytes __attribute__((vector_size(4)));
+
+static inline RMPixelVector RMPixelVectorLoad(const uint8_t *pixel)
+{
+    RMPixelBytes bytes;
+    memcpy(&bytes, pixel, 4);
+
+    return __builtin_convertvector(bytes, RMPixelVector);
+}
+
+static inline void RMPixelBlend(uint8_t *pixel, const uint8_t *p00, const uint8_t *p10, const uint8_t *p01, const uint8_t *p11, float fx, float fy)
+{
+    RMPixelVector top = RMPixelVectorLoad(p00) + (RMPixelVectorLoad(p10) - RMPixelVectorLoad(p00)) * fx;
+    RMPixelVector bottom = RMPixelVectorLoad(p01) + (RMPixelVectorLoad(p11) - RMPixelVectorLoad(p01)) * fx;
+    RMPixelBytes bytes = __builtin_convertvector(top + (bottom - top) * fy + 0.5f, RMPixelBytes);
+
+    memcpy(pixel, &bytes, 4);
+}
+
+#else
+
+static inline void RMPixelBlend(uint8_t *pixel, const uint8_t *p00, const uint8_t *p10, const uint8_t *p01, const uint8_t *p11, float fx, float fy)
+{
+    for (int c = 0; c < 4; c++)
+    {
+        float top = p00[c] + (p10[c] - p00[c]) * fx;
+        float bottom = p01[c] + (p11[c] - p01[c]) * fx;
+
+        pixel[c] = (uint8_t)(top + (bottom - top) * fy + 0.5f);
+    }
+}
+
+#endif
+
+#pragma mark - Creation
+
+RMTileReprojection *RMTileReprojectionCreate(const char *sourceDefinition, RMProjectedRect sourceBounds, uint32_t sourceTileSideLength, short sourceMinZoom, short sourceMaxZoom)
+{
+    RMTileReprojection *reprojection;
+
+    if (sourceBounds.size.width <= 0.0 || sourceBounds.size.height <= 0.0 || sourceTileSideLength == 0 || sourceMinZoom < 0 || sourceMaxZoom < sourceMinZoom)
+        return NULL;
+
+    reprojection = calloc(1, sizeof(RMTileReprojection));
+
+    if ( ! reprojection)
+        return NULL;
+
+    reprojection->context = pj_ctx_alloc();
+    reprojection->x = malloc(sizeof(double) * 2 * kRMTileReprojectionSideLength * kRMTileReprojectionSideLength);
+
+    if (reprojection->context && reprojection->x)
+    {
+        reprojection->mercator = pj_init_plus_ctx(reprojection->context, kRMTileReprojectionMercatorDefinition);
+        reprojection->source = pj_init_plus_ctx(reprojection->context, sourceDefinition);
+    }
+
+    if ( ! reprojection->mercator || ! reprojection->source)
+    {
+        RMTileReprojectionFree(reprojection);
+        return NULL;
+    }
+
+    reprojection->y = reprojection->x + kRMTileReprojectionSideLength * kRMTileReprojectionSideLength;
+    reprojection->sourceBounds = sourceBounds;
+    reprojection->sourceTileSideLength = sourceTileSideLength;
+    reprojection->sourceMinZoom = sourceMinZoom;
+    reprojection->sourceMaxZoom = sourceMaxZoom;
+
+    return reprojection;
+}
+
+void RMTileReprojectionFree(RMTileReprojection *reprojection)
+{
+    if ( ! reprojection)
+        return;
+
+    if (reprojection->mercator)
+        pj_free(reprojection->mercator);
+
+    if (reprojection->source)
+        pj_free(reprojection->source);
+
+    if (reprojection->context)
+        pj_ctx_free(reprojection->context);
+
+    free(reprojection->x);
+    free(reprojection->mosaic);
+    free(reprojection);
+}
+
+#pragma mark - Rendering
+
+// Size of a tile pixel in source units, from the first of a few points spread over the tile that transforms,
+// or 0 if none do.
+static double RMTileReprojectionPixelSize(RMTileReprojection *reprojection, double x0, double y0, double pixelSize)
+{
+    static const double offsets[] = { 0.5, 1.0 / 6.0, 5.0 / 6.0 };
+    double tileSize = pixelSize * kRMTileReprojectionSideLength;
+
+    for (int i = 0; i < 9; i++)
+    {
+        double x = x0 + offsets[i % 3] * tileSize, y = y0 - offsets[i / 3] * tileSize;
+        double px[3] = { x, x + pixelSize, x }, py[3] = { y, y, y - pixelSize };
+
+        if (pj_transform(reprojection->mercator, reprojection->source, 3, 1, px, py, NULL) != 0 || px[0] == HUGE_VAL || px[1] == HUGE_VAL || px[2] == HUGE_VAL)
+            continue;
+
+        double area = fabs((px[1] - px[0]) * (py[2] - py[0]) - (py[1] - py[0]) * (px[2] - px[0]));
+
+        if (area > 0.0)
+            return sqrt(area);
+    }
+
+    return 0.0;
+}
+
+bool RMTileReprojectionRenderTile(RMTileReprojection *reprojection, uint32_t x, uint32_t y, short zoom, RMTileResampling resampling, RMTileReprojectionSourceTileFunction sourceTile, void *context, uint8_t *pixels)
+{
+    const long count = kRMTileReprojectionSideLength * kRMTileReprojectionSideLength;
+    const uint32_t side = reprojection->sourceTileSideLength;
+    RMProjectedRect bounds = reprojection->sourceBounds;
+    double *px = reprojection->x, *py = reprojection->y;
+
+    // Web Mercator tile corner and pixel size, with tile rows counted from the top
+    double pixelSize = 2.0 * kRMTileReprojectionMercatorExtent / (kRMTileReprojectionSideLength * exp2(zoom));
+    double left = -kRMTileReprojectionMercatorExtent + (double)x * kRMTileReprojectionSideLength * pixelSize;
+    double top = kRMTileReprojectionMercatorExtent - (double)y * kRMTileReprojectionSideLength * pixelSize;
+
+    // Start with the source zoom whose pixels are closest in size to the tile's
+    double sourcePixelSize = RMTileReprojectionPixelSize(reprojection, left, top, pixelSize);
+
+    if (sourcePixelSize == 0.0)
+        return false;
+
+    double sourceZoom = round(log2(sqrt(bounds.size.width * bounds.size.height) / (side * sourcePixelSize)));
+    short z = (short)fmax(reprojection->sourceMinZoom, fmin(reprojection->sourceMaxZoom, sourceZoom));
+
+    long tx0, ty0, tilesWide, tilesHigh;
+    double mosaicWidth, mosaicHeight;
+
+    for (;;)
+    {
+        double tiles = exp2(z);
+        double resolutionX = bounds.size.width / (side * tiles), resolutionY = bounds.size.height / (side * tiles);
+        double sourceLeft = bounds.origin.x, sourceTop = bounds.origin.y + bounds.size.height;
+        double minX = HUGE_VAL, minY = HUGE_VAL, maxX = -HUGE_VAL, maxY = -HUGE_VAL;
+
+        // Pixel centres in the source coordinate system, in one batch...
+        if (pj_warp_mesh(reprojection->mercator, reprojection->source, kRMTileReprojectionSideLength, kRMTileReprojectionSideLength, left + 0.5 * pixelSize, top - 0.5 * pixelSize, pixelSize, -pixelSize, kRMTileReprojectionTolerance * fmin(resolutionX, resolutionY), px, py) != 0)
+            return false;
+
+        // ...and then in source pixels of this zoom level
+        for (long i = 0; i < count; i++)
+        {
+            if (px[i] == HUGE_VAL)
+                continue;
+
+            px[i] = (px[i] - sourceLeft) / resolutionX - 0.5;
+            py[i] = (sourceTop - py[i]) / resolutionY - 0.5;
+
+            if (px[i] < minX) minX = px[i];
+            if (px[i] > maxX) maxX = px[i];
+            if (py[i] < minY) minY = py[i];
+            if (py[i] > maxY) maxY = py[i];
+        }
+
+        // The source tiles touched, including the right and bottom neighbours for bilinear resampling
+        tx0 = (long)fmax(0.0, floor(minX / side));
+        ty0 = (long)fmax(0.0, floor(minY / side));
+        tilesWide = (long)fmin(tiles - 1.0, floor((maxX + 1.0) / side)) - tx0 + 1;
+        tilesHigh = (long)fmin(tiles - 1.0, floor((maxY + 1.0) / side)) - ty0 + 1;
+
+        if (minX == HUGE_VAL || tilesWide <= 0 || tilesHigh <= 0)
+            return false;
+
+        if ((tilesWide <= kRMTileReprojectionMaxSourceTiles && tilesHigh <= kRMTileReprojectionMaxSourceTiles) || z == reprojection->sourceMinZoom)
+            break;
+
+        --z;
+    }
+
+    mosaicWidth = (double)tilesWide * side;
+    mosaicHeight = (double)tilesHigh * side;
+
+    size_t mosaicSize = (size_t)tilesWide * tilesHigh * side * side * 4;
+
+    if (mosaicSize > reprojection->mosaicCapacity)
+    {
+        free(reprojection->mosaic);
+        reprojection->mosaic = malloc(mosaicSize);
+        reprojection->mosaicCapacity = (reprojection->mosaic ? mosaicSize : 0);
+
+        if ( ! reprojection->mosaic)
+            return false;
+    }
+
+    // Work out which of the tiles in the rectangle are really needed, so that no more are fetched than need be
+    uint8_t *mosaic = reprojection->mosaic;
+    char *needed = calloc(tilesWide * tilesHigh, 1);
+    bool found = false;
+
+    if ( ! needed)
+        return false;
+
+    long stride = tilesWide * side, lastColumn = stride - 1, lastRow = tilesHigh * side - 1;
+    double tileScale = 1.0 / side;
+
+    for (long i = 0; i < count; i++)
+    {
+        px[i] -= (double)tx0 * side;
+        py[i] -= (double)ty0 * side;
+
+        if ( ! (px[i] >= -0.5 && px[i] <= mosaicWidth - 0.5 && py[i] >= -0.5 && py[i] <= mosaicHeight - 0.5))
+            continue;
+
+        // Columns and rows either side of the pixel centre, found by truncating as the centre is at least -0.5
+        long u0 = (long)(px[i] + 1.0) - 1, v0 = (long)(py[i] + 1.0) - 1;
+        long u1 = (u0 < lastColumn ? u0 + 1 : lastColumn), v1 = (v0 < lastRow ? v0 + 1 : lastRow);
+
+        if (u0 < 0) u0 = 0;
+        if (v0 < 0) v0 = 0;
+
+        // and the tiles they are in, where adding half keeps the scaled value clear of rounding down a tile
+        u0 = (long)((u0 + 0.5) * tileScale);
+        u1 = (long)((u1 + 0.5) * tileScale);
+        v0 = (long)((v0 + 0.5) * tileScale);
+        v1 = (long)((v1 + 0.5) * tileScale);
+
+        needed[v0 * tilesWide + u0] = needed[v0 * tilesWide + u1] = needed[v1 * tilesWide + u0] = needed[v1 * tilesWide + u1] = 1;
+    }
+
+    for (long v = 0; v < tilesHigh; v++)
+    {
+        for (long u = 0; u < tilesWide; u++)
+        {
+            const uint8_t *tile = (needed[v * tilesWide + u] ? sourceTile(context, (uint32_t)(tx0 + u), (uint32_t)(ty0 + v), z) : NULL);
+            size_t rowBytes = (size_t)side * 4, mosaicRowBytes = (size_t)tilesWide * rowBytes;
+            uint8_t *corner = mosaic + (size_t)v * side * mosaicRowBytes + (size_t)u * rowBytes;
+
+            for (uint32_t row = 0; row < side; row++)
+            {
+                if (tile)
+                    memcpy(corner + row * mosaicRowBytes, tile + row * rowBytes, rowBytes);
+                else
+                    memset(corner + row * mosaicRowBytes, 0, rowBytes);
+            }
+
+            found = found || tile;
+        }
+    }
+
+    free(needed);
+
+    if ( ! found)
+        return false;
+
+    // Sample the mosaic at every pixel centre
+    for (long i = 0; i < count; i++)
+    {
+        uint8_t *pixel = pixels + i * 4;
+
+        if ( ! (px[i] >= -0.5 && px[i] <= mosaicWidth - 0.5 && py[i] >= -0.5 && py[i] <= mosaicHeight - 0.5))
+        {
+            memset(pixel, 0, 4);
+        }
+        else if (resampling == RMTileResamplingNearest)
+        {
+            long u = (long)(px[i] + 0.5), v = (long)(py[i] + 0.5);
+
+            if (u > lastColumn) u = lastColumn;
+            if (v > lastRow) v = lastRow;
+
+            memcpy(pixel, mosaic + (v * stride + u) * 4, 4);
+        }
+        else
+        {
+            long u = (long)(px[i] + 1.0) - 1, v = (long)(py[i] + 1.0) - 1;
+            long u0 = (u > 0 ? u : 0), u1 = (u < lastColumn ? u + 1 : lastColumn);
+            long v0 = (v > 0 ? v : 0), v1 = (v < lastRow ? v + 1 : lastRow);
+
+            RMPixelBlend(pixel, mosaic + (v0 * stride + u0) * 4, mosaic + (v0 * stride + u1) * 4, mosaic + (v1 * stride + u0) * 4, mosaic + (v1 * stride + u1) * 4, (float)(px[i] - u), (float)(py[i] - v));
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,69 @@
+//
+//  RMTileReprojection.h
+//
+// Copyright (c) 2008-2013, Route-Me Contributors
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _RMTILEREPROJECTION_H_
+#define _RMTILEREPROJECTION_H_
+
+// Builds Web Mercator tiles out of the tiles of a pyramid in some other PROJ.4 coordinate system, such as a
+// national grid. This is plain C on top of PROJ.4 and raw RGBA buffers, so that it can be used (and tested)
+// away from UIKit. RMReprojectedTileSource wraps it as a tile source.
+//
+// The source pyramid is laid out the way RMFractalTileProjection lays out tiles: the single tile at zoom 0
+// covers #sourceBounds, each zoom level splits every tile in four, and tile rows are counted from the top.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "RMFoundation.h"
+
+// Side length of the Web Mercator tiles built, in pixels
+#define kRMTileReprojectionSideLength 256
+
+typedef enum {
+    RMTileResamplingNearest = 0,
+    RMTileResamplingBilinear
+} RMTileResampling;
+
+// Returns the RGBA pixels of source tile #x, #y at #zoom, rows top to bottom, #sourceTileSideLength squared
+// pixels of four bytes each, or NULL if there is no such tile. The pixels are copied before the next call,
+// so the buffer can be reused. Use premultiplied alpha if the tiles are not opaque, so that bilinear
+// resampling blends them correctly.
+typedef const uint8_t *(*RMTileReprojectionSourceTileFunction)(void *context, uint32_t x, uint32_t y, short zoom);
+
+typedef struct RMTileReprojection RMTileReprojection;
+
+// Returns NULL if #sourceDefinition is not a valid PROJ.4 definition. A reprojection has its own PROJ.4
+// context and can be used from any thread, but only from one thread at a time.
+RMTileReprojection *RMTileReprojectionCreate(const char *sourceDefinition, RMProjectedRect sourceBounds, uint32_t sourceTileSideLength, short sourceMinZoom, short sourceMaxZoom);
+void RMTileReprojectionFree(RMTileReprojection *reprojection);
+
+// Fills #pixels, kRMTileReprojectionSideLength squared RGBA pixels, with Web Mercator tile #x, #y at #zoom.
+// Pixels outside the source pyramid are transparent. Returns false, leaving #pixels alone, if no source tile
+// covers any of the tile.
+bool RMTileReprojectionRenderTile(RMTileReprojection *reprojection, uint32_t x, uint32_t y, short zoom, RMTileResampling resampling, RMTileReprojectionSourceTileFunction sourceTile, void *context, uint8_t *pixels);
+
+#endif
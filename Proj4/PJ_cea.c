@@ -42,8 +42,8 @@ FREEUP;
 ENTRY1(cea, apa)
 	double t;
 
-	if (pj_param(P->params, "tlat_ts").i &&
-		(P->k0 = cos(t = pj_param(P->params, "rlat_ts").f)) < 0.) E_ERROR(-24)
+	if (pj_param(P->ctx, P->params, "tlat_ts").i &&
+		(P->k0 = cos(t = pj_param(P->ctx, P->params, "rlat_ts").f)) < 0.) E_ERROR(-24)
 	else
 		t = 0.;
 	if (P->es) {
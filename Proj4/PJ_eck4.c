@@ -35,9 +35,9 @@ FORWARD(s_forward); /* spheroid */
 INVERSE(s_inverse); /* spheroid */
 	double c;
 
-	lp.phi = aasin(xy.y / C_y);
+	lp.phi = aasin(P->ctx,xy.y / C_y);
 	lp.lam = xy.x / (C_x * (1. + (c = cos(lp.phi))));
-	lp.phi = aasin((lp.phi + sin(lp.phi) * (c + 2.)) / C_p);
+	lp.phi = aasin(P->ctx,(lp.phi + sin(lp.phi) * (c + 2.)) / C_p);
 	return (lp);
 }
 FREEUP; if (P) pj_dalloc(P); }
@@ -26,9 +26,9 @@ FREEUP; if (P) pj_dalloc(P); }
 ENTRY0(lagrng)
 	double phi1;
 
-	if ((P->rw = pj_param(P->params, "dW").f) <= 0) E_ERROR(-27);
+	if ((P->rw = pj_param(P->ctx, P->params, "dW").f) <= 0) E_ERROR(-27);
 	P->hrw = 0.5 * (P->rw = 1. / P->rw);
-	phi1 = pj_param(P->params, "rlat_1").f;
+	phi1 = pj_param(P->ctx, P->params, "rlat_1").f;
 	if (fabs(fabs(phi1 = sin(phi1)) - 1.) < TOL) E_ERROR(-22);
 	P->a1 = pow((1. - phi1)/(1. + phi1), P->hrw);
 	P->es = 0.; P->fwd = s_forward;
@@ -7,9 +7,11 @@
 	int		ellips;
 #define PJ_LIB__
 #include	<projects.h>
+#include	<errno.h>
 PROJ_HEAD(lcc, "Lambert Conformal Conic")
 	"\n\tConic, Sph&Ell\n\tlat_1= and lat_2= or lat_0";
 # define EPS10	1.e-10
+# define BLOCK	256
 FORWARD(e_forward); /* ellipsoid & spheroid */
         double rho;
 	if (fabs(fabs(lp.phi) - HALFPI) < EPS10) {
@@ -34,7 +36,7 @@ INVERSE(e_inverse); /* ellipsoid & spheroid */
 			xy.y = -xy.y;
 		}
 		if (P->ellips) {
-			if ((lp.phi = pj_phi2(pow(rho / P->c, 1./P->n), P->e))
+			if ((lp.phi = pj_phi2(P->ctx, pow(rho / P->c, 1./P->n), P->e))
 				== HUGE_VAL)
 				I_ERROR;
 		} else
@@ -46,6 +48,98 @@ INVERSE(e_inverse); /* ellipsoid & spheroid */
 	}
 	return (lp);
 }
+/*
+** Batch versions of the above, working through the points BLOCK at a
+** time so the ellipsoid cases can hand pj_tsfn_n() and pj_phi2_n() a
+** contiguous buffer.  Results are those of the scalar versions.
+*/
+FORWARD_N(e_forward_n); /* ellipsoid & spheroid */
+	double ts[BLOCK], rho, lam;
+	long b;
+	int j, m;
+
+	for (b = 0; b < n; b += BLOCK) {
+		m = n - b < BLOCK ? (int)(n - b) : BLOCK;
+		if (P->ellips) {
+			for (j = 0; j < m; ++j)
+				ts[j] = x[(b + j) * stride] == HUGE_VAL ? HUGE_VAL :
+					y[(b + j) * stride];
+			pj_tsfn_n(m, 1, ts, P->e);
+		}
+		for (j = 0; j < m; ++j) {
+			double *xx, *yy;
+
+			i = b + j;
+			xx = x + i * stride;
+			yy = y + i * stride;
+			if (*xx == HUGE_VAL) { *yy = HUGE_VAL; continue; }
+			if (fabs(fabs(*yy) - HALFPI) < EPS10) {
+				if ((*yy * P->n) <= 0.) N_ERROR(-20);
+				rho = 0.;
+			} else {
+				rho = P->ellips ? pow(ts[j], P->n) :
+					pow(tan(FORTPI + .5 * *yy), -P->n);
+				if (rho == 0. || rho == HUGE_VAL) N_ERROR(ERANGE);
+				rho *= P->c;
+			}
+			lam = *xx * P->n;
+			*xx = P->k0 * (rho * sin( lam ) );
+			*yy = P->k0 * (P->rho0 - rho * cos(lam) );
+		}
+	}
+	if (n_err) pj_ctx_set_errno(P->ctx, n_err);
+}
+INVERSE_N(e_inverse_n); /* ellipsoid & spheroid */
+	double ts[BLOCK], rho;
+	char pending[BLOCK];
+	long b;
+	int j, m;
+
+	for (b = 0; b < n; b += BLOCK) {
+		m = n - b < BLOCK ? (int)(n - b) : BLOCK;
+		for (j = 0; j < m; ++j) {
+			double *xx, *yy;
+
+			i = b + j;
+			xx = x + i * stride;
+			yy = y + i * stride;
+			pending[j] = 0;
+			ts[j] = HUGE_VAL;
+			if (*xx == HUGE_VAL) { *yy = HUGE_VAL; continue; }
+			*xx /= P->k0;
+			*yy /= P->k0;
+			if( (rho = hypot(*xx, *yy = P->rho0 - *yy)) != 0.0) {
+				if (P->n < 0.) {
+					rho = -rho;
+					*xx = -*xx;
+					*yy = -*yy;
+				}
+				*xx = atan2(*xx, *yy) / P->n;
+				ts[j] = P->ellips ? pow(rho / P->c, 1./P->n) :
+					pow(P->c / rho, 1./P->n);
+				if (ts[j] == 0. || ts[j] == HUGE_VAL) N_ERROR(ERANGE);
+				if (P->ellips)
+					pending[j] = 1;
+				else
+					*yy = 2. * atan(ts[j]) - HALFPI;
+			} else {
+				*xx = 0.;
+				*yy = P->n > 0. ? HALFPI : - HALFPI;
+			}
+		}
+		if (P->ellips) {
+			pj_phi2_n(P->ctx, m, 1, ts, P->e);
+			for (j = 0; j < m; ++j) {
+				if (!pending[j])
+					continue;
+				i = b + j;
+				if (ts[j] == HUGE_VAL) N_ERROR(-18);
+				y[i * stride] = ts[j];
+			}
+		}
+	}
+	if (n_err) pj_ctx_set_errno(P->ctx, n_err);
+}
 SPECIAL(fac) {
         double rho;
 	if (fabs(fabs(lp.phi) - HALFPI) < EPS10) {
@@ -64,12 +158,12 @@ ENTRY0(lcc)
 	double cosphi, sinphi;
 	int secant;
 
-	P->phi1 = pj_param(P->params, "rlat_1").f;
-	if (pj_param(P->params, "tlat_2").i)
-		P->phi2 = pj_param(P->params, "rlat_2").f;
+	P->phi1 = pj_param(P->ctx, P->params, "rlat_1").f;
+	if (pj_param(P->ctx, P->params, "tlat_2").i)
+		P->phi2 = pj_param(P->ctx, P->params, "rlat_2").f;
 	else {
 		P->phi2 = P->phi1;
-		if (!pj_param(P->params, "tlat_0").i)
+		if (!pj_param(P->ctx, P->params, "tlat_0").i)
 			P->phi0 = P->phi1;
 	}
 	if (fabs(P->phi1 + P->phi2) < EPS10) E_ERROR(-21);
@@ -101,5 +195,7 @@ ENTRY0(lcc)
 	}
 	P->inv = e_inverse;
 	P->fwd = e_forward;
+	P->inv_n = e_inverse_n;
+	P->fwd_n = e_forward_n;
 	P->spc = fac;
 ENDENTRY(P)
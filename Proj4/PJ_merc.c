@@ -1,5 +1,6 @@
 #define PJ_LIB__
 #include	<projects.h>
+#include	<errno.h>
 PROJ_HEAD(merc, "Mercator") "\n\tCyl, Sph&Ell\n\tlat_ts=";
 #define EPS10 1.e-10
 FORWARD(e_forward); /* ellipsoid */
@@ -15,7 +16,7 @@ FORWARD(s_forward); /* spheroid */
 	return (xy);
 }
 INVERSE(e_inverse); /* ellipsoid */
-	if ((lp.phi = pj_phi2(exp(- xy.y / P->k0), P->e)) == HUGE_VAL) I_ERROR;
+	if ((lp.phi = pj_phi2(P->ctx, exp(- xy.y / P->k0), P->e)) == HUGE_VAL) I_ERROR;
 	lp.lam = xy.x / P->k0;
 	return (lp);
 }
@@ -24,13 +25,88 @@ INVERSE(s_inverse); /* spheroid */
 	lp.lam = xy.x / P->k0;
 	return (lp);
 }
+/*
+** Batch versions of the above.  They evaluate exactly the same
+** expressions, so results are bit for bit those of the scalar path.
+** Domain and range errors that libm would report through errno for
+** log() and exp() are checked explicitly instead, as errno is not
+** inspected per point.
+*/
+FORWARD_N(e_forward_n); /* ellipsoid */
+	double k0 = P->k0;
+
+	for (i = 0; i < n; ++i) {
+		double *lam = x + i * stride, *phi = y + i * stride;
+
+		if (*lam == HUGE_VAL) { *phi = HUGE_VAL; continue; }
+		if (fabs(fabs(*phi) - HALFPI) <= EPS10) N_ERROR(-20);
+	}
+	pj_tsfn_n(n, stride, y, P->e);
+	for (i = 0; i < n; ++i) {
+		double *lam = x + i * stride, *ts = y + i * stride;
+
+		if (*lam == HUGE_VAL) continue;
+		if (!(*ts > 0.)) N_ERROR(EDOM);
+		*lam = k0 * *lam;
+		*ts = - k0 * log(*ts);
+	}
+	if (n_err) pj_ctx_set_errno(P->ctx, n_err);
+}
+FORWARD_N(s_forward_n); /* spheroid */
+	double k0 = P->k0, ts;
+
+	for (i = 0; i < n; ++i) {
+		double *lam = x + i * stride, *phi = y + i * stride;
+
+		if (*lam == HUGE_VAL) { *phi = HUGE_VAL; continue; }
+		if (fabs(fabs(*phi) - HALFPI) <= EPS10) N_ERROR(-20);
+		ts = tan(FORTPI + .5 * *phi);
+		if (!(ts > 0.)) N_ERROR(EDOM);
+		*lam = k0 * *lam;
+		*phi = k0 * log(ts);
+	}
+	if (n_err) pj_ctx_set_errno(P->ctx, n_err);
+}
+INVERSE_N(e_inverse_n); /* ellipsoid */
+	double k0 = P->k0;
+
+	for (i = 0; i < n; ++i) {
+		double *xx = x + i * stride, *yy = y + i * stride;
+
+		if (*xx == HUGE_VAL) { *yy = HUGE_VAL; continue; }
+		*yy = exp(- *yy / k0);
+		if (*yy == 0. || *yy == HUGE_VAL) N_ERROR(ERANGE);
+		*xx = *xx / k0;
+	}
+	pj_phi2_n(P->ctx, n, stride, y, P->e);
+	if (P->ctx->last_errno) {
+		n_err = P->ctx->last_errno;
+		for (i = 0; i < n; ++i)
+			if (y[i * stride] == HUGE_VAL) x[i * stride] = HUGE_VAL;
+	}
+	if (n_err) pj_ctx_set_errno(P->ctx, n_err);
+}
+INVERSE_N(s_inverse_n); /* spheroid */
+	double k0 = P->k0, ts;
+
+	for (i = 0; i < n; ++i) {
+		double *xx = x + i * stride, *yy = y + i * stride;
+
+		if (*xx == HUGE_VAL) { *yy = HUGE_VAL; continue; }
+		ts = exp(- *yy / k0);
+		if (ts == 0. || ts == HUGE_VAL) N_ERROR(ERANGE);
+		*yy = HALFPI - 2. * atan(ts);
+		*xx = *xx / k0;
+	}
+	if (n_err) pj_ctx_set_errno(P->ctx, n_err);
+}
 FREEUP; if (P) pj_dalloc(P); }
 ENTRY0(merc)
 	double phits=0.0;
 	int is_phits;
 
-	if( (is_phits = pj_param(P->params, "tlat_ts").i) ) {
-		phits = fabs(pj_param(P->params, "rlat_ts").f);
+	if( (is_phits = pj_param(P->ctx, P->params, "tlat_ts").i) ) {
+		phits = fabs(pj_param(P->ctx, P->params, "rlat_ts").f);
 		if (phits >= HALFPI) E_ERROR(-24);
 	}
 	if (P->es) { /* ellipsoid */
@@ -38,10 +114,14 @@ ENTRY0(merc)
 			P->k0 = pj_msfn(sin(phits), cos(phits), P->es);
 		P->inv = e_inverse;
 		P->fwd = e_forward;
+		P->inv_n = e_inverse_n;
+		P->fwd_n = e_forward_n;
 	} else { /* sphere */
 		if (is_phits)
 			P->k0 = cos(phits);
 		P->inv = s_inverse;
 		P->fwd = s_forward;
+		P->inv_n = s_inverse_n;
+		P->fwd_n = s_forward_n;
 	}
 ENDENTRY(P)
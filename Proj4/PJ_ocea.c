@@ -41,16 +41,16 @@ ENTRY0(ocea)
 
 	P->rok = P->a / P->k0;
 	P->rtk = P->a * P->k0;
-	if ( pj_param(P->params, "talpha").i) {
-		alpha	= pj_param(P->params, "ralpha").f;
-		lonz = pj_param(P->params, "rlonc").f;
+	if ( pj_param(P->ctx, P->params, "talpha").i) {
+		alpha	= pj_param(P->ctx, P->params, "ralpha").f;
+		lonz = pj_param(P->ctx, P->params, "rlonc").f;
 		P->singam = atan(-cos(alpha)/(-sin(phi_0) * sin(alpha))) + lonz;
 		P->sinphi = asin(cos(phi_0) * sin(alpha));
 	} else {
-		phi_1 = pj_param(P->params, "rlat_1").f;
-		phi_2 = pj_param(P->params, "rlat_2").f;
-		lam_1 = pj_param(P->params, "rlon_1").f;
-		lam_2 = pj_param(P->params, "rlon_2").f;
+		phi_1 = pj_param(P->ctx, P->params, "rlat_1").f;
+		phi_2 = pj_param(P->ctx, P->params, "rlat_2").f;
+		lam_1 = pj_param(P->ctx, P->params, "rlon_1").f;
+		lam_2 = pj_param(P->ctx, P->params, "rlon_2").f;
 		P->singam = atan2(cos(phi_1) * sin(phi_2) * cos(lam_1) -
 			sin(phi_1) * cos(phi_2) * cos(lam_2),
 			sin(phi_1) * cos(phi_2) * sin(lam_2) -
@@ -5,18 +5,18 @@
 PROJ_HEAD(putp4p, "Putnins P4'") "\n\tPCyl., Sph.";
 PROJ_HEAD(weren, "Werenskiold I") "\n\tPCyl., Sph.";
 FORWARD(s_forward); /* spheroid */
-	lp.phi = aasin(0.883883476 * sin(lp.phi));
+	lp.phi = aasin(P->ctx,0.883883476 * sin(lp.phi));
 	xy.x = P->C_x * lp.lam * cos(lp.phi);
 	xy.x /= cos(lp.phi *= 0.333333333333333);
 	xy.y = P->C_y * sin(lp.phi);
 	return (xy);
 }
 INVERSE(s_inverse); /* spheroid */
-	lp.phi = aasin(xy.y / P->C_y);
+	lp.phi = aasin(P->ctx,xy.y / P->C_y);
 	lp.lam = xy.x * cos(lp.phi) / P->C_x;
 	lp.phi *= 3.;
 	lp.lam /= cos(lp.phi);
-	lp.phi = aasin(1.13137085 * sin(lp.phi));
+	lp.phi = aasin(P->ctx,1.13137085 * sin(lp.phi));
 	return (lp);
 }
 FREEUP; if (P) pj_dalloc(P); }
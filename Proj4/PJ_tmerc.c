@@ -4,10 +4,12 @@
 	double	*en;
 #define PJ_LIB__
 #include	<projects.h>
+#include	<errno.h>
 PROJ_HEAD(tmerc, "Transverse Mercator") "\n\tCyl, Sph&Ell";
 PROJ_HEAD(utm, "Universal Transverse Mercator (UTM)")
 	"\n\tCyl, Sph\n\tzone= south";
 #define EPS10	1.e-10
+#define EPS12	1.e-12
 #define aks0	P->esp
 #define aks5	P->ml0
 #define FC1 1.
@@ -32,7 +34,7 @@ FORWARD(e_forward); /* ellipse */
         {
             xy.x = HUGE_VAL;
             xy.y = HUGE_VAL;
-            pj_errno = -14;
+            pj_ctx_set_errno( P->ctx, -14 );
             return xy;
         }
 
@@ -70,7 +72,7 @@ FORWARD(s_forward); /* sphere */
         {
             xy.x = HUGE_VAL;
             xy.y = HUGE_VAL;
-            pj_errno = -14;
+            pj_ctx_set_errno( P->ctx, -14 );
             return xy;
         }
 
@@ -89,7 +91,7 @@ FORWARD(s_forward); /* sphere */
 INVERSE(e_inverse); /* ellipsoid */
 	double n, con, cosphi, d, ds, sinphi, t;
 
-	lp.phi = pj_inv_mlfn(P->ml0 + xy.y / P->k0, P->es, P->en);
+	lp.phi = pj_inv_mlfn(P->ctx, P->ml0 + xy.y / P->k0, P->es, P->en);
 	if (fabs(lp.phi) >= HALFPI) {
 		lp.phi = xy.y < 0. ? -HALFPI : HALFPI;
 		lp.lam = 0.;
@@ -127,6 +129,77 @@ INVERSE(s_inverse); /* sphere */
 	lp.lam = (g || h) ? atan2(g, h) : 0.;
 	return (lp);
 }
+/*
+** Batch versions.  The series above are evaluated per point exactly as
+** pj_fwd()/pj_inv() would, including their check of errno, but without
+** the per point call overhead of pj_fwd()/pj_inv() themselves.
+*/
+	static void
+fwd_n(PJ *P, long n, int stride, double *x, double *y, XY (*fwd)(LP, PJ *)) {
+	LP lp;
+	XY xy;
+	long i;
+	int n_err = 0;
+
+	for (i = 0; i < n; ++i) {
+		if (x[i * stride] == HUGE_VAL) { y[i * stride] = HUGE_VAL; continue; }
+		lp.lam = x[i * stride];
+		lp.phi = y[i * stride];
+		errno = 0;
+		xy = (*fwd)(lp, P);
+		if (P->ctx->last_errno == 0 && errno != 0)
+			pj_ctx_set_errno(P->ctx, errno);
+		if (P->ctx->last_errno) {
+			int err = P->ctx->last_errno;
+			pj_ctx_set_errno(P->ctx, 0);
+			N_ERROR(err);
+		}
+		x[i * stride] = xy.x;
+		y[i * stride] = xy.y;
+	}
+	if (n_err) pj_ctx_set_errno(P->ctx, n_err);
+}
+	static void
+inv_n(PJ *P, long n, int stride, double *x, double *y, LP (*inv)(XY, PJ *)) {
+	LP lp;
+	XY xy;
+	long i;
+	int n_err = 0;
+
+	for (i = 0; i < n; ++i) {
+		if (x[i * stride] == HUGE_VAL) { y[i * stride] = HUGE_VAL; continue; }
+		xy.x = x[i * stride];
+		xy.y = y[i * stride];
+		errno = 0;
+		lp = (*inv)(xy, P);
+		if (P->ctx->last_errno == 0 && errno != 0)
+			pj_ctx_set_errno(P->ctx, errno);
+		if (P->ctx->last_errno) {
+			int err = P->ctx->last_errno;
+			pj_ctx_set_errno(P->ctx, 0);
+			N_ERROR(err);
+		}
+		x[i * stride] = lp.lam;
+		y[i * stride] = lp.phi;
+	}
+	if (n_err) pj_ctx_set_errno(P->ctx, n_err);
+}
+	static void /* ellipse */
+e_forward_n(PJ *P, long n, int stride, double *x, double *y) {
+	fwd_n(P, n, stride, x, y, e_forward);
+}
+	static void /* sphere */
+s_forward_n(PJ *P, long n, int stride, double *x, double *y) {
+	fwd_n(P, n, stride, x, y, s_forward);
+}
+	static void /* ellipsoid */
+e_inverse_n(PJ *P, long n, int stride, double *x, double *y) {
+	inv_n(P, n, stride, x, y, e_inverse);
+}
+	static void /* sphere */
+s_inverse_n(PJ *P, long n, int stride, double *x, double *y) {
+	inv_n(P, n, stride, x, y, s_inverse);
+}
 FREEUP;
 	if (P) {
 		if (P->en)
@@ -143,11 +216,15 @@ setup(PJ *P) { /* general initialization */
 		P->esp = P->es / (1. - P->es);
 		P->inv = e_inverse;
 		P->fwd = e_forward;
+		P->inv_n = e_inverse_n;
+		P->fwd_n = e_forward_n;
 	} else {
 		aks0 = P->k0;
 		aks5 = .5 * aks0;
 		P->inv = s_inverse;
 		P->fwd = s_forward;
+		P->inv_n = s_inverse_n;
+		P->fwd_n = s_forward_n;
 	}
 	return P;
 }
@@ -157,10 +234,10 @@ ENTRY1(utm, en)
 	int zone;
 
 	if (!P->es) E_ERROR(-34);
-	P->y0 = pj_param(P->params, "bsouth").i ? 10000000. : 0.;
+	P->y0 = pj_param(P->ctx, P->params, "bsouth").i ? 10000000. : 0.;
 	P->x0 = 500000.;
-	if (pj_param(P->params, "tzone").i) /* zone input ? */
-		if ((zone = pj_param(P->params, "izone").i) > 0 && zone <= 60)
+	if (pj_param(P->ctx, P->params, "tzone").i) /* zone input ? */
+		if ((zone = pj_param(P->ctx, P->params, "izone").i) > 0 && zone <= 60)
 			--zone;
 		else
 			E_ERROR(-35)
@@ -173,3 +250,108 @@ ENTRY1(utm, en)
 	P->k0 = 0.9996;
 	P->phi0 = 0.;
 ENDENTRY(setup(P))
+/*
+** UTM projection of n points spread over any number of zones.  zone[i]
+** is the zone of point i, 1 to 60, negated for the southern hemisphere.
+** P must be a +proj=utm definition; its ellipsoid and units are used,
+** its own zone is not.  The zones share the series coefficients of P,
+** so only the central meridian and false northing vary per point.
+** Results are those of pj_fwd_array()/pj_inv_array() with a utm
+** definition for each zone.
+*/
+#define UTM_SOUTH	10000000.
+	static int
+utm_zone(int zone, double *lam0, double *y0) {
+	if (zone < -60 || zone > 60 || zone == 0)
+		return 0;
+	*y0 = zone < 0 ? UTM_SOUTH : 0.;
+	*lam0 = ((zone < 0 ? -zone : zone) - 1 + .5) * PI / 30. - PI;
+	return 1;
+}
+	int
+pj_utm_fwd_array(PJ *P, long n, int stride, const int *zone,
+		double *x, double *y) {
+	double *lam, *phi, t, lam0, y0;
+	long i;
+	int err = 0;
+
+	if (P->descr != des_utm) {
+		pj_ctx_set_errno(P->ctx, -35);
+		return -35;
+	}
+	for (i = 0, lam = x, phi = y; i < n; ++i, lam += stride, phi += stride) {
+		if (*lam == HUGE_VAL) {
+			*phi = HUGE_VAL;
+			continue;
+		}
+		if (!utm_zone(zone[i], &lam0, &y0)) {
+			*lam = *phi = HUGE_VAL;
+			err = -35;
+			continue;
+		}
+		if ((t = fabs(*phi)-HALFPI) > EPS12 || fabs(*lam) > 10.) {
+			*lam = *phi = HUGE_VAL;
+			err = -14;
+			continue;
+		}
+		if (fabs(t) <= EPS12)
+			*phi = *phi < 0. ? -HALFPI : HALFPI;
+		else if (P->geoc)
+			*phi = atan(P->rone_es * tan(*phi));
+		*lam -= lam0;
+		if (!P->over)
+			*lam = adjlon(*lam);
+	}
+	pj_ctx_set_errno(P->ctx, 0);
+	(*P->fwd_n)(P, n, stride, x, y);
+	if (P->ctx->last_errno)
+		err = P->ctx->last_errno;
+	for (i = 0, lam = x, phi = y; i < n; ++i, lam += stride, phi += stride) {
+		if (*lam == HUGE_VAL || !utm_zone(zone[i], &lam0, &y0))
+			continue;
+		*lam = P->fr_meter * (P->a * *lam + P->x0);
+		*phi = P->fr_meter * (P->a * *phi + y0);
+	}
+	pj_ctx_set_errno(P->ctx, err);
+	return err;
+}
+	int
+pj_utm_inv_array(PJ *P, long n, int stride, const int *zone,
+		double *x, double *y) {
+	double *xx, *yy, lam0, y0;
+	long i;
+	int err = 0;
+
+	if (P->descr != des_utm) {
+		pj_ctx_set_errno(P->ctx, -35);
+		return -35;
+	}
+	for (i = 0, xx = x, yy = y; i < n; ++i, xx += stride, yy += stride) {
+		if (*xx == HUGE_VAL || *yy == HUGE_VAL) {
+			*xx = *yy = HUGE_VAL;
+			continue;
+		}
+		if (!utm_zone(zone[i], &lam0, &y0)) {
+			*xx = *yy = HUGE_VAL;
+			err = -35;
+			continue;
+		}
+		*xx = (*xx * P->to_meter - P->x0) * P->ra;
+		*yy = (*yy * P->to_meter - y0) * P->ra;
+	}
+	pj_ctx_set_errno(P->ctx, 0);
+	(*P->inv_n)(P, n, stride, x, y);
+	if (P->ctx->last_errno)
+		err = P->ctx->last_errno;
+	for (i = 0, xx = x, yy = y; i < n; ++i, xx += stride, yy += stride) {
+		if (*xx == HUGE_VAL || !utm_zone(zone[i], &lam0, &y0))
+			continue;
+		*xx += lam0;
+		if (!P->over)
+			*xx = adjlon(*xx);
+		if (P->geoc && fabs(fabs(*yy)-HALFPI) > EPS12)
+			*yy = atan(P->one_es * tan(*yy));
+	}
+	pj_ctx_set_errno(P->ctx, err);
+	return err;
+}
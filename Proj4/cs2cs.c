@@ -36,44 +36,186 @@
 #include <math.h>
 #include "emess.h"
 
+#if defined(MSDOS) || defined(OS2) || defined(WIN32) || defined(__WIN32__)
+#  include <fcntl.h>
+#  include <io.h>
+#  define SET_BINARY_MODE(file) setmode(fileno(file), O_BINARY)
+#else
+#  include <unistd.h>
+#  define SET_BINARY_MODE(file)
+#endif
+
+#ifdef MUTEX_pthread
+#  include <pthread.h>
+#  define BLOCK_THREADS
+#endif
+
 #define MAX_LINE 1000
 #define MAX_PARGS 100
+#define MAX_BLOCKS 64		/* blocks in flight at once, -j */
+#define BLOCK_POINTS 65536	/* points transformed at once, binary input */
+#define BLOCK_LINES 1024	/* lines transformed at once, ascii input */
 
 static projPJ   fromProj, toProj;
 
 static int
 reversein = 0,	/* != 0 reverse input arguments */
 reverseout = 0,	/* != 0 reverse output arguments */
+bin_in = 0,	/* != 0 then binary input */
+bin_out = 0,	/* != 0 then binary output */
+dms_in = 0,	/* != 0 then DMS/degree input, else numbers */
 echoin = 0,	/* echo input data to output line */
-tag = '#';	/* beginning of line tag character */
+tag = '#',	/* beginning of line tag character */
+block_count = 1;	/* blocks worked on at once, -j */
 	static char
 *oform = (char *)0,	/* output format for x-y or decimal degrees */
 *oterr = "*\t*",	/* output line for unprojectable input */
 *usage =
-"%s\nusage: %s [ -eEfIlrstvwW [args] ] [ +opts[=arg] ]\n"
+"%s\nusage: %s [ -beEfiIjlorstvwW [args] ] [ +opts[=arg] ]\n"
 "                   [+to [+opts[=arg] [ files ]\n";
 
 static struct FACTORS facs;
-static double (*informat)(const char *, 
-                          char **); /* input data deformatter function */
 
+typedef struct {
+    char    line[MAX_LINE+3];
+    char    *rest;      /* what follows the coordinates, NULL if tag line */
+} INPUT_LINE;
+
+/*
+** One block of input on its way through: read by the main thread,
+** parsed, transformed and formatted by a worker, and written by the main
+** thread again, in order.  Every block has its own context and copies
+** of the coordinate systems, so blocks can be worked on at the same time.
+**
+** Binary input and output is x, y and z for each point as little endian
+** doubles, with angles in radians.
+*/
+typedef struct {
+    projCtx     ctx;
+    projPJ      from, to;
+    PJ_TRANSFORM_PLAN *plan;
+    INPUT_LINE  *lines;         /* BLOCK_LINES of ascii input */
+    double      *xyz, *xyz_in;  /* BLOCK_POINTS points, and a copy */
+    long        count;
+    char        *out;           /* formatted ascii output */
+    size_t      out_len, out_size;
+    int         running;
+#ifdef BLOCK_THREADS
+    pthread_t   thread;
+#endif
+} BLOCK;
+
+static BLOCK    blocks[MAX_BLOCKS];
 
 /************************************************************************/
-/*                              process()                               */
+/*                            init_block()                              */
 /*                                                                      */
-/*      File processing function.                                       */
+/*      The first block uses the coordinate systems from the command    */
+/*      line, the others get copies with a context of their own.        */
 /************************************************************************/
-static void process(FILE *fid) 
+static void init_block(BLOCK *b, int first) 
 
 {
-    char line[MAX_LINE+3], *s, pline[40];
-    projUV data;
+    if (first) {
+        b->ctx = pj_get_ctx(fromProj);
+        b->from = fromProj;
+        b->to = toProj;
+    } else {
+        if (!(b->ctx = pj_ctx_alloc()))
+            emess(2,"memory allocation failure");
+        if (!(b->from = pj_clone_ctx(b->ctx, fromProj))
+            || !(b->to = pj_clone_ctx(b->ctx, toProj)))
+            emess(3,"projection initialization failure\ncause: %s",
+                  pj_strerrno(pj_ctx_get_errno(b->ctx)));
+    }
 
-    for (;;) {
-        double z;
+    if (!(b->plan = pj_transform_plan_create(b->from, b->to)))
+        emess(3,"transformation initialization failure\ncause: %s",
+              pj_strerrno(pj_ctx_get_errno(b->ctx)));
+
+    b->lines = (INPUT_LINE *) malloc(sizeof(INPUT_LINE) * BLOCK_LINES);
+    b->xyz = (double *) malloc(sizeof(double) * 6 * BLOCK_POINTS);
+    b->out_size = 64 * BLOCK_LINES;
+    b->out = (char *) malloc(b->out_size);
+    if (b->lines == NULL || b->xyz == NULL || b->out == NULL)
+        emess(2,"memory allocation failure");
+    b->xyz_in = b->xyz + 3 * BLOCK_POINTS;
+}
+
+/************************************************************************/
+/*                            free_block()                              */
+/************************************************************************/
+static void free_block(BLOCK *b, int first) 
+
+{
+    pj_transform_plan_free( b->plan );
+    free( b->lines );
+    free( b->xyz );
+    free( b->out );
+
+    if (!first) {
+        pj_free( b->from );
+        pj_free( b->to );
+        pj_ctx_free( b->ctx );
+    }
+}
+
+/************************************************************************/
+/*                            swap_block()                              */
+/*                                                                      */
+/*      Swap the bytes of binary data on big endian hosts.              */
+/************************************************************************/
+static void swap_block(double *data, long count) 
+
+{
+    static const double one = 1.0;
+    unsigned char *b, t;
+    long i;
+    int j;
+
+    if (((const unsigned char *) &one)[0] != 0x3f)
+        return;
+
+    for (i = 0; i < count; i++) {
+        b = (unsigned char *) (data + i);
+        for (j = 0; j < 4; j++) {
+            t = b[j];
+            b[j] = b[7-j];
+            b[7-j] = t;
+        }
+    }
+}
+
+/************************************************************************/
+/*                            read_binary()                             */
+/************************************************************************/
+static long read_binary(BLOCK *b, FILE *fid) 
+
+{
+    long n;
+
+    n = (long) fread(b->xyz, 3 * sizeof(double), BLOCK_POINTS, fid);
+    swap_block(b->xyz, 3 * n);
+    emess_dat.File_line += n;
+
+    return n;
+}
+
+/************************************************************************/
+/*                             read_text()                              */
+/*                                                                      */
+/*      Read up to max_lines lines, which parse_text() takes apart.     */
+/************************************************************************/
+static long read_text(BLOCK *b, FILE *fid, long max_lines) 
+
+{
+    long n;
+
+    for (n = 0; n < max_lines; n++) {
+        char *s;
 
         ++emess_dat.File_line;
-        if (!(s = fgets(line, MAX_LINE, fid)))
+        if (!(s = fgets(b->lines[n].line, MAX_LINE, fid)))
             break;
         if (!strchr(s, '\n')) { /* overlong line */
             int c;
@@ -81,82 +223,315 @@ static void process(FILE *fid)
 				/* gobble up to newline */
             while ((c = fgetc(fid)) != EOF && c != '\n') ;
         }
+    }
+
+    return n;
+}
+
+/************************************************************************/
+/*                            parse_text()                              */
+/*                                                                      */
+/*      One point for each line.  Tag lines get a HUGE_VAL point,       */
+/*      which is left alone.                                            */
+/************************************************************************/
+static void parse_text(BLOCK *b) 
+
+{
+    long n;
+
+    for (n = 0; n < b->count; n++) {
+        INPUT_LINE *in = b->lines + n;
+        double *p = b->xyz + 3 * n;
+        char *s = in->line;
+
         if (*s == tag) {
-            fputs(line, stdout);
+            in->rest = NULL;
+            p[0] = p[1] = HUGE_VAL;
+            p[2] = 0.0;
             continue;
         }
 
-        if (reversein) {
-            data.v = (*informat)(s, &s);
-            data.u = (*informat)(s, &s);
+        if (dms_in) {
+            p[reversein] = dmstor_ctx(b->ctx, s, &s);
+            p[!reversein] = dmstor_ctx(b->ctx, s, &s);
         } else {
-            data.u = (*informat)(s, &s);
-            data.v = (*informat)(s, &s);
+            p[reversein] = pj_strtod(s, &s);
+            p[!reversein] = pj_strtod(s, &s);
         }
 
-        z = strtod( s, &s );
+        p[2] = pj_strtod( s, &s );
+
+        if (p[1] == HUGE_VAL)
+            p[0] = HUGE_VAL;
 
-        if (data.v == HUGE_VAL)
-            data.u = HUGE_VAL;
+        if (!*s && (s > in->line)) --s; /* assumed we gobbled \n */
 
-        if (!*s && (s > line)) --s; /* assumed we gobbled \n */
+        in->rest = s;
+    }
+}
 
-        if ( echoin) {
+/************************************************************************/
+/*                          transform_block()                           */
+/*                                                                      */
+/*      Transform a block of points in one go.  Any error, even one     */
+/*      that does not fail the whole call (a point off the grid, say),  */
+/*      is down to some point or other, so then go back and do them     */
+/*      one at a time.                                                  */
+/************************************************************************/
+static void transform_block(BLOCK *b) 
+
+{
+    double *xyz = b->xyz;
+    long i, n = b->count;
+
+    memcpy(b->xyz_in, xyz, sizeof(double) * 3 * n);
+    pj_ctx_set_errno(b->ctx, 0);
+    if (pj_transform_plan_execute(b->plan, n, 3, xyz, xyz + 1, xyz + 2) == 0
+        && pj_ctx_get_errno(b->ctx) == 0)
+        return;
+
+    memcpy(xyz, b->xyz_in, sizeof(double) * 3 * n);
+    for (i = 0; i < n; i++) {
+        double *p = xyz + 3 * i;
+
+        if (p[0] != HUGE_VAL
+            && pj_transform( b->from, b->to, 1, 0, p, p + 1, p + 2 ) != 0)
+        {
+            p[0] = HUGE_VAL;
+            p[1] = HUGE_VAL;
+        }
+    }
+}
+
+/************************************************************************/
+/*                 out_reserve(), out_puts(), out_value()               */
+/*                                                                      */
+/*      Append to the formatted output of a block.                      */
+/************************************************************************/
+static void out_reserve(BLOCK *b, size_t len) 
+
+{
+    if (b->out_len + len <= b->out_size)
+        return;
+
+    while (b->out_len + len > b->out_size)
+        b->out_size *= 2;
+    if (!(b->out = (char *) realloc(b->out, b->out_size)))
+        emess(2,"memory allocation failure");
+}
+
+static void out_puts(BLOCK *b, const char *s) 
+
+{
+    size_t len = strlen(s);
+
+    out_reserve(b, len);
+    memcpy(b->out + b->out_len, s, len);
+    b->out_len += len;
+}
+
+static void out_value(BLOCK *b, const char *format, double value) 
+
+{
+    int n, avail;
+
+    /* pj_format_double() does not say how much room it wants */
+    for (avail = 64; ; avail *= 2) {
+        out_reserve(b, avail);
+        n = pj_format_double(b->out + b->out_len, avail, format, value);
+        if (n >= 0 || avail > 65536)
+            break;
+    }
+
+    if (n > 0)
+        b->out_len += n;
+}
+
+/************************************************************************/
+/*                            write_binary()                            */
+/************************************************************************/
+static void write_binary(BLOCK *b) 
+
+{
+    double *xyz = b->xyz;
+    long i, count = 0;
+
+    if (bin_in)
+        count = b->count;
+    else /* drop tag lines */
+        for (i = 0; i < b->count; i++)
+            if (b->lines[i].rest) {
+                memmove(xyz + 3 * count, xyz + 3 * i, 3 * sizeof(double));
+                count++;
+            }
+
+    swap_block(xyz, 3 * count);
+    (void)fwrite(xyz, 3 * sizeof(double), count, stdout);
+}
+
+/************************************************************************/
+/*                             write_text()                             */
+/*                                                                      */
+/*      Format the block into its output buffer.                        */
+/************************************************************************/
+static void write_text(BLOCK *b) 
+
+{
+    char pline[40], *s;
+    projUV data;
+    double z;
+    long i;
+
+    b->out_len = 0;
+
+    for (i = 0; i < b->count; i++) {
+        s = bin_in ? "\n" : b->lines[i].rest;
+        if (!s) { /* tag line */
+            out_puts(b, b->lines[i].line);
+            continue;
+        }
+
+        if (!bin_in && echoin) {
             int t;
             t = *s;
             *s = '\0';
-            (void)fputs(line, stdout);
+            out_puts(b, b->lines[i].line);
             *s = t;
-            putchar('\t');
+            out_puts(b, "\t");
         }
 
-        if (data.u != HUGE_VAL) {
-            if( pj_transform( fromProj, toProj, 1, 0, 
-                              &(data.u), &(data.v), &z ) != 0 )
-            {
-                data.u = HUGE_VAL;
-                data.v = HUGE_VAL;
-            }
-        }
+        data.u = b->xyz[3*i];
+        data.v = b->xyz[3*i+1];
+        z = b->xyz[3*i+2];
 
         if (data.u == HUGE_VAL) /* error output */
-            fputs(oterr, stdout);
+            out_puts(b, oterr);
 
-        else if (pj_is_latlong(toProj) && !oform) {	/*ascii DMS output */
+        else if (pj_is_latlong(b->to) && !oform) {	/*ascii DMS output */
             if (reverseout) {
-                fputs(rtodms(pline, data.v, 'N', 'S'), stdout);
-                putchar('\t');
-                fputs(rtodms(pline, data.u, 'E', 'W'), stdout);
+                out_puts(b, rtodms(pline, data.v, 'N', 'S'));
+                out_puts(b, "\t");
+                out_puts(b, rtodms(pline, data.u, 'E', 'W'));
             } else {
-                fputs(rtodms(pline, data.u, 'E', 'W'), stdout);
-                putchar('\t');
-                fputs(rtodms(pline, data.v, 'N', 'S'), stdout);
+                out_puts(b, rtodms(pline, data.u, 'E', 'W'));
+                out_puts(b, "\t");
+                out_puts(b, rtodms(pline, data.v, 'N', 'S'));
             }
 
         } else {	/* x-y or decimal degree ascii output */
-            if ( pj_is_latlong(toProj) ) {
+            if ( pj_is_latlong(b->to) ) {
                 data.v *= RAD_TO_DEG;
                 data.u *= RAD_TO_DEG;
             }
             if (reverseout) {
-                printf(oform,data.v); putchar('\t');
-                printf(oform,data.u);
+                out_value(b, oform, data.v); out_puts(b, "\t");
+                out_value(b, oform, data.u);
             } else {
-                printf(oform,data.u); putchar('\t');
-                printf(oform,data.v);
+                out_value(b, oform, data.u); out_puts(b, "\t");
+                out_value(b, oform, data.v);
             }
         }
 
-        putchar(' ');
-        if( oform != NULL )
-            printf( oform, z );
-        else
-            printf( "%.3f", z );
-        if( s )
-            printf( "%s", s );
-        else
-            printf( "\n" );
+        out_puts(b, " ");
+        out_value(b, oform != NULL ? oform : "%.3f", z);
+        out_puts(b, s);
+    }
+}
+
+/************************************************************************/
+/*                             run_block()                              */
+/************************************************************************/
+static void run_block(BLOCK *b) 
+
+{
+    if (!bin_in)
+        parse_text(b);
+    transform_block(b);
+    if (!bin_out)
+        write_text(b);
+}
+
+#ifdef BLOCK_THREADS
+static void *block_thread(void *arg) 
+
+{
+    run_block((BLOCK *) arg);
+    return NULL;
+}
+#endif
+
+/************************************************************************/
+/*                     start_block(), finish_block()                    */
+/*                                                                      */
+/*      Hand a block that has been read to a worker thread, or run      */
+/*      it here if there is only the one, and later write it out.       */
+/************************************************************************/
+static void start_block(BLOCK *b, int threaded) 
+
+{
+#ifdef BLOCK_THREADS
+    if (threaded && pthread_create(&b->thread, NULL, block_thread, b) == 0) {
+        b->running = 1;
+        return;
     }
+#endif
+    run_block(b);
+}
+
+static void finish_block(BLOCK *b) 
+
+{
+#ifdef BLOCK_THREADS
+    if (b->running) {
+        pthread_join(b->thread, NULL);
+        b->running = 0;
+    }
+#endif
+    if (b->count == 0)
+        return;
+
+    if (bin_out)
+        write_binary(b);
+    else
+        (void)fwrite(b->out, 1, b->out_len, stdout);
+    b->count = 0;
+}
+
+/************************************************************************/
+/*                              process()                               */
+/*                                                                      */
+/*      File processing function.  Blocks are read in turn and up to    */
+/*      block_count of them are worked on at once, each written out     */
+/*      before its slot takes the next block, so output stays in        */
+/*      input order.                                                    */
+/************************************************************************/
+static void process(FILE *fid) 
+
+{
+    long size = bin_in ? BLOCK_POINTS : BLOCK_LINES;
+    int ring = block_count, k = 0, i;
+
+    /* answer each line at once when typed at */
+    if (!bin_in && isatty(fileno(fid))) {
+        size = 1;
+        ring = 1;
+    }
+
+    for (;;) {
+        BLOCK *b = blocks + k;
+
+        finish_block(b);
+        b->count = bin_in ? read_binary(b, fid) : read_text(b, fid, size);
+        if (b->count == 0)
+            break;
+        start_block(b, ring > 1);
+        k = (k + 1) % ring;
+        if (b->count < size)
+            break;
+    }
+
+    for (i = 0; i < ring; i++, k = (k + 1) % ring)
+        finish_block(blocks + k);
 }
 
 /************************************************************************/
@@ -186,9 +561,18 @@ int main(int argc, char **argv)
               case '\0': /* position of "stdin" */
                 if (arg[-1] == '-') eargv[eargc++] = "-";
                 break;
+              case 'b': /* binary I/O */
+                bin_in = bin_out = 1;
+                continue;
               case 'v': /* monitor dump of initialization */
                 mon = 1;
                 continue;
+              case 'i': /* input binary */
+                bin_in = 1;
+                continue;
+              case 'o': /* output binary */
+                bin_out = 1;
+                continue;
               case 'I': /* alt. method to spec inverse */
                 inverse = 1;
                 continue;
@@ -277,6 +661,12 @@ int main(int argc, char **argv)
                 if (--argc <= 0) goto noargument;
                 oform = *++argv;
                 continue;
+              case 'j': /* blocks worked on at once */
+                if (--argc <= 0) goto noargument;
+                block_count = atoi(*++argv);
+                if (block_count < 1 || block_count > MAX_BLOCKS)
+                    emess(1,"-j argument must be 1 to %d", MAX_BLOCKS);
+                continue;
               case 'r': /* reverse input */
                 reversein = 1;
                 continue;
@@ -378,23 +768,35 @@ int main(int argc, char **argv)
     }
 
     /* set input formating control */
-    if( !fromProj->is_latlong )
-        informat = strtod;
-    else {
-        informat = dmstor;
-    }
+    dms_in = fromProj->is_latlong;
 
     if( !toProj->is_latlong && !oform )
         oform = "%.2f";
 
+#ifndef BLOCK_THREADS
+    block_count = 1;
+#endif
+    for( i = 0; i < block_count; i++ )
+        init_block( blocks + i, i == 0 );
+
+    if (bin_out)
+    {
+        SET_BINARY_MODE(stdout);
+    }
+
     /* process input file list */
     for ( ; eargc-- ; ++eargv) {
         if (**eargv == '-') {
             fid = stdin;
             emess_dat.File_name = "<stdin>";
 
+            if (bin_in)
+            {
+                SET_BINARY_MODE(stdin);
+            }
+
         } else {
-            if ((fid = fopen(*eargv, "rt")) == NULL) {
+            if ((fid = fopen(*eargv, bin_in ? "rb" : "rt")) == NULL) {
                 emess(-2, *eargv, "input file");
                 continue;
             }
@@ -406,6 +808,9 @@ int main(int argc, char **argv)
         emess_dat.File_name = 0;
     }
 
+    for( i = 0; i < block_count; i++ )
+        free_block( blocks + i, i == 0 );
+
     if( fromProj != NULL )
         pj_free( fromProj );
     if( toProj != NULL )
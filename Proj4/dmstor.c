@@ -3,8 +3,6 @@
 #include <string.h>
 #include <ctype.h>
 
-static double proj_strtod(char *nptr, char **endptr);
-
 /* following should be sufficient for all but the rediculous */
 #define MAX_WORK 64
 	static const char
@@ -17,6 +15,11 @@ vm[] = {
 };
 	double
 dmstor(const char *is, char **rs) {
+	return dmstor_ctx( pj_get_default_ctx(), is, rs );
+}
+
+	double
+dmstor_ctx(projCtx ctx, const char *is, char **rs) {
 	int sign, n, nl;
 	char *p, *s, work[MAX_WORK];
 	double v, tv;
@@ -35,7 +38,7 @@ dmstor(const char *is, char **rs) {
 	else sign = '+';
 	for (v = 0., nl = 0 ; nl < 3 ; nl = n + 1 ) {
 		if (!(isdigit(*s) || *s == '.')) break;
-		if ((tv = proj_strtod(s, &s)) == HUGE_VAL)
+		if ((tv = pj_strtod(s, &s)) == HUGE_VAL)
 			return tv;
 		switch (*s) {
 		case 'D': case 'd':
@@ -46,7 +49,7 @@ dmstor(const char *is, char **rs) {
 			n = 2; break;
 		case 'r': case 'R':
 			if (nl) {
-				pj_errno = -16;
+				pj_ctx_set_errno( ctx, -16 );
 				return HUGE_VAL;
 			}
 			++s;
@@ -58,7 +61,7 @@ dmstor(const char *is, char **rs) {
 			continue;
 		}
 		if (n < nl) {
-			pj_errno = -16;
+			pj_ctx_set_errno( ctx, -16 );
 			return HUGE_VAL;
 		}
 		v += tv * vm[n];
@@ -75,34 +78,3 @@ dmstor(const char *is, char **rs) {
 		*rs = (char *)is + (s - work);
 	return v;
 }
-
-static double
-proj_strtod(char *nptr, char **endptr) 
-
-{
-    char c, *cp = nptr;
-    double result;
-
-    /*
-     * Scan for characters which cause problems with VC++ strtod()
-     */
-    while ((c = *cp) != '\0') {
-        if (c == 'd' || c == 'D') {
-
-            /*
-             * Found one, so NUL it out, call strtod(),
-             * then restore it and return
-             */
-            *cp = '\0';
-            result = strtod(nptr, endptr);
-            *cp = c;
-            return result;
-        }
-        ++cp;
-    }
-
-    /* no offending characters, just handle normally */
-
-    return strtod(nptr, endptr);
-}
-
@@ -36,6 +36,9 @@
  *    An Improved Algorithm for Geocentric to Geodetic Coordinate Conversion,
  *    Ralph Toms, February 1996  UCRL-JC-123138.
  *    
+ *    Computing geodetic coordinates from geocentric coordinates,
+ *    H. Vermeille, Journal of Geodesy (2004) 78: 94-95.
+ *    
  *    Further information on GEOCENTRIC can be found in the Reuse Manual.
  *
  *    GEOCENTRIC originated from : U.S. Army Topographic Engineering Center
@@ -89,6 +92,11 @@
 #define TRUE       1
 #define COS_67P5   0.38268343236508977  /* cosine of 67.5 degrees */
 #define AD_C       1.0026000            /* Toms region 1 constant */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#  define CBRT(x)  cbrt(x)
+#else
+#  define CBRT(x)  pow((x), 1.0 / 3.0)
+#endif
 
 
 /***************************************************************************/
@@ -123,6 +131,8 @@ long pj_Set_Geocentric_Parameters (GeocentricInfo *gi, double a, double b)
         gi->Geocent_b2 = b * b;
         gi->Geocent_e2 = (gi->Geocent_a2 - gi->Geocent_b2) / gi->Geocent_a2;
         gi->Geocent_ep2 = (gi->Geocent_a2 - gi->Geocent_b2) / gi->Geocent_b2;
+        gi->Geocent_e4 = gi->Geocent_e2 * gi->Geocent_e2;
+        gi->Geocent_q = (1.0 - gi->Geocent_e2) / gi->Geocent_a2;
     }
     return (Error_Code);
 } /* END OF Set_Geocentric_Parameters */
@@ -145,13 +155,13 @@ void pj_Get_Geocentric_Parameters (GeocentricInfo *gi,
 } /* END OF Get_Geocentric_Parameters */
 
 
-long pj_Convert_Geodetic_To_Geocentric (GeocentricInfo *gi,
-                                        double Latitude,
-                                        double Longitude,
-                                        double Height,
-                                        double *X,
-                                        double *Y,
-                                        double *Z) 
+static long Geodetic_To_Geocentric (const GeocentricInfo *gi,
+                                    double Latitude,
+                                    double Longitude,
+                                    double Height,
+                                    double *X,
+                                    double *Y,
+                                    double *Z) 
 { /* BEGIN Convert_Geodetic_To_Geocentric */
 /*
  * The function Convert_Geodetic_To_Geocentric converts geodetic coordinates
@@ -202,6 +212,62 @@ long pj_Convert_Geodetic_To_Geocentric (GeocentricInfo *gi,
   return (Error_Code);
 } /* END OF Convert_Geodetic_To_Geocentric */
 
+
+long pj_Convert_Geodetic_To_Geocentric (GeocentricInfo *gi,
+                                        double Latitude,
+                                        double Longitude,
+                                        double Height,
+                                        double *X,
+                                        double *Y,
+                                        double *Z) 
+{
+  return Geodetic_To_Geocentric(gi, Latitude, Longitude, Height, X, Y, Z);
+}
+
+
+long pj_Convert_Geodetic_To_Geocentric_Array (GeocentricInfo *gi,
+                                              long Count,
+                                              int Offset,
+                                              double *Longitude,
+                                              double *Latitude,
+                                              double *Height) 
+{ /* BEGIN Convert_Geodetic_To_Geocentric_Array */
+/*
+ * The function Convert_Geodetic_To_Geocentric_Array converts Count
+ * points in place, as Convert_Geodetic_To_Geocentric.  Points whose
+ * longitude is HUGE_VAL are left alone, as are points with an invalid
+ * latitude, whose longitude and latitude are set to HUGE_VAL.
+ *
+ *    Count     : Number of points                           (input)
+ *    Offset    : Distance between points in the arrays      (input)
+ *    Longitude : Longitudes in radians, X on output   (input/output)
+ *    Latitude  : Latitudes in radians, Y on output    (input/output)
+ *    Height    : Heights in meters, Z on output       (input/output)
+ *
+ */
+  long Error_Code = GEOCENT_NO_ERROR;
+  long i;
+
+  for (i = 0; i < Count; i++)
+  {
+    long io = i * Offset;
+    long Point_Error;
+
+    if (Longitude[io] == HUGE_VAL)
+      continue;
+
+    Point_Error = Geodetic_To_Geocentric(gi, Latitude[io], Longitude[io],
+                                         Height[io], Longitude + io,
+                                         Latitude + io, Height + io);
+    if (Point_Error)
+    {
+      Error_Code |= Point_Error;
+      Longitude[io] = Latitude[io] = HUGE_VAL;
+    }
+  }
+  return (Error_Code);
+} /* END OF Convert_Geodetic_To_Geocentric_Array */
+
 /*
  * The function Convert_Geocentric_To_Geodetic converts geocentric
  * coordinates (X, Y, Z) to geodetic coordinates (latitude, longitude, 
@@ -217,14 +283,14 @@ long pj_Convert_Geodetic_To_Geocentric (GeocentricInfo *gi,
 
 #define USE_ITERATIVE_METHOD
 
-void pj_Convert_Geocentric_To_Geodetic (GeocentricInfo *gi,
-                                        double X,
-                                        double Y, 
-                                        double Z,
-                                        double *Latitude,
-                                        double *Longitude,
-                                        double *Height)
-{ /* BEGIN Convert_Geocentric_To_Geodetic */
+static void Geocentric_To_Geodetic_Iterative (const GeocentricInfo *gi,
+                                              double X,
+                                              double Y, 
+                                              double Z,
+                                              double *Latitude,
+                                              double *Longitude,
+                                              double *Height)
+{ /* BEGIN Geocentric_To_Geodetic_Iterative */
 #if !defined(USE_ITERATIVE_METHOD)
 /*
  * The method used here is derived from 'An Improved Algorithm for
@@ -432,4 +498,111 @@ void pj_Convert_Geocentric_To_Geodetic (GeocentricInfo *gi,
 
     return;
 #endif /* defined(USE_ITERATIVE_METHOD) */
+} /* END OF Geocentric_To_Geodetic_Iterative */
+
+
+static int Geocentric_To_Geodetic_Closed (const GeocentricInfo *gi,
+                                          double X,
+                                          double Y, 
+                                          double Z,
+                                          double *Latitude,
+                                          double *Longitude,
+                                          double *Height)
+{ /* BEGIN Geocentric_To_Geodetic_Closed */
+/*
+ * The method used here is the closed form one of 'Computing geodetic
+ * coordinates from geocentric coordinates', by H. Vermeille, 2004.  It
+ * holds everywhere except within about e2 * a of the centre of the
+ * ellipsoid, where FALSE is returned and nothing is set.
+ */
+
+/* Note: Variable names follow the notation used in Vermeille, 2004 */
+
+    double P;        /* distance from Z axis */
+    double P2;       /* square of distance from Z axis */
+    double p, q, r, s, t, u, v, w, k;
+    double D;        /* distance from Z axis, scaled onto the normal */
+    double R;        /* distance from the foot of the normal on the Z axis */
+    double e2 = gi->Geocent_e2;
+
+    P2 = X*X + Y*Y;
+    p = P2 / gi->Geocent_a2;
+    q = gi->Geocent_q * Z*Z;
+    r = (p + q - gi->Geocent_e4) / 6.0;
+    if (r <= 0.0)
+        return FALSE;
+
+    s = gi->Geocent_e4 * p * q / (4.0 * r*r*r);
+    t = CBRT(1.0 + s + sqrt(s * (2.0 + s)));
+    u = r * (1.0 + t + 1.0 / t);
+    v = sqrt(u*u + gi->Geocent_e4 * q);
+    w = e2 * (u + v - q) / (2.0 * v);
+    k = sqrt(u + v + w*w) - w;
+    P = sqrt(P2);
+    D = k * P / (k + e2);
+    R = sqrt(D*D + Z*Z);
+
+/*  same longitude as the iterative method, including near the Z axis */
+    if (P / gi->Geocent_a < 1.E-12)
+        *Longitude = 0.0;
+    else
+        *Longitude = atan2(Y, X);
+/*  D + R > 0 here, as the point is away from the centre */
+    *Latitude = 2.0 * atan(Z / (D + R));
+    *Height = (k + e2 - 1.0) / k * R;
+
+    return TRUE;
+} /* END OF Geocentric_To_Geodetic_Closed */
+
+
+void pj_Convert_Geocentric_To_Geodetic (GeocentricInfo *gi,
+                                        double X,
+                                        double Y, 
+                                        double Z,
+                                        double *Latitude,
+                                        double *Longitude,
+                                        double *Height)
+{ /* BEGIN Convert_Geocentric_To_Geodetic */
+    if (!Geocentric_To_Geodetic_Closed(gi, X, Y, Z, Latitude, Longitude, Height))
+        Geocentric_To_Geodetic_Iterative(gi, X, Y, Z, 
+                                         Latitude, Longitude, Height);
 } /* END OF Convert_Geocentric_To_Geodetic */
+
+
+void pj_Convert_Geocentric_To_Geodetic_Array (GeocentricInfo *gi,
+                                              long Count,
+                                              int Offset,
+                                              double *X,
+                                              double *Y,
+                                              double *Z)
+{ /* BEGIN Convert_Geocentric_To_Geodetic_Array */
+/*
+ * The function Convert_Geocentric_To_Geodetic_Array converts Count
+ * points in place, as Convert_Geocentric_To_Geodetic.  Points whose X
+ * is HUGE_VAL are left alone.
+ *
+ *    Count     : Number of points                           (input)
+ *    Offset    : Distance between points in the arrays      (input)
+ *    X         : X in meters, longitude on output     (input/output)
+ *    Y         : Y in meters, latitude on output      (input/output)
+ *    Z         : Z in meters, height on output        (input/output)
+ */
+    long i;
+
+    for (i = 0; i < Count; i++)
+    {
+        long io = i * Offset;
+        double Latitude, Longitude, Height;
+
+        if (X[io] == HUGE_VAL)
+            continue;
+
+        if (!Geocentric_To_Geodetic_Closed(gi, X[io], Y[io], Z[io], 
+                                           &Latitude, &Longitude, &Height))
+            Geocentric_To_Geodetic_Iterative(gi, X[io], Y[io], Z[io], 
+                                             &Latitude, &Longitude, &Height);
+        X[io] = Longitude;
+        Y[io] = Latitude;
+        Z[io] = Height;
+    }
+} /* END OF Convert_Geocentric_To_Geodetic_Array */
@@ -100,6 +100,8 @@ typedef struct
     double Geocent_b2;       /* Square of semi-minor axis */
     double Geocent_e2;       /* Eccentricity squared  */
     double Geocent_ep2;      /* 2nd eccentricity squared */
+    double Geocent_e4;       /* Eccentricity to the fourth */
+    double Geocent_q;        /* (1 - e2) / a2 */
 } GeocentricInfo;
 
 void pj_Init_Geocentric( GeocentricInfo *gi );
@@ -151,6 +153,27 @@ long pj_Convert_Geodetic_To_Geocentric ( GeocentricInfo *gi,
  */
 
 
+long pj_Convert_Geodetic_To_Geocentric_Array ( GeocentricInfo *gi,
+                                               long Count,
+                                               int Offset,
+                                               double *Longitude,
+                                               double *Latitude,
+                                               double *Height);
+/*
+ * The function Convert_Geodetic_To_Geocentric_Array converts Count points
+ * in place, as Convert_Geodetic_To_Geocentric.  Points whose longitude is
+ * HUGE_VAL are left alone, as are points with an invalid latitude, whose
+ * longitude and latitude are set to HUGE_VAL.
+ *
+ *    Count     : Number of points                           (input)
+ *    Offset    : Distance between points in the arrays      (input)
+ *    Longitude : Longitudes in radians, X on output   (input/output)
+ *    Latitude  : Latitudes in radians, Y on output    (input/output)
+ *    Height    : Heights in meters, Z on output       (input/output)
+ *
+ */
+
+
 void pj_Convert_Geocentric_To_Geodetic (GeocentricInfo *gi,
                                         double X,
                                         double Y, 
@@ -172,6 +195,25 @@ void pj_Convert_Geocentric_To_Geodetic (GeocentricInfo *gi,
  */
 
 
+void pj_Convert_Geocentric_To_Geodetic_Array (GeocentricInfo *gi,
+                                              long Count,
+                                              int Offset,
+                                              double *X,
+                                              double *Y,
+                                              double *Z);
+/*
+ * The function Convert_Geocentric_To_Geodetic_Array converts Count points
+ * in place, as Convert_Geocentric_To_Geodetic.  Points whose X is
+ * HUGE_VAL are left alone.
+ *
+ *    Count     : Number of points                           (input)
+ *    Offset    : Distance between points in the arrays      (input)
+ *    X         : X in meters, longitude on output     (input/output)
+ *    Y         : Y in meters, latitude on output      (input/output)
+ *    Z         : Z in meters, height on output        (input/output)
+ */
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,6 @@
 /* <<<< Geodesic filter program >>>> */
 # include "projects.h"
-# include "geodesic.h"
+# include "geod_names.h"
 # include "emess.h"
 # include <ctype.h>
 # include <stdio.h>
@@ -14,6 +14,10 @@ fullout = 0,	/* output full set of geodesic values */
 tag = '#',	/* beginning of line tag character */
 pos_azi = 0,	/* output azimuths as positive values */
 inverse = 0;	/* != 0 then inverse geodesic */
+	static GEODESIC_T
+geodesic;
+	static GEODESIC_T
+*GEODESIC = &geodesic;
 	static char
 *oform = (char *)0,	/* output format for decimal degrees */
 *osform = "%.3f",	/* output format for S */
@@ -37,8 +41,8 @@ do_arc(void) {
 	printLL(phi2, lam2); putchar('\n');
 	for (az = al12; n_alpha--; ) {
 		al12 = az = adjlon(az + del_alpha);
-		geod_pre();
-		geod_for();
+		geod_pre(GEODESIC);
+		geod_for(GEODESIC);
 		printLL(phi2, lam2); putchar('\n');
 	}
 }
@@ -50,7 +54,7 @@ do_geod(void) {
 	laml = lam2;
 	printLL(phi1, lam1); putchar('\n');
 	for ( geod_S = del_S = geod_S / n_S; --n_S; geod_S += del_S) {
-		geod_for();
+		geod_for(GEODESIC);
 		printLL(phi2, lam2); putchar('\n');
 	}
 	printLL(phil, laml); putchar('\n');
@@ -78,12 +82,12 @@ process(FILE *fid) {
 		if (inverse) {
 			phi2 = dmstor(s, &s);
 			lam2 = dmstor(s, &s);
-			geod_inv();
+			geod_inv(GEODESIC);
 		} else {
 			al12 = dmstor(s, &s);
-			geod_S = strtod(s, &s) * to_meter;
-			geod_pre();
-			geod_for();
+			geod_S = strtod(s, &s) * GEODESIC->TO_METER;
+			geod_pre(GEODESIC);
+			geod_for(GEODESIC);
 		}
 		if (!*s && (s > line)) --s; /* assumed we gobbled \n */
 		if (pos_azi) {
@@ -96,21 +100,21 @@ process(FILE *fid) {
 			if (oform) {
 				(void)printf(oform, al12 * RAD_TO_DEG); TAB;
 				(void)printf(oform, al21 * RAD_TO_DEG); TAB;
-				(void)printf(osform, geod_S * fr_meter);
+				(void)printf(osform, geod_S * GEODESIC->FR_METER);
 			}  else {
 				(void)fputs(rtodms(pline, al12, 0, 0), stdout); TAB;
 				(void)fputs(rtodms(pline, al21, 0, 0), stdout); TAB;
-				(void)printf(osform, geod_S * fr_meter);
+				(void)printf(osform, geod_S * GEODESIC->FR_METER);
 			}
 		} else if (inverse)
 			if (oform) {
 				(void)printf(oform, al12 * RAD_TO_DEG); TAB;
 				(void)printf(oform, al21 * RAD_TO_DEG); TAB;
-				(void)printf(osform, geod_S * fr_meter);
+				(void)printf(osform, geod_S * GEODESIC->FR_METER);
 			} else {
 				(void)fputs(rtodms(pline, al12, 0, 0), stdout); TAB;
 				(void)fputs(rtodms(pline, al21, 0, 0), stdout); TAB;
-				(void)printf(osform, geod_S * fr_meter);
+				(void)printf(osform, geod_S * GEODESIC->FR_METER);
 			}
 		else {
 			printLL(phi2, lam2); TAB;
@@ -206,7 +210,7 @@ noargument:		   emess(1,"missing argument for -%c",*arg);
 			eargv[eargc++] = *argv;
 	}
 	/* done with parameter and control input */
-	geod_set(pargc, pargv); /* setup projection */
+	geod_set(GEODESIC, pargc, pargv); /* setup projection */
 	if ((n_alpha || n_S) && eargc)
 		emess(1,"files specified for arc/geodesic mode");
 	if (n_alpha)
@@ -0,0 +1,131 @@
+/* Library entry points for the geodesic routines */
+# include <string.h>
+# include <errno.h>
+# include "projects.h"
+# include "geod_names.h"
+# define LATLONG "+proj=latlong "
+	void	/* ellipse constants for semi-major axis a, eccentricity^2 es */
+geod_set_ellipse(GEODESIC_T *GEODESIC, double a, double es) {
+	geod_a = a;
+	if ((ellipse = es != 0.)) {
+		onef = sqrt(1. - es);
+		geod_f = 1 - onef;
+		f2 = geod_f/2;
+		f4 = geod_f/4;
+		f64 = geod_f*geod_f/64;
+	} else {
+		onef = 1.;
+		geod_f = f2 = f4 = f64 = 0.;
+	}
+}
+/*
+** Set up GEODESIC for the ellipsoid of a definition such as "+ellps=WGS84"
+** or "+R=6370997", in the same terms as pj_init_plus() takes.  A full
+** projection definition may be given, only its ellipsoid is used.
+** Distances are in meters.  Returns 0, or the error code if the
+** definition fails, which pj_strerrno() describes.
+*/
+	int
+geod_init_plus(GEODESIC_T *GEODESIC, const char *definition) {
+	projCtx ctx;
+	char *defn;
+	PJ *P;
+	int err = 0;
+
+	if (!(ctx = pj_ctx_alloc()))
+		return ENOMEM;
+	defn = (char *)pj_malloc(strlen(LATLONG) + strlen(definition) + 1);
+	if (!defn) {
+		pj_ctx_free(ctx);
+		return ENOMEM;
+	}
+	/* the first proj= wins, so ours shadows any in definition */
+	(void)strcpy(defn, LATLONG);
+	(void)strcat(defn, definition);
+	if ((P = pj_init_plus_ctx(ctx, defn))) {
+		(void)memset(GEODESIC, 0, sizeof(GEODESIC_T));
+		geod_set_ellipse(GEODESIC, P->a, P->es);
+		GEODESIC->TO_METER = GEODESIC->FR_METER = 1.;
+		pj_free(P);
+	} else if (!(err = pj_ctx_get_errno(ctx)))
+		err = -1;
+	pj_dalloc(defn);
+	pj_ctx_free(ctx);
+	return err;
+}
+/*
+** Direct problem for point_count geodesics: from lon/lat (radians)
+** along azimuth az for distance dist, giving lon_out/lat_out and, when
+** az_out is not NULL, the back azimuth.  Inputs are stepped by their
+** offsets, an offset of 0 using the one value for every geodesic, so a
+** single start and azimuth with many distances only runs geod_pre()
+** once.  Geodesics with HUGE_VAL input come out as HUGE_VAL.  G is only
+** read, so one set up GEODESIC_T can serve any number of threads.
+*/
+	void
+geod_for_array(const GEODESIC_T *G, long point_count,
+	const double *lon, const double *lat, int lonlat_offset,
+	const double *az, int az_offset, const double *dist, int dist_offset,
+	double *lon_out, double *lat_out, double *az_out) {
+	GEODESIC_T work, *GEODESIC = &work;
+	double lon_pre = 0., lat_pre = 0., az_pre = 0.;
+	int have_pre = 0;
+	long i;
+
+	work = *G;
+	for (i = 0; i < point_count; ++i) {
+		double lo = lon[i * lonlat_offset], la = lat[i * lonlat_offset],
+			a = az[i * az_offset], s = dist[i * dist_offset];
+
+		if (lo == HUGE_VAL || la == HUGE_VAL || a == HUGE_VAL
+			|| s == HUGE_VAL) {
+			lon_out[i] = lat_out[i] = HUGE_VAL;
+			if (az_out) az_out[i] = HUGE_VAL;
+			continue;
+		}
+		if (!have_pre || lo != lon_pre || la != lat_pre || a != az_pre) {
+			lam1 = lon_pre = lo;
+			phi1 = lat_pre = la;
+			al12 = az_pre = a;
+			geod_pre(GEODESIC);
+			have_pre = 1;
+		}
+		geod_S = s;
+		geod_for(GEODESIC);
+		lon_out[i] = lam2;
+		lat_out[i] = phi2;
+		if (az_out) az_out[i] = al21;
+	}
+}
+/*
+** Inverse problem for point_count pairs of points lon1/lat1 and
+** lon2/lat2 (radians), giving the distance and, for the outputs that
+** are not NULL, the forward and back azimuths.  Inputs are stepped as
+** for geod_for_array(), so an offset of 0 measures from (or to) one
+** point, and passing the same arrays for both ends one point apart
+** gives the legs of a route.  G is only read.
+*/
+	void
+geod_inv_array(const GEODESIC_T *G, long point_count,
+	const double *lon1, const double *lat1, int offset1,
+	const double *lon2, const double *lat2, int offset2,
+	double *dist, double *az12, double *az21) {
+	GEODESIC_T work, *GEODESIC = &work;
+	long i;
+
+	work = *G;
+	for (i = 0; i < point_count; ++i) {
+		lam1 = lon1[i * offset1];
+		phi1 = lat1[i * offset1];
+		lam2 = lon2[i * offset2];
+		phi2 = lat2[i * offset2];
+		if (lam1 == HUGE_VAL || phi1 == HUGE_VAL
+			|| lam2 == HUGE_VAL || phi2 == HUGE_VAL)
+			geod_S = al12 = al21 = HUGE_VAL;
+		else
+			geod_inv(GEODESIC);
+		if (dist) dist[i] = geod_S;
+		if (az12) az12[i] = al12;
+		if (az21) az21[i] = al21;
+	}
+}
@@ -1,12 +1,23 @@
 # include "projects.h"
-# include "geodesic.h"
+# include "geod_names.h"
 # define MERI_TOL 1e-9
-	static double
-th1,costh1,sinth1,sina12,cosa12,M,N,c1,c2,D,P,s1;
-	static int
-merid, signS;
+/* what geod_pre() leaves for geod_for() */
+# define th1	GEODESIC->TH1
+# define costh1	GEODESIC->COSTH1
+# define sinth1	GEODESIC->SINTH1
+# define sina12	GEODESIC->SINA12
+# define cosa12	GEODESIC->COSA12
+# define M	GEODESIC->M
+# define N	GEODESIC->N
+# define c1	GEODESIC->C1
+# define c2	GEODESIC->C2
+# define D	GEODESIC->D
+# define P	GEODESIC->P
+# define s1	GEODESIC->S1
+# define merid	GEODESIC->MERID
+# define signS	GEODESIC->SIGNS
 	void
-geod_pre(void) {
+geod_pre(GEODESIC_T *GEODESIC) {
 	al12 = adjlon(al12); /* reduce to  +- 0-PI */
 	signS = fabs(al12) > HALFPI ? 1 : 0;
 	th1 = ellipse ? atan(onef * tan(phi1)) : phi1;
@@ -43,7 +54,7 @@ geod_pre(void) {
 	}
 }
 	void
-geod_for(void) {
+geod_for(GEODESIC_T *GEODESIC) {
 	double d,sind,u,V,X,ds,cosds,sinds,ss,de;
 
 	if (ellipse) {
@@ -57,6 +68,7 @@ geod_for(void) {
 	} else {
 		ds = geod_S / geod_a;
 		if (signS) ds = - ds;
+		ss = 0.; /* only used for the ellipsoid */
 	}
 	cosds = cos(ds);
 	sinds = sin(ds);
@@ -1,8 +1,8 @@
 # include "projects.h"
-# include "geodesic.h"
+# include "geod_names.h"
 # define DTOL	1e-12
 	void
-geod_inv(void) {
+geod_inv(GEODESIC_T *GEODESIC) {
 	double	th1,th2,thm,dthm,dlamm,dlam,sindlamm,costhm,sinthm,cosdthm,
 		sindthm,L,E,cosd,d,X,Y,T,sind,tandlammp,u,v,D,A,B;
 
@@ -0,0 +1,316 @@
+/* Geodesic distances between every source and destination point */
+# include <string.h>
+# include <errno.h>
+# include "projects.h"
+# include "geodesic.h"
+/*
+** The distance is geod_inv()'s, rearranged so that no trigonometry is
+** left per pair.  geod_inv() needs the sines and cosines of the mean and
+** half difference of the reduced latitudes, and the sine of half the
+** longitude difference (squared, so adjlon() does not matter).  These
+** follow from the sines and cosines of half of each point's reduced
+** latitude and longitude, which are worked out once per point.  With
+** L as in geod_inv(), cos(d) = 1-2L gives
+**
+**	sin(d) = 2 sqrt(L) sqrt(1-L),  d = 2 atan(sqrt(L) / sqrt(1-L))
+**
+** and the atan is a polynomial (Cephes') with its range reduction done by
+** selection, so the loop working out d has no calls or branches.
+** Compilers vectorize it when sqrt() need not set errno and arithmetic
+** may be done ahead of a selection (-fno-math-errno, and for gcc
+** -fno-trapping-math; both are clang's defaults on Darwin).  On the
+** sphere this is the haversine formula.  Results agree with geod_inv()
+** to rounding error, and stay good for points too close together for
+** its acos().  Exactly antipodal points, where the ellipsoidal formula
+** breaks down, give HUGE_VAL.
+**
+** Destinations are taken a tile at a time, small enough to stay in L1
+** while a chunk of source rows is run over it, and chunks of rows are
+** shared out to threads with pj_run_threads().
+*/
+# define TILE_COLS	256	/* destinations per tile, 4 doubles each */
+# define ROW_CHUNK	32	/* source rows handed out at a time */
+# define L_MIN	1e-24	/* distance 0 below this, as in geod_inv() */
+# define T3P8	2.41421356237309504880	/* tan(3 pi / 8) */
+# define MOREBITS 6.123233995736765886130e-17
+	typedef struct {	/* half angle sines and cosines of points */
+	double	*st, *ct;	/* reduced latitude */
+	double	*sl, *cl;	/* longitude */
+} POINTS;
+	typedef struct {
+	const GEODESIC_T *G;
+	POINTS	src, dst;
+	long	src_count, dst_count;
+	double	*dist;		/* whole matrix, or */
+	int	k;		/* the nearest k of each row */
+	long	*index;
+	double	*near;
+	long	chunk_count;
+	long	next_chunk;	/* protected by pj_acquire_lock() */
+} MATRIX_JOB;
+	typedef struct {
+	MATRIX_JOB *job;
+	double	tile[TILE_COLS];	/* one row of a tile, for nearest */
+} MATRIX_WORKER;
+	static double	/* atan(p / q) for p, q >= 0, after Cephes atan.c */
+atan_ratio(double p, double q) {
+	double x, z;
+	int big = p > T3P8 * q, mid = p > .66 * q;
+
+	x = (big ? -q : mid ? p - q : p) / (big ? p : mid ? p + q : q);
+	z = x * x;
+	z = z * ((((-8.750608600031904122785e-1 * z
+		- 1.615753718733365076637e1) * z
+		- 7.500855792314704667340e1) * z
+		- 1.228866684490136173410e2) * z
+		- 6.485021904942025371773e1) /
+		(((((z + 2.485846490142306297962e1) * z
+		+ 1.650270098316988542046e2) * z
+		+ 4.328810604912902668951e2) * z
+		+ 4.853903996359136964868e2) * z
+		+ 1.945506571482613964425e2);
+	return (big ? HALFPI : mid ? FORTPI : 0.) +
+		(x * z + x + (big ? MOREBITS : mid ? .5 * MOREBITS : 0.));
+}
+	static void	/* distances from source i to count destinations from j0 */
+distance_row(const MATRIX_JOB *job, long i, long j0, long count,
+	double *out) {
+	const GEODESIC_T *G = job->G;
+	const double *st = job->dst.st + j0, *ct = job->dst.ct + j0,
+		*sl = job->dst.sl + j0, *cl = job->dst.cl + j0;
+	double st1 = job->src.st[i], ct1 = job->src.ct[i],
+		sl1 = job->src.sl[i], cl1 = job->src.cl[i];
+	double a = G->A, fl4 = G->FLAT4, fl64 = G->FLAT64;
+	long j;
+
+	/* the arc d first, in a loop of its own so that it vectorizes */
+	for (j = 0; j < count; ++j) {
+		double sinthm, sindthm, cosdthm, sindlamm, L;
+
+		sinthm = st1 * ct[j] + ct1 * st[j];
+		sindthm = st[j] * ct1 - ct[j] * st1;
+		cosdthm = ct[j] * ct1 + st[j] * st1;
+		sindlamm = sl[j] * cl1 - cl[j] * sl1;
+		L = sindthm * sindthm + (cosdthm * cosdthm - sinthm * sinthm)
+			* sindlamm * sindlamm;
+		L = L < 0. ? 0. : L > 1. ? 1. : L;
+		out[j] = 2. * atan_ratio(sqrt(L), sqrt(1. - L));
+	}
+	if (!G->ELLIPSE) {
+		for (j = 0; j < count; ++j) {
+			double S = a * out[j];
+
+			out[j] = S == S ? S : HUGE_VAL;
+		}
+		return;
+	}
+	for (j = 0; j < count; ++j) {
+		double sinthm, costhm, sindthm, cosdthm, sindlamm, L, d, sind, E,
+			X, Y, T, D, A, B, S;
+
+		sinthm = st1 * ct[j] + ct1 * st[j];
+		costhm = ct1 * ct[j] - st1 * st[j];
+		sindthm = st[j] * ct1 - ct[j] * st1;
+		cosdthm = ct[j] * ct1 + st[j] * st1;
+		sindlamm = sl[j] * cl1 - cl[j] * sl1;
+		L = sindthm * sindthm + (cosdthm * cosdthm - sinthm * sinthm)
+			* sindlamm * sindlamm;
+		L = L < 0. ? 0. : L > 1. ? 1. : L;
+		d = out[j];
+		sind = 2. * sqrt(L) * sqrt(1. - L);
+		E = 2. * (1. - L - L);
+		Y = sinthm * cosdthm;
+		Y *= (Y + Y) / (1. - L);
+		T = sindthm * costhm;
+		T *= (T + T) / L;
+		X = Y + T;
+		Y -= T;
+		T = d / sind;
+		D = 4. * T * T;
+		A = D * E;
+		B = D + D;
+		S = a * sind * (T - fl4 * (T * X - Y) +
+			fl64 * (X * (A + (T - .5 * (A - E)) * X) -
+			Y * (B + E * Y) + D * X * Y));
+		S = L > L_MIN ? S : L * 0.;	/* NaN stays NaN */
+		out[j] = S == S ? S : HUGE_VAL;
+	}
+}
+	static void	/* merge count distances from j0 into row i's nearest */
+keep_nearest(MATRIX_JOB *job, long i, long j0, long count,
+	const double *row) {
+	double *best = job->near + i * job->k;
+	long *index = job->index + i * job->k, j;
+	int m;
+
+	for (j = 0; j < count; ++j)
+		if (row[j] < best[job->k - 1]) {	/* first of equals stays first */
+			for (m = job->k - 1; m > 0 && best[m - 1] > row[j]; --m) {
+				best[m] = best[m - 1];
+				index[m] = index[m - 1];
+			}
+			best[m] = row[j];
+			index[m] = j0 + j;
+		}
+}
+	static void	/* run chunks of rows until none are left */
+matrix_worker(void *arg) {
+	MATRIX_WORKER *worker = (MATRIX_WORKER *)arg;
+	MATRIX_JOB *job = worker->job;
+	long chunk, i, i0, i1, j0, count;
+	int m;
+
+	for (;;) {
+		pj_acquire_lock();
+		chunk = job->next_chunk++;
+		pj_release_lock();
+		if (chunk >= job->chunk_count)
+			break;
+		i0 = chunk * ROW_CHUNK;
+		i1 = i0 + ROW_CHUNK < job->src_count ? i0 + ROW_CHUNK : job->src_count;
+		if (!job->dist)
+			for (i = i0; i < i1; ++i)
+				for (m = 0; m < job->k; ++m) {
+					job->index[i * job->k + m] = -1;
+					job->near[i * job->k + m] = HUGE_VAL;
+				}
+		for (j0 = 0; j0 < job->dst_count; j0 += TILE_COLS) {
+			count = job->dst_count - j0 < TILE_COLS ?
+				job->dst_count - j0 : TILE_COLS;
+			for (i = i0; i < i1; ++i)
+				if (job->dist)
+					distance_row(job, i, j0, count,
+						job->dist + i * job->dst_count + j0);
+				else {
+					distance_row(job, i, j0, count, worker->tile);
+					keep_nearest(job, i, j0, count, worker->tile);
+				}
+		}
+	}
+}
+	static void	/* half angle sines and cosines, NaN for HUGE_VAL points */
+set_points(const GEODESIC_T *G, long count, const double *lon,
+	const double *lat, int offset, POINTS *pts) {
+	double zero = 0., nan = zero / zero, th;
+	long i;
+
+	for (i = 0; i < count; ++i) {
+		double lo = lon[i * offset], la = lat[i * offset];
+
+		if (lo == HUGE_VAL || la == HUGE_VAL) {
+			pts->st[i] = pts->ct[i] = pts->sl[i] = pts->cl[i] = nan;
+			continue;
+		}
+		th = G->ELLIPSE ? atan(G->ONEF * tan(la)) : la;
+		pts->st[i] = sin(.5 * th);
+		pts->ct[i] = cos(.5 * th);
+		pts->sl[i] = sin(.5 * lo);
+		pts->cl[i] = cos(.5 * lo);
+	}
+}
+	static int	/* set up and run a job over thread_count threads */
+run_job(MATRIX_JOB *job,
+	const double *src_lon, const double *src_lat, int src_offset,
+	const double *dst_lon, const double *dst_lat, int dst_offset,
+	int thread_count) {
+	MATRIX_WORKER *workers;
+	double *buf;
+	long n = job->src_count + job->dst_count;
+	int i;
+
+	if (job->src_count <= 0 || job->dst_count <= 0)
+		return 0;
+	if (!(buf = (double *)pj_malloc(4 * n * sizeof(double))))
+		return ENOMEM;
+	job->src.st = buf;
+	job->src.ct = buf + n;
+	job->src.sl = buf + 2 * n;
+	job->src.cl = buf + 3 * n;
+	job->dst.st = job->src.st + job->src_count;
+	job->dst.ct = job->src.ct + job->src_count;
+	job->dst.sl = job->src.sl + job->src_count;
+	job->dst.cl = job->src.cl + job->src_count;
+	set_points(job->G, job->src_count, src_lon, src_lat, src_offset, &job->src);
+	set_points(job->G, job->dst_count, dst_lon, dst_lat, dst_offset, &job->dst);
+
+	job->chunk_count = (job->src_count + ROW_CHUNK - 1) / ROW_CHUNK;
+	job->next_chunk = 0;
+	if (thread_count <= 0)
+		thread_count = pj_cpu_count();
+	if (thread_count > job->chunk_count)
+		thread_count = (int)job->chunk_count;
+	if (!(workers = (MATRIX_WORKER *)
+		pj_malloc(thread_count * sizeof(MATRIX_WORKER)))) {
+		pj_dalloc(buf);
+		return ENOMEM;
+	}
+	for (i = 0; i < thread_count; ++i)
+		workers[i].job = job;
+	pj_run_threads(matrix_worker, workers, sizeof(MATRIX_WORKER),
+		thread_count);
+
+	pj_dalloc(workers);
+	pj_dalloc(buf);
+	return 0;
+}
+/*
+** Distance from each of src_count source points to each of dst_count
+** destination points (lon/lat in radians, stepped by their offsets as
+** for geod_inv_array()) into dist, row major with a row per source.
+** Pairs with a HUGE_VAL point come out as HUGE_VAL.  A thread_count of
+** zero or less uses one thread per online CPU.  Returns 0, or ENOMEM.
+*/
+	int
+geod_distance_matrix(const GEODESIC_T *G,
+	long src_count, const double *src_lon, const double *src_lat,
+	int src_offset,
+	long dst_count, const double *dst_lon, const double *dst_lat,
+	int dst_offset,
+	double *dist, int thread_count) {
+	MATRIX_JOB job;
+
+	(void)memset(&job, 0, sizeof(job));
+	job.G = G;
+	job.src_count = src_count;
+	job.dst_count = dst_count;
+	job.dist = dist;
+	return run_job(&job, src_lon, src_lat, src_offset,
+		dst_lon, dst_lat, dst_offset, thread_count);
+}
+/*
+** As geod_distance_matrix(), but only keeping the k nearest destinations
+** of each source, so the matrix is never held.  Row i of index and dist
+** (k entries each) gets their numbers and distances, nearest first and
+** the lower number first among equals, padded with -1 and HUGE_VAL when
+** there are fewer than k.
+*/
+	int
+geod_nearest(const GEODESIC_T *G,
+	long src_count, const double *src_lon, const double *src_lat,
+	int src_offset,
+	long dst_count, const double *dst_lon, const double *dst_lat,
+	int dst_offset,
+	int k, long *index, double *dist, int thread_count) {
+	MATRIX_JOB job;
+
+	if (k <= 0)
+		return 0;
+	(void)memset(&job, 0, sizeof(job));
+	job.G = G;
+	job.src_count = src_count;
+	job.dst_count = dst_count;
+	job.k = k;
+	job.index = index;
+	job.near = dist;
+	if (dst_count <= 0) {	/* nothing near, but rows still padded */
+		long i;
+
+		for (i = 0; i < src_count * k; ++i) {
+			index[i] = -1;
+			dist[i] = HUGE_VAL;
+		}
+		return 0;
+	}
+	return run_job(&job, src_lon, src_lat, src_offset,
+		dst_lon, dst_lat, dst_offset, thread_count);
+}
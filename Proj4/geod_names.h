@@ -0,0 +1,31 @@
+/*
+** Short names for the fields of the GEODESIC_T pointed to by GEODESIC,
+** the first argument of the library functions and a file level pointer
+** in the geod program.  For the geodesic sources only; not installed.
+*/
+#ifndef GEOD_NAMES_H
+#define GEOD_NAMES_H
+
+#include "geodesic.h"
+
+# define geod_a	GEODESIC->A
+# define lam1	GEODESIC->LAM1
+# define phi1	GEODESIC->PHI1
+# define al12	GEODESIC->ALPHA12
+# define lam2	GEODESIC->LAM2
+# define phi2	GEODESIC->PHI2
+# define al21	GEODESIC->ALPHA21
+# define geod_S	GEODESIC->DIST
+# define geod_f	GEODESIC->FLAT
+# define onef	GEODESIC->ONEF
+# define f2	GEODESIC->FLAT2
+# define f4	GEODESIC->FLAT4
+# define ff2	GEODESIC->FLAT4
+# define f64	GEODESIC->FLAT64
+# define ellipse GEODESIC->ELLIPSE
+# define del_alpha GEODESIC->DEL_ALPHA
+# define n_alpha GEODESIC->N_ALPHA
+# define n_S	GEODESIC->N_S
+/* TO_METER and FR_METER are not abbreviated as PJ_UNITS has a to_meter */
+
+#endif /* ndef GEOD_NAMES_H */
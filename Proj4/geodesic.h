@@ -1,51 +1,56 @@
-#ifndef lint
-static char GEODESIC_H_ID[] = "@(#)geodesic.h	4.3	95/08/19	GIE	REL";
-#endif
+#ifndef GEODESIC_H
+#define GEODESIC_H
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#ifndef _IN_GEOD_SET
-#  define GEOD_EXTERN extern
-#else
-#  define GEOD_EXTERN
-#endif
-
-GEOD_EXTERN struct geodesic {
+/*
+** All geodesic state lives in a GEODESIC_T, so any number of them can
+** be used at once, from any number of threads.  Angles are in radians,
+** distances in the units of the semi-major axis.
+*/
+typedef struct geodesic {
 	double	A;
 	double	LAM1, PHI1, ALPHA12;
 	double	LAM2, PHI2, ALPHA21;
 	double	DIST;
 	double	ONEF, FLAT, FLAT2, FLAT4, FLAT64;
 	int	ELLIPSE;
-} GEODESIC;
+	/* set by geod_pre() for geod_for() */
+	double	TH1, COSTH1, SINTH1, SINA12, COSA12, M, N, C1, C2, D, P, S1;
+	int	MERID, SIGNS;
+	/* geod program controls */
+	double	TO_METER, FR_METER, DEL_ALPHA;
+	int	N_ALPHA, N_S;
+} GEODESIC_T;
 
-# define geod_a	GEODESIC.A
-# define lam1	GEODESIC.LAM1
-# define phi1	GEODESIC.PHI1
-# define al12	GEODESIC.ALPHA12
-# define lam2	GEODESIC.LAM2
-# define phi2	GEODESIC.PHI2
-# define al21	GEODESIC.ALPHA21
-# define geod_S	GEODESIC.DIST
-# define geod_f	GEODESIC.FLAT
-# define onef	GEODESIC.ONEF
-# define f2	GEODESIC.FLAT2
-# define f4	GEODESIC.FLAT4
-# define ff2	GEODESIC.FLAT4
-# define f64	GEODESIC.FLAT64
-# define ellipse GEODESIC.ELLIPSE
+void geod_set(GEODESIC_T *, int, char **);	/* geod program only */
 
-    
-GEOD_EXTERN int n_alpha, n_S;
-GEOD_EXTERN double to_meter, fr_meter, del_alpha;
-	
-void geod_set(int, char **);
-void geod_for(void);
-void geod_pre(void);
-void geod_inv(void);
+int geod_init_plus(GEODESIC_T *, const char *);
+void geod_set_ellipse(GEODESIC_T *, double, double);
+void geod_for(GEODESIC_T *);
+void geod_pre(GEODESIC_T *);
+void geod_inv(GEODESIC_T *);
+void geod_for_array(const GEODESIC_T *, long,
+	const double *, const double *, int,
+	const double *, int, const double *, int,
+	double *, double *, double *);
+void geod_inv_array(const GEODESIC_T *, long,
+	const double *, const double *, int,
+	const double *, const double *, int,
+	double *, double *, double *);
+int geod_distance_matrix(const GEODESIC_T *,
+	long, const double *, const double *, int,
+	long, const double *, const double *, int,
+	double *, int);
+int geod_nearest(const GEODESIC_T *,
+	long, const double *, const double *, int,
+	long, const double *, const double *, int,
+	int, long *, double *, int);
 
 #ifdef __cplusplus
 }
 #endif
+
+#endif /* ndef GEODESIC_H */
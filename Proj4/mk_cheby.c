@@ -31,12 +31,21 @@ makeT(int nru, int nrv) {
 		return T;
 	} else
 		return 0;
+}
+	static projUV /* calls the func of mk_cheby() for mk_cheby_r() */
+call_func(projUV arg, void *data) {
+	return (**(projUV (**)(projUV))data)(arg);
 }
 	Tseries *
 mk_cheby(projUV a, projUV b, double res, projUV *resid, projUV (*func)(projUV), 
 	int nu, int nv, int power) {
+	return mk_cheby_r(a, b, res, resid, call_func, &func, nu, nv, power);
+}
+	Tseries * /* mk_cheby() with data passed on to each call of func */
+mk_cheby_r(projUV a, projUV b, double res, projUV *resid,
+	projUV (*func)(projUV, void *), void *data, int nu, int nv, int power) {
 	int j, i, nru, nrv, *ncu, *ncv;
-	Tseries *T;
+	Tseries *T = 0;
 	projUV **w;
 	double cutres;
 
@@ -44,7 +53,7 @@ mk_cheby(projUV a, projUV b, double res, projUV *resid, projUV (*func)(projUV),
 		!(ncu = (int *)vector1(nu + nv, sizeof(int))))
 		return 0;
 	ncv = ncu + nu;
-	if (!bchgen(a, b, nu, nv, w, func)) {
+	if (!bchgen_r(a, b, nu, nv, w, func, data)) {
 		projUV *s;
 		double ab, *p;
 
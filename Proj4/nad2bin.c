@@ -56,7 +56,7 @@ int main(int argc, char **argv) {
 		perror(argv[1]);
 		exit(2);
 	}
-	if (fwrite(&ct, sizeof(ct), 1, stdout) != 1 ||
+	if (fwrite(&ct, sizeof(struct CTABLE_HDR), 1, stdout) != 1 ||
 		fwrite(ct.cvs, tsize, 1, stdout) != 1) {
 		fprintf(stderr, "output failure\n");
 		exit(2);
@@ -4,6 +4,10 @@
 #define TOL 1e-12
 	LP
 nad_cvt(LP in, int inverse, struct CTABLE *ct) {
+	return nad_cvt_ctx(pj_get_default_ctx(), in, inverse, ct);
+}
+	LP /* nad_cvt() leaving grid read errors in ctx, see nad_intr_ctx() */
+nad_cvt_ctx(projCtx ctx, LP in, int inverse, struct CTABLE *ct) {
 	LP t, tb;
 
 	if (in.lam == HUGE_VAL)
@@ -13,7 +17,7 @@ nad_cvt(LP in, int inverse, struct CTABLE *ct) {
 	tb.lam -= ct->ll.lam;
 	tb.phi -= ct->ll.phi;
 	tb.lam = adjlon(tb.lam - PI) + PI;
-	t = nad_intr(tb, ct);
+	t = nad_intr_ctx(ctx, tb, ct);
 	if (inverse) {
 		LP del, dif;
 		int i = MAX_TRY;
@@ -23,7 +27,7 @@ nad_cvt(LP in, int inverse, struct CTABLE *ct) {
 		t.phi = tb.phi - t.phi;
 
 		do {
-			del = nad_intr(t, ct);
+			del = nad_intr_ctx(ctx, t, ct);
 
                         /* This case used to return failure, but I have
                            changed it to return the first order approximation
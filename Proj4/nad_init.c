@@ -34,6 +34,14 @@
 #include <errno.h>
 #include <string.h>
 
+#if !defined(_WIN32) && !defined(_WIN32_WCE)
+#  define HAVE_GRID_MMAP
+#  include <sys/types.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
 #ifdef _WIN32_WCE
 /* assert.h includes all Windows API headers and causes 'LP' name clash.
  * Here assert we disable assert() for Windows CE.
@@ -44,38 +52,97 @@
 # include <assert.h>
 #endif /* _WIN32_WCE */
 
+/************************************************************************/
+/*                            nad_map_grid()                            */
+/*                                                                      */
+/*      Map size bytes of grid values starting at offset in fid         */
+/*      read-only, so the pages are shared with every other process     */
+/*      using the same file and only touched parts are ever read.       */
+/*      Returns a pointer to the values, or NULL if mapping is not      */
+/*      available, in which case the caller should read them.          */
+/*      Setting PROJ_GRID_MMAP=NO in the environment disables it.       */
+/************************************************************************/
+
+void *nad_map_grid( struct CTABLE *ct, FILE *fid, long offset, size_t size )
+
+{
+#ifdef HAVE_GRID_MMAP
+    const char *mode = getenv( "PROJ_GRID_MMAP" );
+    struct stat st;
+    long   page_size, map_offset;
+    void   *map;
+
+    if( mode != NULL && (mode[0] == 'N' || mode[0] == 'n' || mode[0] == '0'
+                         || strcmp(mode, "OFF") == 0
+                         || strcmp(mode, "off") == 0) )
+        return NULL;
+
+    /* a truncated file would fault on access rather than fail a read */
+    if( fstat( fileno(fid), &st ) != 0 || !S_ISREG(st.st_mode)
+        || offset < 0 || (off_t) (offset + size) > st.st_size )
+        return NULL;
+
+    page_size = sysconf( _SC_PAGESIZE );
+    if( page_size <= 0 )
+        return NULL;
+    map_offset = offset - offset % page_size;
+
+    map = mmap( NULL, size + (offset - map_offset), PROT_READ, MAP_SHARED,
+                fileno(fid), map_offset );
+    if( map == MAP_FAILED )
+        return NULL;
+
+    ct->map = map;
+    ct->map_size = size + (offset - map_offset);
+
+    return (char *) map + (offset - map_offset);
+#else
+    return NULL;
+#endif
+}
+
 /************************************************************************/
 /*                          nad_ctable_load()                           */
 /*                                                                      */
 /*      Load the data portion of a ctable formatted grid.               */
 /************************************************************************/
 
-int nad_ctable_load( struct CTABLE *ct, FILE *fid )
+int nad_ctable_load( projCtx ctx, struct CTABLE *ct, FILE *fid )
 
 {
     int  a_size;
+    FLP  *cvs;
 
-    fseek( fid, sizeof(struct CTABLE), SEEK_SET );
-
-    /* read all the actual shift values */
     a_size = ct->lim.lam * ct->lim.phi;
-    ct->cvs = (FLP *) pj_malloc(sizeof(FLP) * a_size);
-    if( ct->cvs == NULL 
-        || fread(ct->cvs, sizeof(FLP), a_size, fid) != a_size )
+
+    /* the file holds the values in native layout, so use them in place */
+    cvs = (FLP *) nad_map_grid( ct, fid, sizeof(struct CTABLE_HDR),
+                                sizeof(FLP) * a_size );
+    if( cvs != NULL )
     {
-        pj_dalloc( ct->cvs );
-        ct->cvs = NULL;
+        ct->cvs = cvs;
+        return 1;
+    }
 
-        if( getenv("PROJ_DEBUG") != NULL )
-        {
-            fprintf( stderr, 
-            "ctable loading failed on fread() - binary incompatible?\n" );
-        }
+    fseek( fid, sizeof(struct CTABLE_HDR), SEEK_SET );
 
-        pj_errno = -38;
+    /* read all the actual shift values, only publishing them in ct */
+    /* once complete since other threads may be looking at ct->cvs  */
+    cvs = (FLP *) pj_malloc(sizeof(FLP) * a_size);
+    if( cvs == NULL 
+        || fread(cvs, sizeof(FLP), a_size, fid) != a_size )
+    {
+        pj_dalloc( cvs );
+
+        pj_log( ctx, PJ_LOG_ERROR,
+                "ctable loading failed on fread() - binary incompatible?" );
+
+        pj_ctx_set_errno( ctx, -38 );
         return 0;
     }
 
+    ct->cvs = cvs;
+
     return 1;
 } 
 
@@ -85,25 +152,34 @@ int nad_ctable_load( struct CTABLE *ct, FILE *fid )
 /*      Read the header portion of a "ctable" format grid.              */
 /************************************************************************/
 
-struct CTABLE *nad_ctable_init( FILE * fid )
+struct CTABLE *nad_ctable_init( projCtx ctx, FILE * fid )
 {
     struct CTABLE *ct;
+    struct CTABLE_HDR hdr;
     int		id_end;
 
     /* read the table header */
     ct = (struct CTABLE *) pj_malloc(sizeof(struct CTABLE));
     if( ct == NULL 
-        || fread( ct, sizeof(struct CTABLE), 1, fid ) != 1 )
+        || fread( &hdr, sizeof(hdr), 1, fid ) != 1 )
     {
-        pj_errno = -38;
+        pj_dalloc( ct );
+        pj_ctx_set_errno( ctx, -38 );
         return NULL;
     }
 
+    memset( ct, 0, sizeof(struct CTABLE) );
+    memcpy( ct->id, hdr.id, MAX_TAB_ID );
+    ct->ll = hdr.ll;
+    ct->del = hdr.del;
+    ct->lim = hdr.lim;
+
     /* do some minimal validation to ensure the structure isn't corrupt */
     if( ct->lim.lam < 1 || ct->lim.lam > 100000 
         || ct->lim.phi < 1 || ct->lim.phi > 100000 )
     {
-        pj_errno = -38;
+        pj_dalloc( ct );
+        pj_ctx_set_errno( ctx, -38 );
         return NULL;
     }
     
@@ -127,28 +203,29 @@ struct CTABLE *nad_ctable_init( FILE * fid )
 /*      Read a datum shift file in any of the supported binary formats. */
 /************************************************************************/
 
-struct CTABLE *nad_init(char *name) 
+struct CTABLE *nad_init(projCtx ctx, char *name) 
 {
     char 	fname[MAX_PATH_FILENAME+1];
     struct CTABLE *ct;
     FILE 	*fid;
     char	header[512];
 
-    errno = pj_errno = 0;
+    errno = 0;
+    pj_ctx_set_errno( ctx, 0 );
 
 /* -------------------------------------------------------------------- */
 /*      Open the file using the usual search rules.                     */
 /* -------------------------------------------------------------------- */
     strcpy(fname, name);
-    if (!(fid = pj_open_lib(fname, "rb"))) {
-        pj_errno = errno;
+    if (!(fid = pj_open_lib(ctx, fname, "rb"))) {
+        pj_ctx_set_errno( ctx, errno );
         return 0;
     }
     
-    ct = nad_ctable_init( fid );
+    ct = nad_ctable_init( ctx, fid );
     if( ct != NULL )
     {
-        if( !nad_ctable_load( ct, fid ) )
+        if( !nad_ctable_load( ctx, ct, fid ) )
         {
             nad_free( ct );
             ct = NULL;
@@ -168,7 +245,15 @@ struct CTABLE *nad_init(char *name)
 void nad_free(struct CTABLE *ct) 
 {
     if (ct) {
-        if( ct->cvs != NULL )
+        pj_gridcache_detach( ct );
+
+        if( ct->map != NULL )
+        {
+#ifdef HAVE_GRID_MMAP
+            munmap( ct->map, ct->map_size );
+#endif
+        }
+        else if( ct->cvs != NULL )
             pj_dalloc(ct->cvs);
 
         pj_dalloc(ct);
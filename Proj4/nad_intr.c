@@ -1,12 +1,28 @@
 /* Determine nad table correction value */
 #define PJ_LIB__
 #include <projects.h>
+/* NTv2 record (lat, lon shift and accuracies in arc seconds) to radians,
+** rounded to float exactly as a loaded grid would have been */
+#define NTV2_SEC ((PI/180.0) / 3600.0)
+	static void
+ntv2_node(const float *rec, FLP *f) {
+	f->phi = rec[0] * NTV2_SEC;
+	f->lam = rec[1] * NTV2_SEC;
+}
 	LP
 nad_intr(LP t, struct CTABLE *ct) {
+	return nad_intr_ctx(pj_get_default_ctx(), t, ct);
+}
+/* As nad_intr(), but if a tile of a paged grid cannot be read, the error
+** is left in ctx as well as HUGE_VAL returned, so that it is not taken
+** for a point off the grid */
+	LP
+nad_intr_ctx(projCtx ctx, LP t, struct CTABLE *ct) {
 	LP val, frct;
 	ILP indx;
 	double m00, m10, m01, m11;
 	FLP *f00, *f10, *f01, *f11;
+	FLP n00, n10, n01, n11, nodes[4];
 	long index;
 	int in;
 
@@ -41,12 +57,25 @@ nad_intr(LP t, struct CTABLE *ct) {
 		} else
 			return val;
 	}
-	index = indx.phi * ct->lim.lam + indx.lam;
-	f00 = ct->cvs + index++;
-	f10 = ct->cvs + index;
-	index += ct->lim.lam;
-	f11 = ct->cvs + index--;
-	f01 = ct->cvs + index;
+	if (ct->ntv2) { /* mapped NTv2 rows run east to west */
+		index = indx.phi * ct->lim.lam + ct->lim.lam - 1 - indx.lam;
+		ntv2_node(ct->ntv2 + 4 * index--, f00 = &n00);
+		ntv2_node(ct->ntv2 + 4 * index, f10 = &n10);
+		index += ct->lim.lam;
+		ntv2_node(ct->ntv2 + 4 * index++, f11 = &n11);
+		ntv2_node(ct->ntv2 + 4 * index, f01 = &n01);
+	} else if (ct->tiles) {
+		if (!pj_gridcache_cell(ctx, ct, indx.phi, indx.lam, nodes))
+			return val;
+		f00 = nodes; f10 = nodes + 1; f01 = nodes + 2; f11 = nodes + 3;
+	} else {
+		index = indx.phi * ct->lim.lam + indx.lam;
+		f00 = ct->cvs + index++;
+		f10 = ct->cvs + index;
+		index += ct->lim.lam;
+		f11 = ct->cvs + index--;
+		f01 = ct->cvs + index;
+	}
 	m11 = m10 = frct.lam;
 	m00 = m01 = 1. - frct.lam;
 	m11 *= frct.phi;
@@ -38,6 +38,8 @@
 
 /************************************************************************/
 /*                         pj_apply_gridshift()                         */
+/*                                                                      */
+/*      Legacy entry point, operating on the default context.           */
 /************************************************************************/
 
 int pj_apply_gridshift( const char *nadgrids, int inverse, 
@@ -45,23 +47,96 @@ int pj_apply_gridshift( const char *nadgrids, int inverse,
                         double *x, double *y, double *z )
 
 {
-    int grid_count = 0;
-    PJ_GRIDINFO   **tables;
-    int  i;
-    int debug_flag = getenv( "PROJ_DEBUG" ) != NULL;
-    static int debug_count = 0;
+    return pj_apply_gridshift_ctx( pj_get_default_ctx(), nadgrids, inverse,
+                                   point_count, point_offset, x, y, z );
+}
 
-    pj_errno = 0;
+/************************************************************************/
+/*                       pj_apply_gridshift_2()                         */
+/*                                                                      */
+/*      Apply the nadgrids of a coordinate system.  The resolved grid   */
+/*      list is kept on the PJ, so after the first call finding it is   */
+/*      just a pointer read, with no lock or string matching.           */
+/************************************************************************/
 
-    tables = pj_gridlist_from_nadgrids( nadgrids, &grid_count);
-    if( tables == NULL || grid_count == 0 )
-        return pj_errno;
+int pj_apply_gridshift_2( PJ *defn, int inverse, 
+                          long point_count, int point_offset,
+                          double *x, double *y, double *z )
+
+{
+    if( defn->gridlist == NULL 
+        || defn->gridlist_generation != pj_gridlist_generation() )
+    {
+        PJ_GRIDLIST *gridlist;
+        int generation = pj_gridlist_generation();
+
+        gridlist = pj_gridlist_get( defn->ctx, 
+                                    pj_param(defn->ctx, defn->params,
+                                             "snadgrids").s );
+        if( gridlist == NULL || gridlist->count == 0 )
+            return defn->ctx->last_errno;
+
+        defn->gridlist = gridlist;
+        defn->gridlist_generation = generation;
+    }
+
+    pj_ctx_set_errno( defn->ctx, 0 );
+
+    return pj_apply_gridshift_3( defn->ctx, defn->gridlist, inverse,
+                                 point_count, point_offset, x, y, z );
+}
+
+/************************************************************************/
+/*                       pj_apply_gridshift_ctx()                       */
+/************************************************************************/
+
+int pj_apply_gridshift_ctx( projCtx ctx, const char *nadgrids, int inverse, 
+                            long point_count, int point_offset,
+                            double *x, double *y, double *z )
+
+{
+    PJ_GRIDLIST *gridlist;
+
+    pj_ctx_set_errno( ctx, 0 );
+
+    gridlist = pj_gridlist_get( ctx, nadgrids );
+    if( gridlist == NULL || gridlist->count == 0 )
+        return ctx->last_errno;
+
+    return pj_apply_gridshift_3( ctx, gridlist, inverse,
+                                 point_count, point_offset, x, y, z );
+}
+
+/************************************************************************/
+/*                       pj_apply_gridshift_3()                         */
+/*                                                                      */
+/*      Apply a resolved grid list to the points.  A point that no      */
+/*      grid covers (or whose grid cannot be loaded) is left as it      */
+/*      is and the rest are still shifted, so each point comes out as   */
+/*      it would from a call for it alone.  -38 is returned, and left   */
+/*      in ctx, if any point was not shifted.  A point whose shift      */
+/*      could not be read from a grid paged in by tile is not taken     */
+/*      to be off that grid: it is set to HUGE_VAL, and the read        */
+/*      error is returned instead.                                      */
+/************************************************************************/
+
+int pj_apply_gridshift_3( projCtx ctx, PJ_GRIDLIST *gridlist, int inverse, 
+                          long point_count, int point_offset,
+                          double *x, double *y, double *z )
+
+{
+    PJ_GRIDHIT  hit;
+    int  i, failed = 0, read_err = 0;
+    static int debug_count = 0;
+
+    hit.table = hit.child = -1;
 
     for( i = 0; i < point_count; i++ )
     {
         long io = i * point_offset;
         LP   input, output;
-        int  itable;
+        int  from, unreadable = 0;
+        PJ_GRIDINFO *gi;
 
         input.phi = y[io];
         input.lam = x[io];
@@ -69,75 +144,54 @@ int pj_apply_gridshift( const char *nadgrids, int inverse,
         output.lam = HUGE_VAL;
 
         /* keep trying till we find a table that works */
-        for( itable = 0; itable < grid_count; itable++ )
+        for( from = 0; 
+             (gi = pj_gridlist_find( gridlist, input, from, &hit )) != NULL;
+             from = hit.table + 1 )
         {
-            PJ_GRIDINFO *gi = tables[itable];
             struct CTABLE *ct = gi->ct;
 
-            /* skip tables that don't match our point at all.  */
-            if( ct->ll.phi > input.phi || ct->ll.lam > input.lam
-                || ct->ll.phi + (ct->lim.phi-1) * ct->del.phi < input.phi
-                || ct->ll.lam + (ct->lim.lam-1) * ct->del.lam < input.lam )
-                continue;
-
-            /* If we have child nodes, check to see if any of them apply. */
-            if( gi->child != NULL )
-            {
-                PJ_GRIDINFO *child;
-
-                for( child = gi->child; child != NULL; child = child->next )
-                {
-                    struct CTABLE *ct1 = child->ct;
-
-                    if( ct1->ll.phi > input.phi || ct1->ll.lam > input.lam
-                      || ct1->ll.phi+(ct1->lim.phi-1)*ct1->del.phi < input.phi
-                      || ct1->ll.lam+(ct1->lim.lam-1)*ct1->del.lam < input.lam)
-                        continue;
-
-                    break;
-                }
-
-                /* we found a more refined child node to use */
-                if( child != NULL )
-                {
-                    gi = child;
-                    ct = child->ct;
-                }
-            }
-
             /* load the grid shift info if we don't have it. */
-            if( ct->cvs == NULL && !pj_gridinfo_load( gi ) )
+            if( ct->cvs == NULL && ct->ntv2 == NULL && ct->tiles == NULL
+                && !pj_gridinfo_load( ctx, gi ) )
+                break;
+            
+            pj_ctx_set_errno( ctx, 0 );
+            output = nad_cvt_ctx( ctx, input, inverse, ct );
+            if( ctx->last_errno != 0 )
             {
-                pj_errno = -38;
-                return pj_errno;
+                pj_log( ctx, PJ_LOG_ERROR,
+                        "pj_apply_gridshift(): failed to read %s", ct->id );
+                if( read_err == 0 )
+                    read_err = ctx->last_errno;
+                unreadable = 1;
+                break;
             }
-            
-            output = nad_cvt( input, inverse, ct );
             if( output.lam != HUGE_VAL )
             {
-                if( debug_flag && debug_count++ < 20 )
-                    fprintf( stderr,
-                             "pj_apply_gridshift(): used %s\n",
-                             ct->id );
+                if( ctx->debug_level >= PJ_LOG_DEBUG_MINOR
+                    && debug_count++ < 20 )
+                    pj_log( ctx, PJ_LOG_DEBUG_MINOR,
+                            "pj_apply_gridshift(): used %s", ct->id );
                 break;
             }
         }
 
-        if( output.lam == HUGE_VAL )
+        if( unreadable )
         {
-            if( debug_flag )
-            {
-                fprintf( stderr, 
-                         "pj_apply_gridshift(): failed to find a grid shift table for\n"
-                         "                      location (%.7fdW,%.7fdN)\n",
-                         x[io] * RAD_TO_DEG, 
-                         y[io] * RAD_TO_DEG );
-                fprintf( stderr, 
-                         "   tried: %s\n", nadgrids );
-            }
+            y[io] = HUGE_VAL;
+            x[io] = HUGE_VAL;
+        }
+        else if( output.lam == HUGE_VAL )
+        {
+            pj_log( ctx, PJ_LOG_DEBUG_MAJOR,
+                    "pj_apply_gridshift(): failed to find a grid shift table for\n"
+                    "                      location (%.7fdW,%.7fdN)\n"
+                    "   tried: %s",
+                    x[io] * RAD_TO_DEG, 
+                    y[io] * RAD_TO_DEG,
+                    gridlist->nadgrids );
         
-            pj_errno = -38;
-            return pj_errno;
+            failed = 1;
         }
         else
         {
@@ -146,6 +200,18 @@ int pj_apply_gridshift( const char *nadgrids, int inverse,
         }
     }
 
+    if( read_err != 0 )
+    {
+        pj_ctx_set_errno( ctx, read_err );
+        return ctx->last_errno;
+    }
+
+    if( failed )
+    {
+        pj_ctx_set_errno( ctx, -38 );
+        return ctx->last_errno;
+    }
+
     return 0;
 }
 
@@ -0,0 +1,379 @@
+/* Runtime Chebyshev approximation of a projection over a region */
+#include <projects.h>
+#include <errno.h>
+
+/*
+** pj_approx_create() fits a bivariate Chebyshev series to the forward
+** or inverse projection over a rectangle with mk_cheby(), the same fit
+** proj -T uses, and then checks it against the projection on a grid
+** twice as fine as the fitting nodes.  The degree is raised until that
+** check passes, so every check point is within max_error.
+**
+** pj_approx_eval() evaluates the series for many points at once.  It
+** does what bcheval() does, in the same order, but with the points in
+** the innermost loops, which compilers can vectorize.
+*/
+
+#define APPROX_MIN_NODES    8
+#define APPROX_MAX_NODES    64
+#define APPROX_BLOCK        64          /* points evaluated together */
+#define NEAR_ONE            1.00001     /* as in biveval.c */
+
+struct PJ_APPROX {
+    projCtx     ctx;
+    Tseries     *T;
+};
+
+typedef struct {
+    PJ          *P;
+    int         inverse;
+} FIT_ARGS;
+
+/************************************************************************/
+/*                              fit_func()                              */
+/*                                                                      */
+/*      What mk_cheby_r() fits, with the FIT_ARGS passed to it.         */
+/************************************************************************/
+
+static projUV fit_func( projUV in, void *data )
+
+{
+    FIT_ARGS *args = (FIT_ARGS *) data;
+
+    if( args->inverse )
+        return pj_inv( in, args->P );
+    else
+        return pj_fwd( in, args->P );
+}
+
+/************************************************************************/
+/*                            free_series()                             */
+/************************************************************************/
+
+static void free_series( Tseries *T )
+
+{
+    int i;
+
+    for( i = 0; i <= T->mu; i++ )
+        if( T->cu[i].c )
+            pj_dalloc( T->cu[i].c );
+    for( i = 0; i <= T->mv; i++ )
+        if( T->cv[i].c )
+            pj_dalloc( T->cv[i].c );
+    pj_dalloc( T->cu );
+    pj_dalloc( T->cv );
+    pj_dalloc( T );
+}
+
+/************************************************************************/
+/*                           series_eval()                              */
+/*                                                                      */
+/*      ceval() of biveval.c for count points, with w and w2 already   */
+/*      scaled to [-1,1].                                               */
+/************************************************************************/
+
+static void series_eval( struct PW_COEF *C, int n, int count,
+                         double *wu, double *wv, double *w2u, double *w2v,
+                         double *out )
+
+{
+    double d[APPROX_BLOCK], dd[APPROX_BLOCK], vd[APPROX_BLOCK],
+        vdd[APPROX_BLOCK], tmp;
+    double *c;
+    int    i, j;
+
+    if( n < 0 ) /* every coefficient was below the resolution */
+    {
+        for( i = 0; i < count; i++ )
+            out[i] = 0.0;
+        return;
+    }
+
+    for( i = 0; i < count; i++ )
+        d[i] = dd[i] = 0.0;
+
+    for( C += n ; n-- ; --C )
+    {
+        if( (j = C->m) )
+        {
+            for( i = 0; i < count; i++ )
+                vd[i] = vdd[i] = 0.0;
+            for( c = C->c + --j; j ; --j, --c )
+            {
+                for( i = 0; i < count; i++ )
+                {
+                    tmp = vd[i];
+                    vd[i] = w2v[i] * tmp - vdd[i] + *c;
+                    vdd[i] = tmp;
+                }
+            }
+            for( i = 0; i < count; i++ )
+            {
+                tmp = d[i];
+                d[i] = w2u[i] * tmp - dd[i] + wv[i] * vd[i] - vdd[i] + 0.5 * *c;
+                dd[i] = tmp;
+            }
+        }
+        else
+        {
+            for( i = 0; i < count; i++ )
+            {
+                tmp = d[i];
+                d[i] = w2u[i] * tmp - dd[i];
+                dd[i] = tmp;
+            }
+        }
+    }
+
+    if( (j = C->m) )
+    {
+        for( i = 0; i < count; i++ )
+            vd[i] = vdd[i] = 0.0;
+        for( c = C->c + --j; j ; --j, --c )
+        {
+            for( i = 0; i < count; i++ )
+            {
+                tmp = vd[i];
+                vd[i] = w2v[i] * tmp - vdd[i] + *c;
+                vdd[i] = tmp;
+            }
+        }
+        for( i = 0; i < count; i++ )
+            out[i] = wu[i] * d[i] - dd[i]
+                + 0.5 * ( wv[i] * vd[i] - vdd[i] + 0.5 * *c );
+    }
+    else
+    {
+        for( i = 0; i < count; i++ )
+            out[i] = wu[i] * d[i] - dd[i];
+    }
+}
+
+/************************************************************************/
+/*                           approx_block()                             */
+/*                                                                      */
+/*      Evaluate up to APPROX_BLOCK points, returning how many were     */
+/*      outside the region.                                             */
+/************************************************************************/
+
+static int approx_block( const Tseries *T, int count, int point_offset,
+                         double *x, double *y )
+
+{
+    double wu[APPROX_BLOCK], wv[APPROX_BLOCK],
+        w2u[APPROX_BLOCK], w2v[APPROX_BLOCK],
+        ou[APPROX_BLOCK], ov[APPROX_BLOCK];
+    int    i, outside = 0;
+
+    for( i = 0; i < count; i++ )
+    {
+        long io = (long) i * point_offset;
+
+        /* scale to +-1, HUGE_VAL ends up outside */
+        wu[i] = ( x[io] + x[io] - T->a.u ) * T->b.u;
+        wv[i] = ( y[io] + y[io] - T->a.v ) * T->b.v;
+        w2u[i] = wu[i] + wu[i];
+        w2v[i] = wv[i] + wv[i];
+    }
+
+    series_eval( T->cu, T->mu, count, wu, wv, w2u, w2v, ou );
+    series_eval( T->cv, T->mv, count, wu, wv, w2u, w2v, ov );
+
+    for( i = 0; i < count; i++ )
+    {
+        long io = (long) i * point_offset;
+
+        if( fabs(wu[i]) > NEAR_ONE || fabs(wv[i]) > NEAR_ONE
+            || x[io] == HUGE_VAL )
+        {
+            x[io] = y[io] = HUGE_VAL;
+            outside++;
+        }
+        else
+        {
+            x[io] = ou[i];
+            y[io] = ov[i];
+        }
+    }
+
+    return outside;
+}
+
+/************************************************************************/
+/*                           approx_error()                             */
+/*                                                                      */
+/*      Largest difference between the series and the projection on    */
+/*      a (2n+1) x (2n+1) grid over the region, or HUGE_VAL if the      */
+/*      projection fails anywhere on it.                                */
+/************************************************************************/
+
+static double approx_error( PJ *P, int inverse, const Tseries *T,
+                            projUV min, projUV max, int n )
+
+{
+    int    steps = 2 * n, i, j;
+    long   count = (long) (steps + 1) * (steps + 1), k;
+    double *buf, *ex, *ey, *ax, *ay, err = 0.0;
+
+    buf = (double *) pj_malloc( sizeof(double) * 4 * count );
+    if( buf == NULL )
+        return HUGE_VAL;
+    ex = buf;
+    ey = ex + count;
+    ax = ey + count;
+    ay = ax + count;
+
+    for( k = 0, j = 0; j <= steps; j++ )
+    {
+        for( i = 0; i <= steps; i++, k++ )
+        {
+            ex[k] = ax[k] = i == steps ? max.u
+                : min.u + (max.u - min.u) * i / steps;
+            ey[k] = ay[k] = j == steps ? max.v
+                : min.v + (max.v - min.v) * j / steps;
+        }
+    }
+
+    if( inverse )
+        pj_inv_array( P, count, 1, ex, ey );
+    else
+        pj_fwd_array( P, count, 1, ex, ey );
+
+    for( k = 0; k < count; k += APPROX_BLOCK )
+        approx_block( T, count - k < APPROX_BLOCK ? (int) (count - k)
+                      : APPROX_BLOCK, 1, ax + k, ay + k );
+
+    for( k = 0; k < count && err != HUGE_VAL; k++ )
+    {
+        if( ex[k] == HUGE_VAL || ax[k] == HUGE_VAL )
+            err = HUGE_VAL;
+        else
+        {
+            if( fabs(ex[k] - ax[k]) > err )
+                err = fabs(ex[k] - ax[k]);
+            if( fabs(ey[k] - ay[k]) > err )
+                err = fabs(ey[k] - ay[k]);
+        }
+    }
+
+    pj_dalloc( buf );
+
+    return err;
+}
+
+/************************************************************************/
+/*                          pj_approx_create()                          */
+/*                                                                      */
+/*      Approximate the forward projection of P over the long/lat      */
+/*      rectangle min to max (radians), or the inverse over the         */
+/*      projected rectangle if inverse is set, to within max_error      */
+/*      in the output units.  Returns NULL, with the context errno      */
+/*      set, if the projection fails in the region or the error         */
+/*      cannot be met.  The approximation does not refer to P.          */
+/************************************************************************/
+
+PJ_APPROX *pj_approx_create( PJ *P, int inverse, projUV min, projUV max,
+                             double max_error )
+
+{
+    PJ_APPROX *approx;
+    Tseries   *T = NULL;
+    projUV    resid;
+    FIT_ARGS  args;
+    int       n;
+
+    if( max_error <= 0.0 || !(min.u < max.u) || !(min.v < max.v)
+        || (inverse ? P->inv == NULL : P->fwd == NULL) )
+    {
+        pj_ctx_set_errno( P->ctx, -47 );
+        return NULL;
+    }
+
+    args.P = P;
+    args.inverse = inverse;
+
+    for( n = APPROX_MIN_NODES; n <= APPROX_MAX_NODES; n += n / 2 )
+    {
+        T = mk_cheby_r( min, max, 0.25 * max_error, &resid, 
+                        fit_func, &args, n, n, 0 );
+
+        if( T == NULL )
+            break;
+
+        if( approx_error( P, inverse, T, min, max, n ) <= max_error )
+            break;
+
+        free_series( T );
+        T = NULL;
+    }
+
+    if( T == NULL )
+    {
+        pj_ctx_set_errno( P->ctx, -47 );
+        return NULL;
+    }
+
+    approx = (PJ_APPROX *) pj_malloc( sizeof(PJ_APPROX) );
+    if( approx == NULL )
+    {
+        free_series( T );
+        pj_ctx_set_errno( P->ctx, ENOMEM );
+        return NULL;
+    }
+
+    approx->ctx = P->ctx;
+    approx->T = T;
+
+    return approx;
+}
+
+/************************************************************************/
+/*                           pj_approx_eval()                           */
+/*                                                                      */
+/*      Replace x/y with the approximated projection.  Points outside   */
+/*      the region are set to HUGE_VAL and make the return -36.         */
+/************************************************************************/
+
+int pj_approx_eval( PJ_APPROX *approx, long point_count, int point_offset,
+                    double *x, double *y )
+
+{
+    long   i;
+    int    outside = 0;
+
+    if( point_offset == 0 )
+        point_offset = 1;
+
+    for( i = 0; i < point_count; i += APPROX_BLOCK )
+    {
+        long   io = i * point_offset;
+
+        outside += approx_block( approx->T,
+                                 point_count - i < APPROX_BLOCK
+                                 ? (int) (point_count - i) : APPROX_BLOCK,
+                                 point_offset, x + io, y + io );
+    }
+
+    if( outside )
+    {
+        pj_ctx_set_errno( approx->ctx, -36 );
+        return -36;
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/*                           pj_approx_free()                           */
+/************************************************************************/
+
+void pj_approx_free( PJ_APPROX *approx )
+
+{
+    if( approx == NULL )
+        return;
+
+    free_series( approx->T );
+    pj_dalloc( approx );
+}
@@ -0,0 +1,167 @@
+/* projCtx thread context: per object error state, debug level and logger */
+#include <projects.h>
+#include <string.h>
+
+static projCtx_t default_context;
+static volatile int default_context_initialized = 0;
+
+/************************************************************************/
+/*                             pj_get_ctx()                             */
+/************************************************************************/
+
+projCtx pj_get_ctx( projPJ pj )
+
+{
+    return pj->ctx;
+}
+
+/************************************************************************/
+/*                             pj_set_ctx()                             */
+/*                                                                      */
+/*      Note we do not deallocate the old context!  A projection        */
+/*      wrapped by this one (ob_tran's) reports through it too.         */
+/************************************************************************/
+
+void pj_set_ctx( projPJ pj, projCtx ctx )
+
+{
+    pj->ctx = ctx;
+    if( pj->link != NULL )
+        pj_set_ctx( pj->link, ctx );
+}
+
+/************************************************************************/
+/*                         pj_get_default_ctx()                         */
+/*                                                                      */
+/*      The default context is shared by everything created through     */
+/*      the legacy (non _ctx) entry points.  Its error state is         */
+/*      mirrored into the global pj_errno.                              */
+/************************************************************************/
+
+projCtx pj_get_default_ctx()
+
+{
+    if( default_context_initialized )
+        return &default_context;
+
+    pj_acquire_lock();
+
+    if( !default_context_initialized )
+    {
+        default_context.last_errno = 0;
+        default_context.debug_level = PJ_LOG_NONE;
+        default_context.logger = pj_stderr_logger;
+        default_context.app_data = NULL;
+
+        if( getenv("PROJ_DEBUG") != NULL )
+        {
+            if( atoi(getenv("PROJ_DEBUG")) > 0 )
+                default_context.debug_level = atoi(getenv("PROJ_DEBUG"));
+            else
+                default_context.debug_level = PJ_LOG_DEBUG_MINOR;
+        }
+
+        default_context_initialized = 1;
+    }
+
+    pj_release_lock();
+
+    return &default_context;
+}
+
+/************************************************************************/
+/*                            pj_ctx_alloc()                            */
+/*                                                                      */
+/*      New contexts inherit the debug level and logger of the          */
+/*      default context, but have their own error state.                */
+/************************************************************************/
+
+projCtx pj_ctx_alloc()
+
+{
+    projCtx ctx = (projCtx) pj_malloc(sizeof(projCtx_t));
+
+    if( ctx == NULL )
+        return NULL;
+
+    memcpy( ctx, pj_get_default_ctx(), sizeof(projCtx_t) );
+    ctx->last_errno = 0;
+
+    return ctx;
+}
+
+/************************************************************************/
+/*                            pj_ctx_free()                             */
+/************************************************************************/
+
+void pj_ctx_free( projCtx ctx )
+
+{
+    if( ctx != NULL && ctx != &default_context )
+        pj_dalloc( ctx );
+}
+
+/************************************************************************/
+/*                          pj_ctx_get_errno()                          */
+/************************************************************************/
+
+int pj_ctx_get_errno( projCtx ctx )
+
+{
+    return ctx->last_errno;
+}
+
+/************************************************************************/
+/*                          pj_ctx_set_errno()                          */
+/*                                                                      */
+/*      Only the default context touches the global pj_errno, so        */
+/*      objects bound to their own context never share error state.     */
+/************************************************************************/
+
+void pj_ctx_set_errno( projCtx ctx, int new_errno )
+
+{
+    ctx->last_errno = new_errno;
+    if( ctx == &default_context )
+        pj_errno = new_errno;
+}
+
+/************************************************************************/
+/*                          pj_ctx_set_debug()                          */
+/************************************************************************/
+
+void pj_ctx_set_debug( projCtx ctx, int new_debug )
+
+{
+    ctx->debug_level = new_debug;
+}
+
+/************************************************************************/
+/*                         pj_ctx_set_logger()                          */
+/************************************************************************/
+
+void pj_ctx_set_logger( projCtx ctx, void (*new_logger)(void*,int,const char*) )
+
+{
+    ctx->logger = new_logger;
+}
+
+/************************************************************************/
+/*                        pj_ctx_set_app_data()                         */
+/************************************************************************/
+
+void pj_ctx_set_app_data( projCtx ctx, void *new_app_data )
+
+{
+    ctx->app_data = new_app_data;
+}
+
+/************************************************************************/
+/*                        pj_ctx_get_app_data()                         */
+/************************************************************************/
+
+void *pj_ctx_get_app_data( projCtx ctx )
+
+{
+    return ctx->app_data;
+}
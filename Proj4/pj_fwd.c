@@ -11,9 +11,10 @@ pj_fwd(LP lp, PJ *P) {
 	/* check for forward and latitude or longitude overange */
 	if ((t = fabs(lp.phi)-HALFPI) > EPS || fabs(lp.lam) > 10.) {
 		xy.x = xy.y = HUGE_VAL;
-		pj_errno = -14;
+		pj_ctx_set_errno( P->ctx, -14 );
 	} else { /* proceed with projection */
-		errno = pj_errno = 0;
+		errno = 0;
+		pj_ctx_set_errno( P->ctx, 0 );
 		if (fabs(t) <= EPS)
 			lp.phi = lp.phi < 0. ? -HALFPI : HALFPI;
 		else if (P->geoc)
@@ -22,7 +23,9 @@ pj_fwd(LP lp, PJ *P) {
 		if (!P->over)
 			lp.lam = adjlon(lp.lam); /* adjust del longitude */
 		xy = (*P->fwd)(lp, P); /* project */
-		if (pj_errno || (pj_errno = errno))
+		if (P->ctx->last_errno == 0 && errno != 0)
+			pj_ctx_set_errno( P->ctx, errno );
+		if (P->ctx->last_errno)
 			xy.x = xy.y = HUGE_VAL;
 		/* adjust for major axis and easting/northings */
 		else {
@@ -32,3 +35,74 @@ pj_fwd(LP lp, PJ *P) {
 	}
 	return xy;
 }
+/*
+** Same result as pj_fwd() on each of n points, every stride'th double
+** of x and y, with lam/phi (radians) in and x/y out.  Points that fail are
+** set to HUGE_VAL, points that are HUGE_VAL to begin with are passed
+** through quietly.  Returns 0, or the error of one of the failed points.
+*/
+	int /* forward projection of an array of points, in place */
+pj_fwd_array(PJ *P, long n, int stride, double *x, double *y) {
+	double *lam, *phi, t;
+	double a = P->a, x0 = P->x0, y0 = P->y0, fr_meter = P->fr_meter;
+	long i;
+	int err = 0;
+
+	/* range check and center on lam0 as pj_fwd() does */
+	for (i = 0, lam = x, phi = y; i < n; ++i, lam += stride, phi += stride) {
+		if (*lam == HUGE_VAL) {
+			*phi = HUGE_VAL;
+			continue;
+		}
+		if ((t = fabs(*phi)-HALFPI) > EPS || fabs(*lam) > 10.) {
+			*lam = *phi = HUGE_VAL;
+			err = -14;
+			continue;
+		}
+		if (fabs(t) <= EPS)
+			*phi = *phi < 0. ? -HALFPI : HALFPI;
+		else if (P->geoc)
+			*phi = atan(P->rone_es * tan(*phi));
+		*lam -= P->lam0;
+		if (!P->over)
+			*lam = adjlon(*lam);
+	}
+	/* project, through the batch hook if there is one */
+	errno = 0;
+	pj_ctx_set_errno( P->ctx, 0 );
+	if (P->fwd_n) {
+		(*P->fwd_n)(P, n, stride, x, y);
+		if (P->ctx->last_errno)
+			err = P->ctx->last_errno;
+	} else for (i = 0, lam = x, phi = y; i < n;
+			++i, lam += stride, phi += stride) {
+		LP lp;
+		XY xy;
+
+		if (*lam == HUGE_VAL)
+			continue;
+		lp.lam = *lam;
+		lp.phi = *phi;
+		errno = 0;
+		pj_ctx_set_errno( P->ctx, 0 );
+		xy = (*P->fwd)(lp, P);
+		if (P->ctx->last_errno == 0 && errno != 0)
+			pj_ctx_set_errno( P->ctx, errno );
+		if (P->ctx->last_errno) {
+			err = P->ctx->last_errno;
+			*lam = *phi = HUGE_VAL;
+		} else {
+			*lam = xy.x;
+			*phi = xy.y;
+		}
+	}
+	/* adjust for major axis and easting/northings */
+	for (i = 0, lam = x, phi = y; i < n; ++i, lam += stride, phi += stride) {
+		if (*lam == HUGE_VAL)
+			continue;
+		*lam = fr_meter * (a * *lam + x0);
+		*phi = fr_meter * (a * *phi + y0);
+	}
+	pj_ctx_set_errno( P->ctx, err );
+	return err;
+}
@@ -48,7 +48,7 @@ pj_gauss_ini(double e, double phi0, double *chi, double *rc) {
 	double sphi, cphi, es;
 	struct GAUSS *en;
 
-	if ((en = (struct GAUSS *)malloc(sizeof(struct GAUSS))) == NULL)
+	if ((en = (struct GAUSS *)pj_malloc(sizeof(struct GAUSS))) == NULL)
 		return (NULL);
 	es = e * e;
 	EN->e = e;
@@ -74,7 +74,7 @@ pj_gauss(LP elp, const void *en) {
 	return(slp);
 }
 	LP
-pj_inv_gauss(LP slp, const void *en) {
+pj_inv_gauss(projCtx ctx, LP slp, const void *en) {
 	LP elp;
 	double num;
 	int i;
@@ -89,6 +89,6 @@ pj_inv_gauss(LP slp, const void *en) {
 	}	
 	/* convergence failed */
 	if (!i)
-		pj_errno = -17;
+		pj_ctx_set_errno( ctx, -17 );
 	return (elp);
 }
@@ -0,0 +1,309 @@
+/* Tiled grid shift cache: grids paged in by tiles, bounded by an LRU */
+#define PJ_LIB__
+#include <projects.h>
+#include <string.h>
+#include <errno.h>
+
+/*
+** A grid is split into GRID_TILE x GRID_TILE cell tiles in CTABLE
+** order (rows south to north, columns west to east).  A 64x64 tile of
+** FLP is 32K.  Tiles of all grids share one LRU list, most recently
+** used first, and the least recently used are dropped whenever the
+** total goes over the budget.  Everything here is protected by
+** pj_acquire_gridcache_lock(), a lock of its own since it is taken for
+** every cell looked up.  It may be taken with the PROJ.4 lock held,
+** never the other way round.
+*/
+#ifndef GRID_TILE
+#  define GRID_TILE 64
+#endif
+
+typedef struct GRID_TILE_S {
+    struct GRID_TILE_S *prev, *next;   /* LRU list */
+    struct PJ_GRIDTILES *dir;
+    long         slot;
+    long         size;                 /* bytes in cvs */
+    int          cols;
+    FLP          cvs[1];
+} GRID_TILE_T;
+
+struct PJ_GRIDTILES {
+    char        *filename;
+    const char  *format;
+    long         grid_offset;
+    FILE        *fid;                  /* opened on first tile load */
+    int          tiles_lam, tiles_phi;
+    GRID_TILE_T **slots;
+};
+
+static long cache_max = 0;             /* byte budget, 0 disables tiling */
+static long cache_used = 0;
+static GRID_TILE_T *lru_head = NULL, *lru_tail = NULL;
+
+/************************************************************************/
+/*                      pj_set_grid_cache_size()                        */
+/*                                                                      */
+/*      Set the number of bytes of grid shift values that may be        */
+/*      held in memory.  Grids loaded from then on are paged in by      */
+/*      tile as points need them instead of being read whole.  Zero     */
+/*      (the default) loads grids whole, as before.                     */
+/************************************************************************/
+
+void pj_set_grid_cache_size( long max_bytes )
+
+{
+    pj_acquire_gridcache_lock();
+    cache_max = max_bytes > 0 ? max_bytes : 0;
+    pj_release_gridcache_lock();
+}
+
+/************************************************************************/
+/*                           pj_gridcache_on()                          */
+/************************************************************************/
+
+int pj_gridcache_on()
+
+{
+    return cache_max > 0;
+}
+
+/************************************************************************/
+/*                             lru_unlink()                             */
+/************************************************************************/
+
+static void lru_unlink( GRID_TILE_T *tile )
+
+{
+    if( tile->prev )
+        tile->prev->next = tile->next;
+    else
+        lru_head = tile->next;
+
+    if( tile->next )
+        tile->next->prev = tile->prev;
+    else
+        lru_tail = tile->prev;
+
+    tile->prev = tile->next = NULL;
+}
+
+/************************************************************************/
+/*                              lru_push()                              */
+/************************************************************************/
+
+static void lru_push( GRID_TILE_T *tile )
+
+{
+    tile->prev = NULL;
+    tile->next = lru_head;
+    if( lru_head )
+        lru_head->prev = tile;
+    else
+        lru_tail = tile;
+    lru_head = tile;
+}
+
+/************************************************************************/
+/*                             tile_drop()                              */
+/************************************************************************/
+
+static void tile_drop( GRID_TILE_T *tile )
+
+{
+    lru_unlink( tile );
+    tile->dir->slots[tile->slot] = NULL;
+    cache_used -= tile->size;
+    pj_dalloc( tile );
+}
+
+/************************************************************************/
+/*                             tile_load()                              */
+/*                                                                      */
+/*      Read one tile from the grid file.  Failures are left in ctx.    */
+/************************************************************************/
+
+static GRID_TILE_T *tile_load( projCtx ctx, struct CTABLE *ct, long slot )
+
+{
+    struct PJ_GRIDTILES *dir = ct->tiles;
+    GRID_TILE_T *tile;
+    int     row0, col0, rows, cols, row;
+
+    row0 = (int) (slot / dir->tiles_lam) * GRID_TILE;
+    col0 = (int) (slot % dir->tiles_lam) * GRID_TILE;
+    rows = ct->lim.phi - row0 < GRID_TILE ? ct->lim.phi - row0 : GRID_TILE;
+    cols = ct->lim.lam - col0 < GRID_TILE ? ct->lim.lam - col0 : GRID_TILE;
+
+    if( dir->fid == NULL )
+    {
+        dir->fid = pj_open_lib( ctx, dir->filename, "rb" );
+        if( dir->fid == NULL )
+        {
+            pj_ctx_set_errno( ctx, errno != 0 ? errno : EIO );
+            return NULL;
+        }
+    }
+
+    tile = (GRID_TILE_T *)
+        pj_malloc( sizeof(GRID_TILE_T) + sizeof(FLP) * (rows*cols - 1) );
+    if( tile == NULL )
+    {
+        pj_ctx_set_errno( ctx, ENOMEM );
+        return NULL;
+    }
+
+    for( row = 0; row < rows; row++ )
+    {
+        if( !pj_gridinfo_read_cells( dir->fid, dir->format, dir->grid_offset,
+                                     ct, row0 + row, col0, cols,
+                                     tile->cvs + row * cols ) )
+        {
+            pj_dalloc( tile );
+            pj_ctx_set_errno( ctx, EIO );
+            return NULL;
+        }
+    }
+
+    tile->dir = dir;
+    tile->slot = slot;
+    tile->size = sizeof(FLP) * rows * cols;
+    tile->cols = cols;
+
+    dir->slots[slot] = tile;
+    cache_used += tile->size;
+    lru_push( tile );
+
+    /* make room, but never drop the tile we were asked for */
+    while( cache_used > cache_max && lru_tail != tile )
+        tile_drop( lru_tail );
+
+    return tile;
+}
+
+/************************************************************************/
+/*                          pj_gridcache_cell()                         */
+/*                                                                      */
+/*      Fetch the four corner nodes of the cell whose south west        */
+/*      node is (row,col), in the order f00, f10, f01, f11 as used      */
+/*      by nad_intr().  The corners may fall in up to four tiles.       */
+/*      Values are copied out under the lock, so tiles can be           */
+/*      dropped at any time by other threads.  Returns 0, with the      */
+/*      error in ctx, if a tile could not be read.                      */
+/************************************************************************/
+
+int pj_gridcache_cell( projCtx ctx, struct CTABLE *ct, int row, int col, 
+                       FLP *nodes )
+
+{
+    struct PJ_GRIDTILES *dir = ct->tiles;
+    int  i;
+
+    pj_acquire_gridcache_lock();
+    for( i = 0; i < 4; i++ )
+    {
+        int   r = row + i / 2, c = col + i % 2;
+        long  slot;
+        GRID_TILE_T *tile;
+
+        slot = (long) (r / GRID_TILE) * dir->tiles_lam + c / GRID_TILE;
+        tile = dir->slots[slot];
+        if( tile == NULL )
+        {
+            tile = tile_load( ctx, ct, slot );
+            if( tile == NULL )
+            {
+                pj_release_gridcache_lock();
+                return 0;
+            }
+        }
+        else if( tile != lru_head )
+        {
+            lru_unlink( tile );
+            lru_push( tile );
+        }
+
+        r -= (int) (slot / dir->tiles_lam) * GRID_TILE;
+        c -= (int) (slot % dir->tiles_lam) * GRID_TILE;
+        nodes[i] = tile->cvs[r * tile->cols + c];
+    }
+    pj_release_gridcache_lock();
+
+    return 1;
+}
+
+/************************************************************************/
+/*                         pj_gridcache_attach()                        */
+/*                                                                      */
+/*      Set up tiled access for a grid instead of reading it whole.     */
+/*      Called with the PROJ.4 lock held, from pj_gridinfo_load().      */
+/************************************************************************/
+
+int pj_gridcache_attach( PJ_GRIDINFO *gi )
+
+{
+    struct CTABLE *ct = gi->ct;
+    struct PJ_GRIDTILES *dir;
+    long   slot_count;
+
+    dir = (struct PJ_GRIDTILES *) pj_malloc(sizeof(struct PJ_GRIDTILES));
+    if( dir == NULL )
+        return 0;
+    memset( dir, 0, sizeof(struct PJ_GRIDTILES) );
+
+    dir->tiles_lam = (ct->lim.lam + GRID_TILE - 1) / GRID_TILE;
+    dir->tiles_phi = (ct->lim.phi + GRID_TILE - 1) / GRID_TILE;
+    slot_count = (long) dir->tiles_lam * dir->tiles_phi;
+
+    dir->filename = (char *) pj_malloc(strlen(gi->filename)+1);
+    dir->slots = (GRID_TILE_T **) pj_malloc(sizeof(GRID_TILE_T*) * slot_count);
+    if( dir->filename == NULL || dir->slots == NULL )
+    {
+        pj_dalloc( dir->filename );
+        pj_dalloc( dir->slots );
+        pj_dalloc( dir );
+        return 0;
+    }
+    strcpy( dir->filename, gi->filename );
+    memset( dir->slots, 0, sizeof(GRID_TILE_T*) * slot_count );
+    dir->format = gi->format;
+    dir->grid_offset = strcmp(gi->format,"ctable") == 0
+        ? (long) sizeof(struct CTABLE_HDR) : gi->grid_offset;
+
+    ct->tiles = dir;
+
+    return 1;
+}
+
+/************************************************************************/
+/*                         pj_gridcache_detach()                        */
+/*                                                                      */
+/*      Drop all tiles of a grid, from nad_free().                      */
+/************************************************************************/
+
+void pj_gridcache_detach( struct CTABLE *ct )
+
+{
+    struct PJ_GRIDTILES *dir = ct->tiles;
+    long   slot, slot_count;
+
+    if( dir == NULL )
+        return;
+
+    slot_count = (long) dir->tiles_lam * dir->tiles_phi;
+
+    pj_acquire_gridcache_lock();
+    for( slot = 0; slot < slot_count; slot++ )
+    {
+        if( dir->slots[slot] != NULL )
+            tile_drop( dir->slots[slot] );
+    }
+    pj_release_gridcache_lock();
+
+    if( dir->fid != NULL )
+        fclose( dir->fid );
+    pj_dalloc( dir->filename );
+    pj_dalloc( dir->slots );
+    pj_dalloc( dir );
+
+    ct->tiles = NULL;
+}
@@ -76,6 +76,28 @@ static void swap_words( unsigned char *data, int word_size, int word_count )
     }
 }
 
+/************************************************************************/
+/*                          gridinfo_strdup()                           */
+/*                                                                      */
+/*      strdup() through pj_malloc(), so names are seen by a            */
+/*      replacement allocator.  Release with pj_dalloc().               */
+/************************************************************************/
+
+static char *gridinfo_strdup( const char *s )
+
+{
+    char *copy;
+
+    if( s == NULL )
+        return NULL;
+
+    copy = (char *) pj_malloc( strlen(s) + 1 );
+    if( copy != NULL )
+        strcpy( copy, s );
+
+    return copy;
+}
+
 /************************************************************************/
 /*                          pj_gridinfo_free()                          */
 /************************************************************************/
@@ -100,26 +122,36 @@ void pj_gridinfo_free( PJ_GRIDINFO *gi )
     if( gi->ct != NULL )
         nad_free( gi->ct );
     
-    free( gi->gridname );
-    if( gi->filename != NULL )
-        free( gi->filename );
+    pj_dalloc( gi->gridname );
+    pj_dalloc( gi->filename );
 
     pj_dalloc( gi );
 }
 
 /************************************************************************/
-/*                          pj_gridinfo_load()                          */
+/*                         pj_gridinfo_read()                           */
 /*                                                                      */
-/*      This function is intended to implement delayed loading of       */
-/*      the data contents of a grid file.  The header and related       */
-/*      stuff are loaded by pj_gridinfo_init().                         */
+/*      Read the shift values of a grid.  Called with the lock held.    */
 /************************************************************************/
 
-int pj_gridinfo_load( PJ_GRIDINFO *gi )
+static int pj_gridinfo_read( projCtx ctx, PJ_GRIDINFO *gi )
 
 {
-    if( gi == NULL || gi->ct == NULL )
+/* -------------------------------------------------------------------- */
+/*      With a grid cache budget set, values are paged in by tile as    */
+/*      they are used instead.                                          */
+/* -------------------------------------------------------------------- */
+    if( pj_gridcache_on() && gi->filename != NULL
+        && (strcmp(gi->format,"ctable") == 0
+            || strcmp(gi->format,"ntv1") == 0
+            || strcmp(gi->format,"ntv2") == 0) )
+    {
+        if( pj_gridcache_attach( gi ) )
+            return 1;
+
+        pj_ctx_set_errno( ctx, -38 );
         return 0;
+    }
 
 /* -------------------------------------------------------------------- */
 /*      ctable is currently loaded on initialization though there is    */
@@ -130,15 +162,15 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
         FILE *fid;
         int result;
 
-        fid = pj_open_lib( gi->filename, "rb" );
+        fid = pj_open_lib( ctx, gi->filename, "rb" );
         
         if( fid == NULL )
         {
-            pj_errno = -38;
+            pj_ctx_set_errno( ctx, -38 );
             return 0;
         }
 
-        result = nad_ctable_load( gi->ct, fid );
+        result = nad_ctable_load( ctx, gi->ct, fid );
 
         fclose( fid );
 
@@ -155,24 +187,28 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
     else if( strcmp(gi->format,"ntv1") == 0 )
     {
         double	*row_buf;
+        FLP	*cvs_buf;
         int	row;
         FILE *fid;
 
-        fid = pj_open_lib( gi->filename, "rb" );
+        fid = pj_open_lib( ctx, gi->filename, "rb" );
         
         if( fid == NULL )
         {
-            pj_errno = -38;
+            pj_ctx_set_errno( ctx, -38 );
             return 0;
         }
 
         fseek( fid, gi->grid_offset, SEEK_SET );
 
         row_buf = (double *) pj_malloc(gi->ct->lim.lam * sizeof(double) * 2);
-        gi->ct->cvs = (FLP *) pj_malloc(gi->ct->lim.lam*gi->ct->lim.phi*sizeof(FLP));
-        if( row_buf == NULL || gi->ct->cvs == NULL )
+        cvs_buf = (FLP *) pj_malloc(gi->ct->lim.lam*gi->ct->lim.phi*sizeof(FLP));
+        if( row_buf == NULL || cvs_buf == NULL )
         {
-            pj_errno = -38;
+            pj_dalloc( row_buf );
+            pj_dalloc( cvs_buf );
+            fclose( fid );
+            pj_ctx_set_errno( ctx, -38 );
             return 0;
         }
         
@@ -186,8 +222,9 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
                 != 2 * gi->ct->lim.lam )
             {
                 pj_dalloc( row_buf );
-                pj_dalloc( gi->ct->cvs );
-                pj_errno = -38;
+                pj_dalloc( cvs_buf );
+                fclose( fid );
+                pj_ctx_set_errno( ctx, -38 );
                 return 0;
             }
 
@@ -199,7 +236,7 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
 
             for( i = 0; i < gi->ct->lim.lam; i++ )
             {
-                cvs = gi->ct->cvs + (row) * gi->ct->lim.lam
+                cvs = cvs_buf + (row) * gi->ct->lim.lam
                     + (gi->ct->lim.lam - i - 1);
 
                 cvs->phi = *(diff_seconds++) * ((PI/180.0) / 3600.0);
@@ -211,6 +248,8 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
 
         fclose( fid );
 
+        gi->ct->cvs = cvs_buf;
+
         return 1;
     }
 
@@ -224,29 +263,46 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
     else if( strcmp(gi->format,"ntv2") == 0 )
     {
         float	*row_buf;
+        FLP	*cvs_buf;
         int	row;
         FILE *fid;
 
-        if( getenv("PROJ_DEBUG") != NULL )
-        {
-            fprintf( stderr, "NTv2 - loading grid %s\n", gi->ct->id );
-        }
+        pj_log( ctx, PJ_LOG_DEBUG_MINOR, "NTv2 - loading grid %s", gi->ct->id );
 
-        fid = pj_open_lib( gi->filename, "rb" );
+        fid = pj_open_lib( ctx, gi->filename, "rb" );
         
         if( fid == NULL )
         {
-            pj_errno = -38;
+            pj_ctx_set_errno( ctx, -38 );
             return 0;
         }
 
+        /* on LSB machines the records can be used in place, leaving */
+        /* nad_intr() to convert the few nodes it actually needs.     */
+        if( IS_LSB && sizeof(float) == 4 )
+        {
+            float *ntv2;
+
+            ntv2 = (float *) nad_map_grid( gi->ct, fid, gi->grid_offset,
+                         (size_t) gi->ct->lim.lam * gi->ct->lim.phi * 16 );
+            if( ntv2 != NULL )
+            {
+                fclose( fid );
+                gi->ct->ntv2 = ntv2;
+                return 1;
+            }
+        }
+
         fseek( fid, gi->grid_offset, SEEK_SET );
 
         row_buf = (float *) pj_malloc(gi->ct->lim.lam * sizeof(float) * 4);
-        gi->ct->cvs = (FLP *) pj_malloc(gi->ct->lim.lam*gi->ct->lim.phi*sizeof(FLP));
-        if( row_buf == NULL || gi->ct->cvs == NULL )
+        cvs_buf = (FLP *) pj_malloc(gi->ct->lim.lam*gi->ct->lim.phi*sizeof(FLP));
+        if( row_buf == NULL || cvs_buf == NULL )
         {
-            pj_errno = -38;
+            pj_dalloc( row_buf );
+            pj_dalloc( cvs_buf );
+            fclose( fid );
+            pj_ctx_set_errno( ctx, -38 );
             return 0;
         }
         
@@ -260,9 +316,9 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
                 != 4 * gi->ct->lim.lam )
             {
                 pj_dalloc( row_buf );
-                pj_dalloc( gi->ct->cvs );
-                gi->ct->cvs = NULL;
-                pj_errno = -38;
+                pj_dalloc( cvs_buf );
+                fclose( fid );
+                pj_ctx_set_errno( ctx, -38 );
                 return 0;
             }
 
@@ -275,7 +331,7 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
 
             for( i = 0; i < gi->ct->lim.lam; i++ )
             {
-                cvs = gi->ct->cvs + (row) * gi->ct->lim.lam
+                cvs = cvs_buf + (row) * gi->ct->lim.lam
                     + (gi->ct->lim.lam - i - 1);
 
                 cvs->phi = *(diff_seconds++) * ((PI/180.0) / 3600.0);
@@ -288,6 +344,8 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
 
         fclose( fid );
 
+        gi->ct->cvs = cvs_buf;
+
         return 1;
     }
 
@@ -297,13 +355,113 @@ int pj_gridinfo_load( PJ_GRIDINFO *gi )
     }
 }
 
+/************************************************************************/
+/*                       pj_gridinfo_read_cells()                       */
+/*                                                                      */
+/*      Read count shift values of one row, starting at column col,     */
+/*      converted to CTABLE order and units just as pj_gridinfo_read()  */
+/*      would.  grid_offset is the file offset of the first value.      */
+/************************************************************************/
+
+int pj_gridinfo_read_cells( FILE *fid, const char *format, long grid_offset,
+                            struct CTABLE *ct, int row, int col, int count,
+                            FLP *cvs )
+
+{
+    unsigned char buf[16 * 64];
+    int     done, first;
+
+    if( strcmp(format,"ctable") == 0 )
+    {
+        fseek( fid, grid_offset
+               + ((long) row * ct->lim.lam + col) * sizeof(FLP), SEEK_SET );
+        return fread( cvs, sizeof(FLP), count, fid ) == count;
+    }
+
+    /* NTv1 and NTv2 run east to west, 16 bytes a node */
+    first = ct->lim.lam - col - count;
+    fseek( fid, grid_offset + ((long) row * ct->lim.lam + first) * 16,
+           SEEK_SET );
+
+    for( done = 0; done < count; )
+    {
+        int  n = count - done, i;
+
+        if( n > (int) sizeof(buf) / 16 )
+            n = sizeof(buf) / 16;
+
+        if( fread( buf, 16, n, fid ) != n )
+            return 0;
+
+        for( i = 0; i < n; i++ )
+        {
+            FLP *out = cvs + count - 1 - (done + i);
+
+            if( strcmp(format,"ntv1") == 0 )
+            {
+                double  diff_seconds[2];
+
+                if( IS_LSB )
+                    swap_words( buf + i*16, 8, 2 );
+                memcpy( diff_seconds, buf + i*16, 16 );
+                out->phi = diff_seconds[0] * ((PI/180.0) / 3600.0);
+                out->lam = diff_seconds[1] * ((PI/180.0) / 3600.0);
+            }
+            else
+            {
+                float   diff_seconds[2];
+
+                if( !IS_LSB )
+                    swap_words( buf + i*16, 4, 2 );
+                memcpy( diff_seconds, buf + i*16, 8 );
+                out->phi = diff_seconds[0] * ((PI/180.0) / 3600.0);
+                out->lam = diff_seconds[1] * ((PI/180.0) / 3600.0);
+            }
+        }
+
+        done += n;
+    }
+
+    return 1;
+}
+
+/************************************************************************/
+/*                          pj_gridinfo_load()                          */
+/*                                                                      */
+/*      This function is intended to implement delayed loading of       */
+/*      the data contents of a grid file.  The header and related       */
+/*      stuff are loaded by pj_gridinfo_init().                         */
+/*                                                                      */
+/*      Grids are shared between threads, so the load is serialized     */
+/*      and ct->cvs (or ct->ntv2, ct->tiles) is only set once the       */
+/*      values are all read.                                            */
+/************************************************************************/
+
+int pj_gridinfo_load( projCtx ctx, PJ_GRIDINFO *gi )
+
+{
+    int result;
+
+    if( gi == NULL || gi->ct == NULL )
+        return 0;
+
+    pj_acquire_lock();
+    if( gi->ct->cvs != NULL || gi->ct->ntv2 != NULL || gi->ct->tiles != NULL )
+        result = 1;
+    else
+        result = pj_gridinfo_read( ctx, gi );
+    pj_release_lock();
+
+    return result;
+}
+
 /************************************************************************/
 /*                       pj_gridinfo_init_ntv2()                        */
 /*                                                                      */
 /*      Load a ntv2 (.gsb) file.                                        */
 /************************************************************************/
 
-static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
+static int pj_gridinfo_init_ntv2( projCtx ctx, FILE *fid, PJ_GRIDINFO *gilist )
 
 {
     unsigned char header[11*16];
@@ -313,9 +471,9 @@ static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
     assert( sizeof(double) == 8 );
     if( sizeof(int) != 4 || sizeof(double) != 8 )
     {
-        fprintf( stderr, 
-                 "basic types of inappropraiate size in pj_gridinfo_init_ntv2()\n" );
-        pj_errno = -38;
+        pj_log( ctx, PJ_LOG_ERROR,
+                "basic types of inappropraiate size in pj_gridinfo_init_ntv2()" );
+        pj_ctx_set_errno( ctx, -38 );
         return 0;
     }
 
@@ -324,7 +482,7 @@ static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
 /* -------------------------------------------------------------------- */
     if( fread( header, sizeof(header), 1, fid ) != 1 )
     {
-        pj_errno = -38;
+        pj_ctx_set_errno( ctx, -38 );
         return 0;
     }
 
@@ -362,13 +520,13 @@ static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
 /* -------------------------------------------------------------------- */
         if( fread( header, sizeof(header), 1, fid ) != 1 )
         {
-            pj_errno = -38;
+            pj_ctx_set_errno( ctx, -38 );
             return 0;
         }
 
         if( strncmp((const char *) header,"SUB_NAME",8) != 0 )
         {
-            pj_errno = -38;
+            pj_ctx_set_errno( ctx, -38 );
             return 0;
         }
         
@@ -390,6 +548,7 @@ static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
 /*      Initialize a corresponding "ct" structure.                      */
 /* -------------------------------------------------------------------- */
         ct = (struct CTABLE *) pj_malloc(sizeof(struct CTABLE));
+        memset( ct, 0, sizeof(struct CTABLE) );
         strncpy( ct->id, (const char *) header + 8, 8 );
         ct->id[8] = '\0';
 
@@ -405,13 +564,12 @@ static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
         ct->lim.lam = (int) (fabs(ur.lam-ct->ll.lam)/ct->del.lam + 0.5) + 1;
         ct->lim.phi = (int) (fabs(ur.phi-ct->ll.phi)/ct->del.phi + 0.5) + 1;
 
-        if( getenv("PROJ_DEBUG") != NULL )
-            fprintf( stderr, 
-                     "NTv2 %s %dx%d: LL=(%.9g,%.9g) UR=(%.9g,%.9g)\n",
-                     ct->id, 
-                     ct->lim.lam, ct->lim.phi,
-                     ct->ll.lam/3600.0, ct->ll.phi/3600.0,
-                     ur.lam/3600.0, ur.phi/3600.0 );
+        pj_log( ctx, PJ_LOG_DEBUG_MINOR,
+                "NTv2 %s %dx%d: LL=(%.9g,%.9g) UR=(%.9g,%.9g)",
+                ct->id, 
+                ct->lim.lam, ct->lim.phi,
+                ct->ll.lam/3600.0, ct->ll.phi/3600.0,
+                ur.lam/3600.0, ur.phi/3600.0 );
 
         ct->ll.lam *= DEG_TO_RAD/3600.0;
         ct->ll.phi *= DEG_TO_RAD/3600.0;
@@ -421,11 +579,11 @@ static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
         memcpy( &gs_count, header + 8 + 16*10, 4 );
         if( gs_count != ct->lim.lam * ct->lim.phi )
         {
-            fprintf( stderr, 
-                     "GS_COUNT(%d) does not match expected cells (%dx%d=%d)\n",
-                     gs_count, ct->lim.lam, ct->lim.phi, 
-                     ct->lim.lam * ct->lim.phi );
-            pj_errno = -38;
+            pj_log( ctx, PJ_LOG_ERROR,
+                    "GS_COUNT(%d) does not match expected cells (%dx%d=%d)",
+                    gs_count, ct->lim.lam, ct->lim.phi, 
+                    ct->lim.lam * ct->lim.phi );
+            pj_ctx_set_errno( ctx, -38 );
             return 0;
         }
 
@@ -442,8 +600,8 @@ static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
             gi = (PJ_GRIDINFO *) pj_malloc(sizeof(PJ_GRIDINFO));
             memset( gi, 0, sizeof(PJ_GRIDINFO) );
     
-            gi->gridname = strdup( gilist->gridname );
-            gi->filename = strdup( gilist->filename );
+            gi->gridname = gridinfo_strdup( gilist->gridname );
+            gi->filename = gridinfo_strdup( gilist->filename );
             gi->next = NULL;
         }
 
@@ -476,10 +634,9 @@ static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
 
             if( gp == NULL )
             {
-                if( getenv("PROJ_DEBUG") != NULL )
-                    fprintf( stderr, "pj_gridinfo_init_ntv2(): "
-                             "failed to find parent %8.8s for %s.\n", 
-                             (const char *) header+24, gi->ct->id );
+                pj_log( ctx, PJ_LOG_DEBUG_MAJOR, "pj_gridinfo_init_ntv2(): "
+                        "failed to find parent %8.8s for %s.", 
+                        (const char *) header+24, gi->ct->id );
 
                 for( lnk = gp; lnk->next != NULL; lnk = lnk->next ) {}
                 lnk->next = gi;
@@ -510,7 +667,7 @@ static int pj_gridinfo_init_ntv2( FILE *fid, PJ_GRIDINFO *gilist )
 /*      Load an NTv1 style Canadian grid shift file.                    */
 /************************************************************************/
 
-static int pj_gridinfo_init_ntv1( FILE * fid, PJ_GRIDINFO *gi )
+static int pj_gridinfo_init_ntv1( projCtx ctx, FILE * fid, PJ_GRIDINFO *gi )
 
 {
     unsigned char header[176];
@@ -521,9 +678,9 @@ static int pj_gridinfo_init_ntv1( FILE * fid, PJ_GRIDINFO *gi )
     assert( sizeof(double) == 8 );
     if( sizeof(int) != 4 || sizeof(double) != 8 )
     {
-        fprintf( stderr, 
-                 "basic types of inappropraiate size in nad_load_ntv1()\n" );
-        pj_errno = -38;
+        pj_log( ctx, PJ_LOG_ERROR,
+                "basic types of inappropraiate size in nad_load_ntv1()" );
+        pj_ctx_set_errno( ctx, -38 );
         return 0;
     }
 
@@ -532,7 +689,7 @@ static int pj_gridinfo_init_ntv1( FILE * fid, PJ_GRIDINFO *gi )
 /* -------------------------------------------------------------------- */
     if( fread( header, sizeof(header), 1, fid ) != 1 )
     {
-        pj_errno = -38;
+        pj_ctx_set_errno( ctx, -38 );
         return 0;
     }
 
@@ -552,8 +709,9 @@ static int pj_gridinfo_init_ntv1( FILE * fid, PJ_GRIDINFO *gi )
 
     if( *((int *) (header+8)) != 12 )
     {
-        pj_errno = -38;
-        printf("NTv1 grid shift file has wrong record count, corrupt?\n");
+        pj_ctx_set_errno( ctx, -38 );
+        pj_log( ctx, PJ_LOG_ERROR,
+                "NTv1 grid shift file has wrong record count, corrupt?" );
         return 0;
     }
 
@@ -561,6 +719,7 @@ static int pj_gridinfo_init_ntv1( FILE * fid, PJ_GRIDINFO *gi )
 /*      Fill in CTABLE structure.                                       */
 /* -------------------------------------------------------------------- */
     ct = (struct CTABLE *) pj_malloc(sizeof(struct CTABLE));
+    memset( ct, 0, sizeof(struct CTABLE) );
     strcpy( ct->id, "NTv1 Grid Shift File" );
 
     ct->ll.lam = - *((double *) (header+72));
@@ -572,11 +731,10 @@ static int pj_gridinfo_init_ntv1( FILE * fid, PJ_GRIDINFO *gi )
     ct->lim.lam = (int) (fabs(ur.lam-ct->ll.lam)/ct->del.lam + 0.5) + 1;
     ct->lim.phi = (int) (fabs(ur.phi-ct->ll.phi)/ct->del.phi + 0.5) + 1;
 
-    if( getenv("PROJ_DEBUG") != NULL )
-        fprintf( stderr, 
-                 "NTv1 %dx%d: LL=(%.9g,%.9g) UR=(%.9g,%.9g)\n",
-                 ct->lim.lam, ct->lim.phi,
-                 ct->ll.lam, ct->ll.phi, ur.lam, ur.phi );
+    pj_log( ctx, PJ_LOG_DEBUG_MINOR,
+            "NTv1 %dx%d: LL=(%.9g,%.9g) UR=(%.9g,%.9g)",
+            ct->lim.lam, ct->lim.phi,
+            ct->ll.lam, ct->ll.phi, ur.lam, ur.phi );
 
     ct->ll.lam *= DEG_TO_RAD;
     ct->ll.phi *= DEG_TO_RAD;
@@ -600,7 +758,7 @@ static int pj_gridinfo_init_ntv1( FILE * fid, PJ_GRIDINFO *gi )
 /*      applications.                                                   */
 /************************************************************************/
 
-PJ_GRIDINFO *pj_gridinfo_init( const char *gridname )
+PJ_GRIDINFO *pj_gridinfo_init( projCtx ctx, const char *gridname )
 
 {
     char 	fname[MAX_PATH_FILENAME+1];
@@ -608,7 +766,8 @@ PJ_GRIDINFO *pj_gridinfo_init( const char *gridname )
     FILE 	*fp;
     char	header[160];
 
-    errno = pj_errno = 0;
+    errno = 0;
+    pj_ctx_set_errno( ctx, 0 );
 
 /* -------------------------------------------------------------------- */
 /*      Initialize a GRIDINFO with stub info we would use if it         */
@@ -617,7 +776,7 @@ PJ_GRIDINFO *pj_gridinfo_init( const char *gridname )
     gilist = (PJ_GRIDINFO *) pj_malloc(sizeof(PJ_GRIDINFO));
     memset( gilist, 0, sizeof(PJ_GRIDINFO) );
     
-    gilist->gridname = strdup( gridname );
+    gilist->gridname = gridinfo_strdup( gridname );
     gilist->filename = NULL;
     gilist->format = "missing";
     gilist->grid_offset = 0;
@@ -628,12 +787,12 @@ PJ_GRIDINFO *pj_gridinfo_init( const char *gridname )
 /*      Open the file using the usual search rules.                     */
 /* -------------------------------------------------------------------- */
     strcpy(fname, gridname);
-    if (!(fp = pj_open_lib(fname, "rb"))) {
-        pj_errno = errno;
+    if (!(fp = pj_open_lib(ctx, fname, "rb"))) {
+        pj_ctx_set_errno( ctx, errno );
         return gilist;
     }
 
-    gilist->filename = strdup(fname);
+    gilist->filename = gridinfo_strdup( fname );
     
 /* -------------------------------------------------------------------- */
 /*      Load a header, to determine the file type.                      */
@@ -641,7 +800,7 @@ PJ_GRIDINFO *pj_gridinfo_init( const char *gridname )
     if( fread( header, sizeof(header), 1, fp ) != 1 )
     {
         fclose( fp );
-        pj_errno = -38;
+        pj_ctx_set_errno( ctx, -38 );
         return gilist;
     }
 
@@ -654,30 +813,30 @@ PJ_GRIDINFO *pj_gridinfo_init( const char *gridname )
         && strncmp(header + 96, "W GRID", 6) == 0 
         && strncmp(header + 144, "TO      NAD83   ", 16) == 0 )
     {
-        pj_gridinfo_init_ntv1( fp, gilist );
+        pj_gridinfo_init_ntv1( ctx, fp, gilist );
     }
     
     else if( strncmp(header + 0, "NUM_OREC", 8) == 0 
              && strncmp(header + 48, "GS_TYPE", 7) == 0 )
     {
-        pj_gridinfo_init_ntv2( fp, gilist );
+        pj_gridinfo_init_ntv2( ctx, fp, gilist );
     }
     
     else
     {
-        struct CTABLE *ct = nad_ctable_init( fp );
+        struct CTABLE *ct = nad_ctable_init( ctx, fp );
 
         gilist->format = "ctable";
         gilist->ct = ct;
 
-        if( getenv("PROJ_DEBUG") != NULL )
-            fprintf( stderr, 
-                     "Ctable %s %dx%d: LL=(%.9g,%.9g) UR=(%.9g,%.9g)\n",
-                     ct->id, 
-                     ct->lim.lam, ct->lim.phi,
-                     ct->ll.lam * RAD_TO_DEG, ct->ll.phi * RAD_TO_DEG,
-                     (ct->ll.lam + (ct->lim.lam-1)*ct->del.lam) * RAD_TO_DEG, 
-                     (ct->ll.phi + (ct->lim.phi-1)*ct->del.phi) * RAD_TO_DEG );
+        if( ct != NULL )
+            pj_log( ctx, PJ_LOG_DEBUG_MINOR,
+                    "Ctable %s %dx%d: LL=(%.9g,%.9g) UR=(%.9g,%.9g)",
+                    ct->id, 
+                    ct->lim.lam, ct->lim.phi,
+                    ct->ll.lam * RAD_TO_DEG, ct->ll.phi * RAD_TO_DEG,
+                    (ct->ll.lam + (ct->lim.lam-1)*ct->del.lam) * RAD_TO_DEG, 
+                    (ct->ll.phi + (ct->lim.phi-1)*ct->del.phi) * RAD_TO_DEG );
     }
 
     fclose(fp);
@@ -46,12 +46,299 @@
 
 static PJ_GRIDINFO *grid_list = NULL;
 
-/* used only by pj_load_nadgrids() and pj_deallocate_grids() */
+/* 
+** Grid lists built by pj_gridlist_get(), one per distinct nadgrids
+** string.  Lists and their indexes are never modified once built
+** since other threads may be using them; they are only freed by
+** pj_deallocate_grids().
+*/
 
-static int           last_nadgrids_max = 0;
-static int           last_nadgrids_count = 0;
-static PJ_GRIDINFO **last_nadgrids_list = NULL;
-static char         *last_nadgrids = NULL;
+static PJ_GRIDLIST *gridlist_cache = NULL;
+
+/* bumped whenever the lists are freed, so PJs drop their references */
+static int gridlist_generation = 1;
+
+/* limit on buckets along each axis of a PJ_GRIDSET */
+#define MAX_BUCKETS 64
+
+/************************************************************************/
+/*                           grid_contains()                            */
+/*                                                                      */
+/*      Same extent test pj_apply_gridshift() has always used.          */
+/************************************************************************/
+
+static int grid_contains( struct CTABLE *ct, LP p )
+
+{
+    return !( ct->ll.phi > p.phi || ct->ll.lam > p.lam
+              || ct->ll.phi + (ct->lim.phi-1) * ct->del.phi < p.phi
+              || ct->ll.lam + (ct->lim.lam-1) * ct->del.lam < p.lam );
+}
+
+/************************************************************************/
+/*                           gridset_bucket()                           */
+/*                                                                      */
+/*      Bucket number along one axis.  Monotonic in v, so a grid        */
+/*      whose extent holds v is always filed in v's bucket.             */
+/************************************************************************/
+
+static int gridset_bucket( double v, double origin, double del, int n )
+
+{
+    double b = floor( (v - origin) / del );
+
+    if( b < 0 )
+        return 0;
+    if( b > n - 1 )
+        return n - 1;
+    return (int) b;
+}
+
+/************************************************************************/
+/*                            gridset_free()                            */
+/************************************************************************/
+
+static void gridset_free( PJ_GRIDSET *set )
+
+{
+    if( set == NULL )
+        return;
+
+    pj_dalloc( set->grids );
+    pj_dalloc( set->solo );
+    pj_dalloc( set->start );
+    pj_dalloc( set->items );
+}
+
+/************************************************************************/
+/*                          gridset_buckets()                           */
+/*                                                                      */
+/*      Range of buckets touched by the extent of a grid.               */
+/************************************************************************/
+
+static void gridset_buckets( PJ_GRIDSET *set, struct CTABLE *ct,
+                             int *x0, int *x1, int *y0, int *y1 )
+
+{
+    *x0 = gridset_bucket( ct->ll.lam, set->ll.lam, set->del.lam, set->nx );
+    *x1 = gridset_bucket( ct->ll.lam + (ct->lim.lam-1) * ct->del.lam,
+                          set->ll.lam, set->del.lam, set->nx );
+    *y0 = gridset_bucket( ct->ll.phi, set->ll.phi, set->del.phi, set->ny );
+    *y1 = gridset_bucket( ct->ll.phi + (ct->lim.phi-1) * ct->del.phi,
+                          set->ll.phi, set->del.phi, set->ny );
+}
+
+/************************************************************************/
+/*                           gridset_build()                            */
+/*                                                                      */
+/*      File each grid in every bucket its extent touches, over a       */
+/*      uniform bucket layout covering all of them.                     */
+/************************************************************************/
+
+static int gridset_build( PJ_GRIDSET *set, PJ_GRIDINFO **grids, int count )
+
+{
+    LP   ur;
+    int  i, j, n, buckets, *fill;
+
+    memset( set, 0, sizeof(PJ_GRIDSET) );
+    set->count = count;
+    set->grids = (PJ_GRIDINFO **) pj_malloc(sizeof(void*) * (count+1));
+    set->solo = (unsigned char *) pj_malloc(count+1);
+    if( set->grids == NULL || set->solo == NULL )
+        return 0;
+    memcpy( set->grids, grids, sizeof(void*) * count );
+
+/* -------------------------------------------------------------------- */
+/*      Union of the extents, and which grids are never shadowed by     */
+/*      an earlier one.                                                 */
+/* -------------------------------------------------------------------- */
+    ur.lam = ur.phi = 0.0;
+    for( i = 0; i < count; i++ )
+    {
+        struct CTABLE *ct = grids[i]->ct;
+        LP   gur;
+
+        gur.lam = ct->ll.lam + (ct->lim.lam-1) * ct->del.lam;
+        gur.phi = ct->ll.phi + (ct->lim.phi-1) * ct->del.phi;
+
+        if( i == 0 || ct->ll.lam < set->ll.lam ) set->ll.lam = ct->ll.lam;
+        if( i == 0 || ct->ll.phi < set->ll.phi ) set->ll.phi = ct->ll.phi;
+        if( i == 0 || gur.lam > ur.lam ) ur.lam = gur.lam;
+        if( i == 0 || gur.phi > ur.phi ) ur.phi = gur.phi;
+
+        set->solo[i] = 1;
+        for( j = 0; j < i; j++ )
+        {
+            struct CTABLE *ct1 = grids[j]->ct;
+
+            if( ct1->ll.lam <= gur.lam && ct1->ll.phi <= gur.phi
+                && ct->ll.lam <= ct1->ll.lam + (ct1->lim.lam-1)*ct1->del.lam
+                && ct->ll.phi <= ct1->ll.phi + (ct1->lim.phi-1)*ct1->del.phi )
+            {
+                set->solo[i] = 0;
+                break;
+            }
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Roughly two buckets a side per grid.                            */
+/* -------------------------------------------------------------------- */
+    for( n = 1; n * n < count * 4 && n < MAX_BUCKETS; n++ ) {}
+    set->nx = set->ny = n;
+    set->del.lam = (ur.lam - set->ll.lam) / n;
+    set->del.phi = (ur.phi - set->ll.phi) / n;
+    if( !(set->del.lam > 0) || !(set->del.phi > 0) )
+    {
+        set->nx = set->ny = 1;
+        set->del.lam = set->del.phi = 1.0;
+    }
+    buckets = set->nx * set->ny;
+
+/* -------------------------------------------------------------------- */
+/*      Count bucket sizes into start[b+1], turn them into offsets,     */
+/*      then fill.  Grids are visited in order so each bucket lists     */
+/*      them in search order.                                           */
+/* -------------------------------------------------------------------- */
+    set->start = (int *) pj_malloc(sizeof(int) * (buckets+1));
+    fill = (int *) pj_malloc(sizeof(int) * buckets);
+    if( set->start == NULL || fill == NULL )
+    {
+        pj_dalloc( fill );
+        return 0;
+    }
+    memset( set->start, 0, sizeof(int) * (buckets+1) );
+
+    for( i = 0; i < count; i++ )
+    {
+        int  x0, x1, y0, y1, x, y;
+
+        gridset_buckets( set, grids[i]->ct, &x0, &x1, &y0, &y1 );
+        for( y = y0; y <= y1; y++ )
+            for( x = x0; x <= x1; x++ )
+                set->start[y*set->nx + x + 1]++;
+    }
+
+    for( i = 0; i < buckets; i++ )
+    {
+        set->start[i+1] += set->start[i];
+        fill[i] = set->start[i];
+    }
+
+    set->items = (int *) pj_malloc(sizeof(int) * (set->start[buckets]+1));
+    if( set->items == NULL )
+    {
+        pj_dalloc( fill );
+        return 0;
+    }
+
+    for( i = 0; i < count; i++ )
+    {
+        int  x0, x1, y0, y1, x, y;
+
+        gridset_buckets( set, grids[i]->ct, &x0, &x1, &y0, &y1 );
+        for( y = y0; y <= y1; y++ )
+            for( x = x0; x <= x1; x++ )
+                set->items[fill[y*set->nx + x]++] = i;
+    }
+
+    pj_dalloc( fill );
+
+    return 1;
+}
+
+/************************************************************************/
+/*                           gridset_find()                             */
+/*                                                                      */
+/*      First grid, at or after grid number from, whose extent holds    */
+/*      p.  Returns -1 if there is none.                                */
+/************************************************************************/
+
+static int gridset_find( const PJ_GRIDSET *set, LP p, int from )
+
+{
+    int  x, y, i, end;
+
+    if( p.lam < set->ll.lam || p.phi < set->ll.phi )
+        return -1;
+
+    x = gridset_bucket( p.lam, set->ll.lam, set->del.lam, set->nx );
+    y = gridset_bucket( p.phi, set->ll.phi, set->del.phi, set->ny );
+
+    end = set->start[y*set->nx + x + 1];
+    for( i = set->start[y*set->nx + x]; i < end; i++ )
+    {
+        int  g = set->items[i];
+
+        if( g >= from && grid_contains( set->grids[g]->ct, p ) )
+            return g;
+    }
+
+    return -1;
+}
+
+/************************************************************************/
+/*                          gridlist_index()                            */
+/*                                                                      */
+/*      Build the indexes of a completed grid list.                     */
+/************************************************************************/
+
+static void gridlist_index( PJ_GRIDLIST *gl )
+
+{
+    PJ_GRIDSET *tables, *children;
+    int  i, built = 0;
+
+    tables = (PJ_GRIDSET *) pj_malloc(sizeof(PJ_GRIDSET));
+    children = (PJ_GRIDSET *) pj_malloc(sizeof(PJ_GRIDSET) * (gl->count+1));
+    if( tables == NULL || children == NULL )
+    {
+        pj_dalloc( tables );
+        pj_dalloc( children );
+        return;
+    }
+    memset( tables, 0, sizeof(PJ_GRIDSET) );
+    memset( children, 0, sizeof(PJ_GRIDSET) * (gl->count+1) );
+
+    if( gridset_build( tables, gl->list, gl->count ) )
+    {
+        for( built = 0; built < gl->count; built++ )
+        {
+            PJ_GRIDINFO *child, **list;
+            int  n = 0, ok;
+
+            for( child = gl->list[built]->child; child; child = child->next )
+                n++;
+
+            list = (PJ_GRIDINFO **) pj_malloc(sizeof(void*) * (n+1));
+            if( list == NULL )
+                break;
+
+            n = 0;
+            for( child = gl->list[built]->child; child; child = child->next )
+                list[n++] = child;
+
+            ok = gridset_build( children + built, list, n );
+            pj_dalloc( list );
+            if( !ok )
+                break;
+        }
+    }
+
+    if( built < gl->count )
+    {
+        for( i = 0; i <= built && i < gl->count; i++ )
+            gridset_free( children + i );
+        gridset_free( tables );
+        pj_dalloc( tables );
+        pj_dalloc( children );
+        return;
+    }
+
+    gl->children = children;
+    gl->tables = tables;
+}
 
 /************************************************************************/
 /*                        pj_deallocate_grids()                         */
@@ -62,6 +349,8 @@ static char         *last_nadgrids = NULL;
 void pj_deallocate_grids()
 
 {
+    gridlist_generation++;
+
     while( grid_list != NULL )
     {
         PJ_GRIDINFO *item = grid_list;
@@ -71,27 +360,50 @@ void pj_deallocate_grids()
         pj_gridinfo_free( item );
     }
 
-    if( last_nadgrids != NULL )
+    while( gridlist_cache != NULL )
     {
-        pj_dalloc( last_nadgrids );
-        last_nadgrids = NULL;
+        PJ_GRIDLIST *entry = gridlist_cache;
+        gridlist_cache = entry->next;
 
-        pj_dalloc( last_nadgrids_list );
-        last_nadgrids_list = NULL;
+        if( entry->tables != NULL )
+        {
+            int i;
+
+            for( i = 0; i < entry->count; i++ )
+                gridset_free( entry->children + i );
+            gridset_free( entry->tables );
+            pj_dalloc( entry->children );
+            pj_dalloc( entry->tables );
+        }
 
-        last_nadgrids_count = 0;
-        last_nadgrids_max = 0;
+        pj_dalloc( entry->nadgrids );
+        pj_dalloc( entry->list );
+        pj_dalloc( entry );
     }
 }
 
+/************************************************************************/
+/*                       pj_gridlist_generation()                       */
+/*                                                                      */
+/*      A PJ_GRIDLIST fetched while this returned the same value is     */
+/*      still valid.                                                    */
+/************************************************************************/
+
+int pj_gridlist_generation()
+
+{
+    return gridlist_generation;
+}
+
 /************************************************************************/
 /*                       pj_gridlist_merge_grid()                       */
 /*                                                                      */
 /*      Find/load the named gridfile and merge it into the              */
-/*      last_nadgrids_list.                                             */
+/*      grid list being built.                                          */
 /************************************************************************/
 
-static int pj_gridlist_merge_gridfile( const char *gridname )
+static int pj_gridlist_merge_gridfile( projCtx ctx, PJ_GRIDLIST *entry,
+                                       const char *gridname )
 
 {
     int i, got_match=0;
@@ -113,26 +425,26 @@ static int pj_gridlist_merge_gridfile( const char *gridname )
                 return 0;
 
             /* do we need to grow the list? */
-            if( last_nadgrids_count >= last_nadgrids_max - 2 )
+            if( entry->count >= entry->max - 2 )
             {
                 PJ_GRIDINFO **new_list;
-                int new_max = last_nadgrids_max + 20;
+                int new_max = entry->max + 20;
 
                 new_list = (PJ_GRIDINFO **) pj_malloc(sizeof(void*) * new_max);
-                if( last_nadgrids_list != NULL )
+                if( entry->list != NULL )
                 {
-                    memcpy( new_list, last_nadgrids_list, 
-                            sizeof(void*) * last_nadgrids_max );
-                    pj_dalloc( last_nadgrids_list );
+                    memcpy( new_list, entry->list, 
+                            sizeof(void*) * entry->max );
+                    pj_dalloc( entry->list );
                 }
 
-                last_nadgrids_list = new_list;
-                last_nadgrids_max = new_max;
+                entry->list = new_list;
+                entry->max = new_max;
             }
 
             /* add to the list */
-            last_nadgrids_list[last_nadgrids_count++] = this_grid;
-            last_nadgrids_list[last_nadgrids_count] = NULL;
+            entry->list[entry->count++] = this_grid;
+            entry->list[entry->count] = NULL;
         }
 
         tail = this_grid;
@@ -144,7 +456,7 @@ static int pj_gridlist_merge_gridfile( const char *gridname )
 /* -------------------------------------------------------------------- */
 /*      Try to load the named grid.                                     */
 /* -------------------------------------------------------------------- */
-    this_grid = pj_gridinfo_init( gridname );
+    this_grid = pj_gridinfo_init( ctx, gridname );
 
     if( this_grid == NULL )
     {
@@ -161,52 +473,64 @@ static int pj_gridlist_merge_gridfile( const char *gridname )
 /* -------------------------------------------------------------------- */
 /*      Recurse to add the grid now that it is loaded.                  */
 /* -------------------------------------------------------------------- */
-    return pj_gridlist_merge_gridfile( gridname );
+    return pj_gridlist_merge_gridfile( ctx, entry, gridname );
 }
 
 /************************************************************************/
-/*                     pj_gridlist_from_nadgrids()                      */
+/*                          pj_gridlist_get()                           */
 /*                                                                      */
 /*      This functions loads the list of grids corresponding to a       */
 /*      particular nadgrids string into a list, and returns it.  The    */
-/*      list is kept around till a request is made with a different     */
-/*      string in order to cut down on the string parsing cost, and     */
-/*      the cost of building the list of tables each time.              */
+/*      list is kept around so later requests with the same string      */
+/*      avoid the string parsing cost, and the cost of building the     */
+/*      list of tables each time.                                       */
+/*                                                                      */
+/*      A spatial index of the list is built once it is complete, for   */
+/*      pj_gridlist_find().                                             */
 /************************************************************************/
 
-PJ_GRIDINFO **pj_gridlist_from_nadgrids( const char *nadgrids, int *grid_count)
+PJ_GRIDLIST *pj_gridlist_get( projCtx ctx, const char *nadgrids )
 
 {
     const char *s;
+    PJ_GRIDLIST *entry;
 
-    pj_errno = 0;
-    *grid_count = 0;
+    pj_ctx_set_errno( ctx, 0 );
 
     pj_acquire_lock();
-    if( last_nadgrids != NULL 
-        && strcmp(nadgrids,last_nadgrids) == 0 )
+    for( entry = gridlist_cache; entry != NULL; entry = entry->next )
     {
-        PJ_GRIDINFO **ret = last_nadgrids_list;
-        *grid_count = last_nadgrids_count;
-        if( *grid_count == 0 )
-            pj_errno = -38;
+        if( strcmp(nadgrids,entry->nadgrids) == 0 )
+        {
+            if( entry->count == 0 )
+                pj_ctx_set_errno( ctx, -38 );
 
-        pj_release_lock();
-        return ret;
+            /* an earlier attempt may have given up part way */
+            if( entry->tables == NULL && entry->count > 0 )
+                gridlist_index( entry );
+
+            pj_release_lock();
+            return entry;
+        }
     }
 
 /* -------------------------------------------------------------------- */
-/*      Free old one, if any, and make space for new list.              */
+/*      Make space for new list.                                        */
 /* -------------------------------------------------------------------- */
-    if( last_nadgrids != NULL )
+    entry = (PJ_GRIDLIST *) pj_malloc(sizeof(PJ_GRIDLIST));
+    if( entry == NULL )
     {
-        pj_dalloc(last_nadgrids);
+        pj_ctx_set_errno( ctx, -38 );
+        pj_release_lock();
+        return NULL;
     }
-    
-    last_nadgrids = (char *) pj_malloc(strlen(nadgrids)+1);
-    strcpy( last_nadgrids, nadgrids );
+    memset( entry, 0, sizeof(PJ_GRIDLIST) );
 
-    last_nadgrids_count = 0;
+    entry->nadgrids = (char *) pj_malloc(strlen(nadgrids)+1);
+    strcpy( entry->nadgrids, nadgrids );
+
+    entry->next = gridlist_cache;
+    gridlist_cache = entry;
 
 /* -------------------------------------------------------------------- */
 /*      Loop processing names out of nadgrids one at a time.            */
@@ -229,7 +553,7 @@ PJ_GRIDINFO **pj_gridlist_from_nadgrids( const char *nadgrids, int *grid_count)
 
         if( end_char > sizeof(name) )
         {
-            pj_errno = -38;
+            pj_ctx_set_errno( ctx, -38 );
             pj_release_lock();
             return NULL;
         }
@@ -241,26 +565,129 @@ PJ_GRIDINFO **pj_gridlist_from_nadgrids( const char *nadgrids, int *grid_count)
         if( *s == ',' )
             s++;
 
-        if( !pj_gridlist_merge_gridfile( name ) && required )
+        if( !pj_gridlist_merge_gridfile( ctx, entry, name ) && required )
         {
-            pj_errno = -38;
+            pj_ctx_set_errno( ctx, -38 );
             pj_release_lock();
             return NULL;
         }
         else
-            pj_errno = 0;
+            pj_ctx_set_errno( ctx, 0 );
+    }
+
+    if( entry->count > 0 )
+        gridlist_index( entry );
+
+    pj_release_lock();
+    return entry;
+}
+
+/************************************************************************/
+/*                     pj_gridlist_from_nadgrids()                      */
+/*                                                                      */
+/*      Return the list of grids for a nadgrids string, see             */
+/*      pj_gridlist_get().                                              */
+/************************************************************************/
+
+PJ_GRIDINFO **pj_gridlist_from_nadgrids( projCtx ctx, const char *nadgrids, 
+                                          int *grid_count)
+
+{
+    PJ_GRIDLIST *gl = pj_gridlist_get( ctx, nadgrids );
+
+    *grid_count = 0;
+    if( gl == NULL || gl->count == 0 )
+        return NULL;
+
+    *grid_count = gl->count;
+    return gl->list;
+}
+
+/************************************************************************/
+/*                          pj_gridlist_find()                          */
+/*                                                                      */
+/*      Find the grid to use for a point, searching the tables at or    */
+/*      after number from in order.  As pj_apply_gridshift() always     */
+/*      has, the first table whose extent holds the point is picked,    */
+/*      and then the first of its children holding it, if any.  The     */
+/*      table and child picked are returned in hit; NULL is returned    */
+/*      if no table holds the point.                                    */
+/*                                                                      */
+/*      When starting over (from == 0), hit is taken to be the grid     */
+/*      used for the previous point.  If that grid is not overlapped    */
+/*      by any grid searched before it, and still holds the point,      */
+/*      it is what the search would find, so it is used directly.       */
+/************************************************************************/
+
+PJ_GRIDINFO *pj_gridlist_find( const PJ_GRIDLIST *gl, LP input, int from,
+                               PJ_GRIDHIT *hit )
+
+{
+    int  itable, ichild;
+    PJ_GRIDINFO *gi;
+
+/* -------------------------------------------------------------------- */
+/*      Without an index (out of memory) scan the lists.  NaN passes    */
+/*      every extent test, so it cannot be looked up in the index.      */
+/* -------------------------------------------------------------------- */
+    if( gl->tables == NULL || input.lam != input.lam 
+        || input.phi != input.phi )
+    {
+        for( itable = from; itable < gl->count; itable++ )
+        {
+            if( !grid_contains( gl->list[itable]->ct, input ) )
+                continue;
+
+            hit->table = itable;
+            hit->child = -1;
+            for( gi = gl->list[itable]->child; gi != NULL; gi = gi->next )
+            {
+                if( grid_contains( gi->ct, input ) )
+                    return gi;
+            }
+            return gl->list[itable];
+        }
+
+        hit->table = hit->child = -1;
+        return NULL;
     }
 
-    if( last_nadgrids_count > 0 )
+/* -------------------------------------------------------------------- */
+/*      Fast path, the same grid as for the previous point.             */
+/* -------------------------------------------------------------------- */
+    if( from == 0 && hit->table >= 0 && gl->tables->solo[hit->table] )
     {
-        PJ_GRIDINFO **ret = last_nadgrids_list;
-        *grid_count = last_nadgrids_count;
-        pj_release_lock();
-        return ret;
+        const PJ_GRIDSET *children = gl->children + hit->table;
+
+        gi = gl->list[hit->table];
+        if( grid_contains( gi->ct, input ) )
+        {
+            if( hit->child < 0 && children->count == 0 )
+                return gi;
+
+            if( hit->child >= 0 && children->solo[hit->child]
+                && grid_contains( children->grids[hit->child]->ct, input ) )
+                return children->grids[hit->child];
+        }
     }
-    else
+
+/* -------------------------------------------------------------------- */
+/*      Search the index.                                               */
+/* -------------------------------------------------------------------- */
+    itable = gridset_find( gl->tables, input, from );
+    if( itable < 0 )
     {
-        pj_release_lock();
+        hit->table = hit->child = -1;
         return NULL;
     }
+
+    ichild = gridset_find( gl->children + itable, input, 0 );
+
+    hit->table = itable;
+    hit->child = ichild;
+
+    if( ichild < 0 )
+        return gl->list[itable];
+    else
+        return gl->children[itable].grids[ichild];
 }
@@ -38,13 +38,13 @@
 
 PJ_CVSID("$Id: pj_init.c 1630 2009-09-24 02:14:06Z warmerdam $");
 
-extern FILE *pj_open_lib(char *, char *);
+static PJ *pj_init_params(projCtx ctx, paralist *start, int expand);
 
 /************************************************************************/
 /*                              get_opt()                               */
 /************************************************************************/
 static paralist *
-get_opt(paralist **start, FILE *fid, char *name, paralist *next) {
+get_opt(projCtx ctx, paralist **start, FILE *fid, char *name, paralist *next) {
     char sword[302], *word = sword+1;
     int first = 1, len, c;
 
@@ -61,16 +61,16 @@ get_opt(paralist **start, FILE *fid, char *name, paralist *next) {
                 while((c = fgetc(fid)) != EOF && c != '\n') ;
                 break;
             }
-        } else if (!first && !pj_param(*start, sword).i) {
+        } else if (!first && !pj_param(ctx, *start, sword).i) {
             /* don't default ellipse if datum, ellps or any earth model
                information is set. */
             if( strncmp(word,"ellps=",6) != 0 
-                || (!pj_param(*start, "tdatum").i 
-                    && !pj_param(*start, "tellps").i 
-                    && !pj_param(*start, "ta").i 
-                    && !pj_param(*start, "tb").i 
-                    && !pj_param(*start, "trf").i 
-                    && !pj_param(*start, "tf").i) )
+                || (!pj_param(ctx, *start, "tdatum").i 
+                    && !pj_param(ctx, *start, "tellps").i 
+                    && !pj_param(ctx, *start, "ta").i 
+                    && !pj_param(ctx, *start, "tb").i 
+                    && !pj_param(ctx, *start, "trf").i 
+                    && !pj_param(ctx, *start, "tf").i) )
             {
                 next = next->next = pj_mkparam(word);
             }
@@ -86,13 +86,13 @@ get_opt(paralist **start, FILE *fid, char *name, paralist *next) {
 /*                            get_defaults()                            */
 /************************************************************************/
 static paralist *
-get_defaults(paralist **start, paralist *next, char *name) {
+get_defaults(projCtx ctx, paralist **start, paralist *next, char *name) {
 	FILE *fid;
 
-	if ((fid = pj_open_lib("proj_def.dat", "rt"))) {
-		next = get_opt(start, fid, "general", next);
+	if ((fid = pj_open_lib(ctx, "proj_def.dat", "rt"))) {
+		next = get_opt(ctx, start, fid, "general", next);
 		rewind(fid);
-		next = get_opt(start, fid, name, next);
+		next = get_opt(ctx, start, fid, name, next);
 		(void)fclose(fid);
 	}
 	if (errno)
@@ -104,7 +104,7 @@ get_defaults(paralist **start, paralist *next, char *name) {
 /*                              get_init()                              */
 /************************************************************************/
 static paralist *
-get_init(paralist **start, paralist *next, char *name) {
+get_init(projCtx ctx, paralist **start, paralist *next, char *name) {
 	char fname[MAX_PATH_FILENAME+ID_TAG_MAX+3], *opt;
 	FILE *fid;
 	paralist *init_items = NULL;
@@ -130,9 +130,9 @@ get_init(paralist **start, paralist *next, char *name) {
 	*/
 	if ((opt = strrchr(fname, ':')))
 		*opt++ = '\0';
-	else { pj_errno = -3; return(0); }
-	if ((fid = pj_open_lib(fname, "rt")))
-		next = get_opt(start, fid, opt, next);
+	else { pj_ctx_set_errno( ctx, -3 ); return(0); }
+	if ((fid = pj_open_lib(ctx, fname, "rt")))
+		next = get_opt(ctx, start, fid, opt, next);
 	else
 		return(0);
 	(void)fclose(fid);
@@ -160,12 +160,24 @@ get_init(paralist **start, paralist *next, char *name) {
 PJ *
 pj_init_plus( const char *definition )
 
+{
+    return pj_init_plus_ctx( pj_get_default_ctx(), definition );
+}
+
+/************************************************************************/
+/*                          pj_init_plus_ctx()                          */
+/************************************************************************/
+
+PJ *
+pj_init_plus_ctx( projCtx ctx, const char *definition )
+
 {
 #define MAX_ARG 200
     char	*argv[MAX_ARG];
-    char	*defn_copy;
+    char	*defn_copy, *key;
     int		argc = 0, i;
     PJ	        *result;
+    paralist    *params;
     
     /* make a copy that we can manipulate */
     defn_copy = (char *) pj_malloc( strlen(definition)+1 );
@@ -182,7 +194,8 @@ pj_init_plus( const char *definition )
             {
                 if( argc+1 == MAX_ARG )
                 {
-                    pj_errno = -44;
+                    pj_dalloc( defn_copy );
+                    pj_ctx_set_errno( ctx, -44 );
                     return NULL;
                 }
                 
@@ -201,9 +214,37 @@ pj_init_plus( const char *definition )
         }
     }
 
+    /* 
+    ** Build the normalized definition, one space and '+' between
+    ** arguments, and look for it in the definition cache.
+    */
+    key = (char *) pj_malloc( strlen(definition)+argc+1 );
+    if( key != NULL )
+    {
+        key[0] = '\0';
+        for( i = 0; i < argc; i++ )
+        {
+            if( i > 0 )
+                strcat( key, " +" );
+            strcat( key, argv[i] );
+        }
+
+        if( (params = pj_search_defncache( key )) != NULL )
+        {
+            result = pj_init_params( ctx, params, 0 );
+            pj_dalloc( key );
+            pj_dalloc( defn_copy );
+            return result;
+        }
+    }
+
     /* perform actual initialization */
-    result = pj_init( argc, argv );
+    result = pj_init_ctx( ctx, argc, argv );
+
+    if( result != NULL && key != NULL )
+        pj_insert_defncache( key, result->params, result->params_expanded );
 
+    pj_dalloc( key );
     pj_dalloc( defn_copy );
 
     return result;
@@ -220,61 +261,115 @@ pj_init_plus( const char *definition )
 
 PJ *
 pj_init(int argc, char **argv) {
+	return pj_init_ctx( pj_get_default_ctx(), argc, argv );
+}
+
+/************************************************************************/
+/*                            pj_init_ctx()                             */
+/*                                                                      */
+/*      As pj_init(), but the new object reports errors and debug       */
+/*      output through the passed context rather than the default       */
+/*      (global) one.                                                   */
+/************************************************************************/
+
+PJ *
+pj_init_ctx(projCtx ctx, int argc, char **argv) {
+	paralist *start = NULL, *curr = NULL;
+	int i;
+
+	errno = 0;
+	pj_ctx_set_errno( ctx, 0 );
+
+	/* put arguments into internal linked list */
+	if (argc <= 0) { pj_ctx_set_errno( ctx, -1 ); return 0; }
+	for (i = 0; i < argc; ++i) {
+		paralist *item = pj_mkparam(argv[i]);
+
+		if (!item) {
+			for ( ; start; start = curr) {
+				curr = start->next;
+				pj_dalloc(start);
+			}
+			pj_ctx_set_errno( ctx, ENOMEM );
+			return 0;
+		}
+		if (i)
+			curr = curr->next = item;
+		else
+			start = curr = item;
+	}
+
+	return pj_init_params( ctx, start, 1 );
+}
+
+/************************************************************************/
+/*                           pj_init_params()                           */
+/*                                                                      */
+/*      Initialize a PJ from a parameter list, which the PJ takes       */
+/*      over (or which is freed on failure).  With expand set,          */
+/*      +init= references and proj_def.dat defaults are appended to     */
+/*      the list first; without it the list is taken to have been       */
+/*      expanded already, as for clones and definition cache hits.      */
+/************************************************************************/
+
+static PJ *
+pj_init_params(projCtx ctx, paralist *start, int expand) {
 	char *s, *name;
-        paralist *start = NULL;
 	PJ *(*proj)(PJ *);
 	paralist *curr;
-	int i;
+	int i, count;
 	PJ *PIN = 0;
         const char *old_locale;
 
-	errno = pj_errno = 0;
-        start = NULL;
+	errno = 0;
+	pj_ctx_set_errno( ctx, 0 );
 
         old_locale = setlocale(LC_NUMERIC, NULL); 
         setlocale(LC_NUMERIC,"C");
 
-	/* put arguments into internal linked list */
-	if (argc <= 0) { pj_errno = -1; goto bum_call; }
-	for (i = 0; i < argc; ++i)
-		if (i)
-			curr = curr->next = pj_mkparam(argv[i]);
-		else
-			start = curr = pj_mkparam(argv[i]);
-	if (pj_errno) goto bum_call;
+	for (curr = start; curr->next; curr = curr->next) ;
 
 	/* check if +init present */
-	if (pj_param(start, "tinit").i) {
+	if (expand && pj_param(ctx, start, "tinit").i) {
 		paralist *last = curr;
 
-		if (!(curr = get_init(&start, curr, pj_param(start, "sinit").s)))
+		if (!(curr = get_init(ctx, &start, curr, pj_param(ctx, start, "sinit").s)))
 			goto bum_call;
-		if (curr == last) { pj_errno = -2; goto bum_call; }
+		if (curr == last) { pj_ctx_set_errno( ctx, -2 ); goto bum_call; }
 	}
 
 	/* find projection selection */
-	if (!(name = pj_param(start, "sproj").s))
-		{ pj_errno = -4; goto bum_call; }
-	for (i = 0; (s = pj_list[i].id) && strcmp(name, s) ; ++i) ;
-	if (!s) { pj_errno = -5; goto bum_call; }
+	if (!(name = pj_param(ctx, start, "sproj").s))
+		{ pj_ctx_set_errno( ctx, -4 ); goto bum_call; }
+	if ((i = pj_find_proj(name)) < 0)
+		{ pj_ctx_set_errno( ctx, -5 ); goto bum_call; }
 
 	/* set defaults, unless inhibited */
-	if (!pj_param(start, "bno_defs").i)
-		curr = get_defaults(&start, curr, name);
+	if (expand && !pj_param(ctx, start, "bno_defs").i)
+		curr = get_defaults(ctx, &start, curr, name);
+	for (count = 0, curr = start; curr; curr = curr->next)
+		++count;
 	proj = (PJ *(*)(PJ *)) pj_list[i].proj;
 
 	/* allocate projection structure */
 	if (!(PIN = (*proj)(0))) goto bum_call;
+	PIN->ctx = ctx;
 	PIN->params = start;
         PIN->is_latlong = 0;
         PIN->is_geocent = 0;
         PIN->long_wrap_center = 0.0;
+        PIN->gridlist = NULL;
+        PIN->gridlist_generation = 0;
+        PIN->params_expanded = count;
 
         /* set datum parameters */
         if (pj_datum_set(start, PIN)) goto bum_call;
 
+        /* the list is complete now, pack it for the lookups to come */
+        PIN->params = start = pj_param_pack(start);
+
 	/* set ellipsoid/sphere parameters */
-	if (pj_ell_set(start, &PIN->a, &PIN->es)) goto bum_call;
+	if (pj_ell_set(ctx, start, &PIN->a, &PIN->es)) goto bum_call;
 
         PIN->a_orig = PIN->a;
         PIN->es_orig = PIN->es;
@@ -282,7 +377,7 @@ pj_init(int argc, char **argv) {
 	PIN->e = sqrt(PIN->es);
 	PIN->ra = 1. / PIN->a;
 	PIN->one_es = 1. - PIN->es;
-	if (PIN->one_es == 0.) { pj_errno = -6; goto bum_call; }
+	if (PIN->one_es == 0.) { pj_ctx_set_errno( ctx, -6 ); goto bum_call; }
 	PIN->rone_es = 1./PIN->one_es;
 
         /* Now that we have ellipse information check for WGS84 datum */
@@ -297,44 +392,44 @@ pj_init(int argc, char **argv) {
         }
         
 	/* set PIN->geoc coordinate system */
-	PIN->geoc = (PIN->es && pj_param(start, "bgeoc").i);
+	PIN->geoc = (PIN->es && pj_param(ctx, start, "bgeoc").i);
 
 	/* over-ranging flag */
-	PIN->over = pj_param(start, "bover").i;
+	PIN->over = pj_param(ctx, start, "bover").i;
 
 	/* longitude center for wrapping */
-	PIN->long_wrap_center = pj_param(start, "rlon_wrap").f;
+	PIN->long_wrap_center = pj_param(ctx, start, "rlon_wrap").f;
 
 	/* central meridian */
-	PIN->lam0=pj_param(start, "rlon_0").f;
+	PIN->lam0=pj_param(ctx, start, "rlon_0").f;
 
 	/* central latitude */
-	PIN->phi0 = pj_param(start, "rlat_0").f;
+	PIN->phi0 = pj_param(ctx, start, "rlat_0").f;
 
 	/* false easting and northing */
-	PIN->x0 = pj_param(start, "dx_0").f;
-	PIN->y0 = pj_param(start, "dy_0").f;
+	PIN->x0 = pj_param(ctx, start, "dx_0").f;
+	PIN->y0 = pj_param(ctx, start, "dy_0").f;
 
 	/* general scaling factor */
-	if (pj_param(start, "tk_0").i)
-		PIN->k0 = pj_param(start, "dk_0").f;
-	else if (pj_param(start, "tk").i)
-		PIN->k0 = pj_param(start, "dk").f;
+	if (pj_param(ctx, start, "tk_0").i)
+		PIN->k0 = pj_param(ctx, start, "dk_0").f;
+	else if (pj_param(ctx, start, "tk").i)
+		PIN->k0 = pj_param(ctx, start, "dk").f;
 	else
 		PIN->k0 = 1.;
 	if (PIN->k0 <= 0.) {
-		pj_errno = -31;
+		pj_ctx_set_errno( ctx, -31 );
 		goto bum_call;
 	}
 
 	/* set units */
 	s = 0;
-	if ((name = pj_param(start, "sunits").s)) { 
-		for (i = 0; (s = pj_units[i].id) && strcmp(name, s) ; ++i) ;
-		if (!s) { pj_errno = -7; goto bum_call; }
+	if ((name = pj_param(ctx, start, "sunits").s)) { 
+		if ((i = pj_find_units(name)) < 0)
+			{ pj_ctx_set_errno( ctx, -7 ); goto bum_call; }
 		s = pj_units[i].to_meter;
 	}
-	if (s || (s = pj_param(start, "sto_meter").s)) {
+	if (s || (s = pj_param(ctx, start, "sto_meter").s)) {
 		PIN->to_meter = strtod(s, &s);
 		if (*s == '/') /* ratio number */
 			PIN->to_meter /= strtod(++s, 0);
@@ -344,42 +439,33 @@ pj_init(int argc, char **argv) {
 
 	/* prime meridian */
 	s = 0;
-	if ((name = pj_param(start, "spm").s)) { 
+	if ((name = pj_param(ctx, start, "spm").s)) { 
             const char *value = NULL;
             char *next_str = NULL;
 
-            for (i = 0; pj_prime_meridians[i].id != NULL; ++i )
-            {
-                if( strcmp(name,pj_prime_meridians[i].id) == 0 )
-                {
-                    value = pj_prime_meridians[i].defn;
-                    break;
-                }
-            }
+            if( (i = pj_find_prime_meridian(name)) >= 0 )
+                value = pj_prime_meridians[i].defn;
             
             if( value == NULL 
-                && (dmstor(name,&next_str) != 0.0  || *name == '0')
+                && (dmstor_ctx(ctx,name,&next_str) != 0.0  || *name == '0')
                 && *next_str == '\0' )
                 value = name;
 
-            if (!value) { pj_errno = -46; goto bum_call; }
-            PIN->from_greenwich = dmstor(value,NULL);
+            if (!value) { pj_ctx_set_errno( ctx, -46 ); goto bum_call; }
+            PIN->from_greenwich = dmstor_ctx(ctx,value,NULL);
 	}
         else
             PIN->from_greenwich = 0.0;
 
 	/* projection specific initialization */
-	if (!(PIN = (*proj)(PIN)) || errno || pj_errno) {
+	if (!(PIN = (*proj)(PIN)) || errno || ctx->last_errno) {
 bum_call: /* cleanup error return */
-		if (!pj_errno)
-			pj_errno = errno;
+		if (!ctx->last_errno)
+			pj_ctx_set_errno( ctx, errno );
 		if (PIN)
 			pj_free(PIN);
 		else
-			for ( ; start; start = curr) {
-				curr = start->next;
-				pj_dalloc(start);
-			}
+			pj_param_free(start);
 		PIN = 0;
 	}
         setlocale(LC_NUMERIC,old_locale);
@@ -387,6 +473,54 @@ bum_call: /* cleanup error return */
 	return PIN;
 }
 
+/************************************************************************/
+/*                             pj_clone()                               */
+/*                                                                      */
+/*      Create an independent copy of a projection definition.  The     */
+/*      already expanded parameter list is reused, so no definition     */
+/*      parsing, init file or proj_def.dat access is needed; only       */
+/*      the datum, ellipsoid and projection setup are run again.        */
+/*      Projection specific state can hold allocations of its own,      */
+/*      so the PJ itself cannot simply be copied.                       */
+/************************************************************************/
+
+PJ *
+pj_clone(PJ *P) {
+	return pj_clone_ctx( P->ctx, P );
+}
+
+/************************************************************************/
+/*                            pj_clone_ctx()                            */
+/*                                                                      */
+/*      As pj_clone(), but the copy reports through the passed          */
+/*      context, so it can be handed to another thread.                 */
+/************************************************************************/
+
+PJ *
+pj_clone_ctx(projCtx ctx, PJ *P) {
+	paralist *params, *src, *dst, *next;
+	int i;
+
+	if (!(params = pj_clone_paralist(P->params))) {
+		pj_ctx_set_errno( ctx, ENOMEM );
+		return 0;
+	}
+
+	/* keep the used flags, so pj_get_def() reports the same */
+	for (src = P->params, dst = params; src; src = src->next, dst = dst->next)
+		dst->used = src->used;
+
+	/* drop what pj_datum_set() appended, it appends it again */
+	for (i = 1, dst = params; i < P->params_expanded; ++i)
+		dst = dst->next;
+	for (next = dst->next, dst->next = NULL; next; next = src) {
+		src = next->next;
+		pj_dalloc(next);
+	}
+
+	return pj_init_params( ctx, params, 0 );
+}
+
 /************************************************************************/
 /*                              pj_free()                               */
 /*                                                                      */
@@ -400,13 +534,8 @@ bum_call: /* cleanup error return */
 void
 pj_free(PJ *P) {
 	if (P) {
-		paralist *t = P->params, *n;
-
 		/* free parameter list elements */
-		for (t = P->params; t; t = n) {
-			n = t->next;
-			pj_dalloc(t);
-		}
+		pj_param_free(P->params);
 
 		/* free projection parameters */
 		P->pfree(P);
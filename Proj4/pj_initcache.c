@@ -32,28 +32,69 @@
 
 PJ_CVSID("$Id: pj_transform.c 1504 2009-01-06 02:11:57Z warmerdam $");
 
-static int cache_count = 0;
-static int cache_alloc = 0;
-static char **cache_key = NULL;
-static paralist **cache_paralist = NULL;
+/*
+** The caches are open addressing hash tables (linear probing) keyed on
+** a string: the "file:key" of +init= entries in the init file cache,
+** and the normalized pj_init_plus() definition in the definition
+** cache.  Entries are never changed once inserted, so lookups only hold
+** the lock to probe the table and take a reference; the paralist is
+** cloned for the caller after the lock is released.  The reference
+** keeps the entry alive if pj_clear_initcache() runs meanwhile.
+*/
+
+typedef struct {
+  char     *key;
+  unsigned long hash;
+  paralist *list;
+  int       refs;       /* one for the table, one per lookup in progress */
+} INITCACHE_ENTRY;
+
+typedef struct {
+  int       count;
+  int       alloc;      /* table size, a power of two */
+  int       max;        /* entry limit, 0 for none */
+  int       keep_used;  /* clones keep the used flags */
+  INITCACHE_ENTRY **table;
+} INITCACHE;
+
+/*
+** Definitions can be generated on the fly (a +lon_0 per point, say), so
+** the definition cache stops taking entries once it holds this many.
+*/
+#ifndef DEFNCACHE_MAX
+#  define DEFNCACHE_MAX 1024
+#endif
+
+static INITCACHE init_cache = { 0, 0, 0, 0, NULL };
+static INITCACHE defn_cache = { 0, 0, DEFNCACHE_MAX, 1, NULL };
 
 /************************************************************************/
-/*                            pj_clone_paralist()                       */
-/*                                                                      */
-/*     Allocate a copy of a parameter list.                             */
+/*                            clone_params()                            */
 /************************************************************************/
 
-paralist *pj_clone_paralist( const paralist *list)
+static paralist *clone_params( const paralist *list, int count, 
+                               int keep_used )
 {
   paralist *list_copy = NULL, *next_copy = NULL;
 
-  for( ; list != NULL; list = list->next )
+  for( ; list != NULL && count != 0; list = list->next, count-- )
     {
       paralist *newitem = (paralist *)
 	pj_malloc(sizeof(paralist) + strlen(list->param));
 
-      newitem->used = 0;
+      if( newitem == NULL )
+        {
+          for( ; list_copy != NULL; list_copy = next_copy )
+            {
+              next_copy = list_copy->next;
+              pj_dalloc( list_copy );
+            }
+          return NULL;
+        }
+
+      newitem->used = keep_used ? list->used : 0;
       newitem->next = 0;
+      newitem->index = 0;
       strcpy( newitem->param, list->param );
       
       if( list_copy == NULL )
@@ -68,114 +109,283 @@ paralist *pj_clone_paralist( const paralist *list)
 }
 
 /************************************************************************/
-/*                            pj_clear_initcache()                      */
+/*                            pj_clone_paralist()                       */
 /*                                                                      */
-/*      Clear out all memory held in the init file cache.               */
+/*     Allocate a copy of a parameter list.                             */
 /************************************************************************/
 
-void pj_clear_initcache()
+paralist *pj_clone_paralist( const paralist *list)
 {
-  if( cache_alloc > 0 )
-  {
-    int i;
-
-    pj_acquire_lock();
-
-    for( i = 0; i < cache_count; i++ )
-      {
-	paralist *n, *t = cache_paralist[i];
-		
-	pj_dalloc( cache_key[i] );
-
-	/* free parameter list elements */
-	for (; t != NULL; t = n) {
-	  n = t->next;
-	  pj_dalloc(t);
-	}
-      }
+  return clone_params( list, -1, 0 );
+}
+
+/************************************************************************/
+/*                            initcache_hash()                          */
+/*                                                                      */
+/*      FNV-1a hash of a filekey.                                       */
+/************************************************************************/
+
+static unsigned long initcache_hash( const char *filekey )
+{
+  unsigned long hash = 2166136261UL;
 
-    pj_dalloc( cache_key );
-    pj_dalloc( cache_paralist );
-    cache_count = 0;
-    cache_alloc= 0;
-    cache_key = NULL;
-    cache_paralist = NULL;
+  for( ; *filekey != '\0'; filekey++ )
+    {
+      hash ^= (unsigned char) *filekey;
+      hash = (hash * 16777619UL) & 0xffffffffUL;
+    }
 
-    pj_release_lock();
-  }
+  return hash;
 }
 
 /************************************************************************/
-/*                            pj_search_initcache()                     */
+/*                            initcache_probe()                         */
 /*                                                                      */
-/*      Search for a matching definition in the init cache.             */
+/*      Return the slot holding filekey, or the empty slot where it     */
+/*      belongs.  Called with the lock held.                            */
 /************************************************************************/
 
-paralist *pj_search_initcache( const char *filekey )
+static int initcache_probe( INITCACHE_ENTRY **table, int alloc,
+                            const char *filekey, unsigned long hash )
+{
+  int i = (int) (hash & (alloc - 1));
+
+  while( table[i] != NULL 
+         && (table[i]->hash != hash || strcmp(table[i]->key,filekey) != 0) )
+    i = (i + 1) & (alloc - 1);
+
+  return i;
+}
+
+/************************************************************************/
+/*                            initcache_release()                       */
+/*                                                                      */
+/*      Drop a reference to an entry, freeing it with the last one.     */
+/*      Called with the lock held.                                      */
+/************************************************************************/
+
+static void initcache_release( INITCACHE_ENTRY *entry )
+{
+  paralist *n, *t;
 
+  if( --entry->refs > 0 )
+    return;
+
+  /* free parameter list elements */
+  for( t = entry->list; t != NULL; t = n ) 
+    {
+      n = t->next;
+      pj_dalloc(t);
+    }
+
+  pj_dalloc( entry->key );
+  pj_dalloc( entry );
+}
+
+/************************************************************************/
+/*                            initcache_clear()                         */
+/*                                                                      */
+/*      Called with the lock held.                                      */
+/************************************************************************/
+
+static void initcache_clear( INITCACHE *cache )
 {
   int i;
+
+  for( i = 0; i < cache->alloc; i++ )
+    {
+      if( cache->table[i] != NULL )
+        initcache_release( cache->table[i] );
+    }
+
+  pj_dalloc( cache->table );
+  cache->count = 0;
+  cache->alloc = 0;
+  cache->table = NULL;
+}
+
+/************************************************************************/
+/*                            initcache_search()                        */
+/************************************************************************/
+
+static paralist *initcache_search( INITCACHE *cache, const char *filekey )
+
+{
+  unsigned long hash = initcache_hash( filekey );
+  INITCACHE_ENTRY *entry = NULL;
   paralist *result = NULL;
 
   pj_acquire_lock();
 
-  for( i = 0; result == NULL && i < cache_count; i++)
+  if( cache->count > 0 )
     {
-      if( strcmp(filekey,cache_key[i]) == 0 )
-	{
-	  result = pj_clone_paralist( cache_paralist[i] );
-	}
+      entry = cache->table[initcache_probe( cache->table, cache->alloc, 
+                                            filekey, hash )];
+      if( entry != NULL )
+	entry->refs++;
     }
 
   pj_release_lock();
 
+  if( entry == NULL )
+    return NULL;
+
+  /* each PJ marks its own parameters used, so it needs its own copy */
+  result = clone_params( entry->list, -1, cache->keep_used );
+
+  pj_acquire_lock();
+  initcache_release( entry );
+  pj_release_lock();
+
   return result;
 }
 
 /************************************************************************/
-/*                            pj_insert_initcache()                     */
-/*                                                                      */
-/*      Insert a paralist definition in the init file cache.            */
+/*                            initcache_insert()                        */
 /************************************************************************/
 
-void pj_insert_initcache( const char *filekey, const paralist *list )
+static void initcache_insert( INITCACHE *cache, const char *filekey,
+                              const paralist *list, int count )
 
 {
+  unsigned long hash = initcache_hash( filekey );
+  INITCACHE_ENTRY *entry;
+  int i;
+
+  if( cache->max > 0 && cache->count >= cache->max )
+    return;
+
+  /*
+  ** Duplicate the filekey and paralist before taking the lock.
+  */
+  entry = (INITCACHE_ENTRY *) pj_malloc(sizeof(INITCACHE_ENTRY));
+  if( entry == NULL )
+    return;
+
+  entry->key = (char *) pj_malloc(strlen(filekey)+1);
+  entry->list = clone_params( list, count, cache->keep_used );
+  if( entry->key == NULL || entry->list == NULL )
+    {
+      entry->refs = 1;
+      initcache_release( entry );
+      return;
+    }
+  strcpy( entry->key, filekey );
+  entry->hash = hash;
+  entry->refs = 1;
+
   pj_acquire_lock();
 
   /* 
-  ** Grow list if required.
+  ** Grow (and rehash) the table if it is half full.
   */
-  if( cache_count == cache_alloc )
+  if( (cache->count + 1) * 2 > cache->alloc )
     {
-      char **cache_key_new;
-      paralist **cache_paralist_new;
-
-      cache_alloc = cache_alloc * 2 + 15;
-
-      cache_key_new = (char **) pj_malloc(sizeof(char*) * cache_alloc);
-      memcpy( cache_key, cache_key_new, sizeof(char*) * cache_count);
-      pj_dalloc( cache_key );
-      cache_key = cache_key_new;
-
-      cache_paralist_new = (paralist **) 
-	pj_malloc(sizeof(paralist*) * cache_alloc);
-      memcpy( cache_paralist_new, cache_paralist, 
-	      sizeof(paralist*) * cache_count );
-      pj_dalloc( cache_paralist );
-      cache_paralist = cache_paralist_new;
+      INITCACHE_ENTRY **table_new;
+      int alloc_new = cache->alloc ? cache->alloc * 2 : 32;
+
+      table_new = (INITCACHE_ENTRY **) 
+	pj_malloc(sizeof(INITCACHE_ENTRY*) * alloc_new);
+      if( table_new == NULL )
+	{
+	  initcache_release( entry );
+	  pj_release_lock();
+	  return;
+	}
+      memset( table_new, 0, sizeof(INITCACHE_ENTRY*) * alloc_new );
+
+      for( i = 0; i < cache->alloc; i++ )
+	{
+	  if( cache->table[i] != NULL )
+	    table_new[initcache_probe( table_new, alloc_new, 
+				       cache->table[i]->key,
+				       cache->table[i]->hash )] = cache->table[i];
+	}
+
+      pj_dalloc( cache->table );
+      cache->table = table_new;
+      cache->alloc = alloc_new;
     }
 
   /*
-  ** Duplicate the filekey and paralist, and insert in cache.
+  ** Insert, unless another thread loaded the same definition first.
   */
-  cache_key[cache_count] = (char *) pj_malloc(strlen(filekey)+1);
-  strcpy( cache_key[cache_count], filekey );
+  i = initcache_probe( cache->table, cache->alloc, filekey, hash );
+  if( cache->table[i] == NULL && (cache->max == 0 || cache->count < cache->max) )
+    {
+      cache->table[i] = entry;
+      cache->count++;
+    }
+  else
+    initcache_release( entry );
 
-  cache_paralist[cache_count] = pj_clone_paralist( list );
+  pj_release_lock();
+}
 
-  cache_count++;
+/************************************************************************/
+/*                            pj_clear_initcache()                      */
+/*                                                                      */
+/*      Clear out all memory held in the init file and definition       */
+/*      caches.                                                         */
+/************************************************************************/
 
+void pj_clear_initcache()
+{
+  pj_acquire_lock();
+  initcache_clear( &init_cache );
+  initcache_clear( &defn_cache );
   pj_release_lock();
 }
 
+/************************************************************************/
+/*                            pj_search_initcache()                     */
+/*                                                                      */
+/*      Search for a matching definition in the init cache.             */
+/************************************************************************/
+
+paralist *pj_search_initcache( const char *filekey )
+
+{
+  return initcache_search( &init_cache, filekey );
+}
+
+/************************************************************************/
+/*                            pj_insert_initcache()                     */
+/*                                                                      */
+/*      Insert a paralist definition in the init file cache.            */
+/************************************************************************/
+
+void pj_insert_initcache( const char *filekey, const paralist *list )
+
+{
+  initcache_insert( &init_cache, filekey, list, -1 );
+}
+
+/************************************************************************/
+/*                           pj_search_defncache()                      */
+/*                                                                      */
+/*      Search for the expanded parameter list of a normalized          */
+/*      pj_init_plus() definition.  The copy returned keeps the         */
+/*      used flags of the PJ it was taken from.                         */
+/************************************************************************/
+
+paralist *pj_search_defncache( const char *definition )
+
+{
+  return initcache_search( &defn_cache, definition );
+}
+
+/************************************************************************/
+/*                           pj_insert_defncache()                      */
+/*                                                                      */
+/*      Remember the first count parameters of a successfully           */
+/*      initialized PJ, which is its list after +init= and              */
+/*      proj_def.dat expansion (see PJ.params_expanded).                */
+/************************************************************************/
+
+void pj_insert_defncache( const char *definition, const paralist *list,
+                          int count )
+
+{
+  initcache_insert( &defn_cache, definition, list, count );
+}
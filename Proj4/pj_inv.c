@@ -10,13 +10,16 @@ pj_inv(XY xy, PJ *P) {
 	/* can't do as much preliminary checking as with forward */
 	if (xy.x == HUGE_VAL || xy.y == HUGE_VAL) {
 		lp.lam = lp.phi = HUGE_VAL;
-		pj_errno = -15;
+		pj_ctx_set_errno( P->ctx, -15 );
 	}
-	errno = pj_errno = 0;
+	errno = 0;
+	pj_ctx_set_errno( P->ctx, 0 );
 	xy.x = (xy.x * P->to_meter - P->x0) * P->ra; /* descale and de-offset */
 	xy.y = (xy.y * P->to_meter - P->y0) * P->ra;
 	lp = (*P->inv)(xy, P); /* inverse project */
-	if (pj_errno || (pj_errno = errno))
+	if (P->ctx->last_errno == 0 && errno != 0)
+		pj_ctx_set_errno( P->ctx, errno );
+	if (P->ctx->last_errno)
 		lp.lam = lp.phi = HUGE_VAL;
 	else {
 		lp.lam += P->lam0; /* reduce from del lp.lam */
@@ -27,3 +30,67 @@ pj_inv(XY xy, PJ *P) {
 	}
 	return lp;
 }
+/*
+** Same result as pj_inv() on each of n points, every stride'th double
+** of x and y, with x/y in and lam/phi (radians) out.  Points that fail are
+** set to HUGE_VAL, points that are HUGE_VAL to begin with are passed
+** through quietly.  Returns 0, or the error of one of the failed points.
+*/
+	int /* inverse projection of an array of points, in place */
+pj_inv_array(PJ *P, long n, int stride, double *x, double *y) {
+	double *xx, *yy;
+	double x0 = P->x0, y0 = P->y0, to_meter = P->to_meter, ra = P->ra;
+	long i;
+	int err = 0;
+
+	/* descale and de-offset, passing over points that already failed */
+	for (i = 0, xx = x, yy = y; i < n; ++i, xx += stride, yy += stride) {
+		if (*xx == HUGE_VAL || *yy == HUGE_VAL) {
+			*xx = *yy = HUGE_VAL;
+			continue;
+		}
+		*xx = (*xx * to_meter - x0) * ra;
+		*yy = (*yy * to_meter - y0) * ra;
+	}
+	/* inverse project, through the batch hook if there is one */
+	errno = 0;
+	pj_ctx_set_errno( P->ctx, 0 );
+	if (P->inv_n) {
+		(*P->inv_n)(P, n, stride, x, y);
+		if (P->ctx->last_errno)
+			err = P->ctx->last_errno;
+	} else for (i = 0, xx = x, yy = y; i < n;
+			++i, xx += stride, yy += stride) {
+		XY xy;
+		LP lp;
+
+		if (*xx == HUGE_VAL)
+			continue;
+		xy.x = *xx;
+		xy.y = *yy;
+		errno = 0;
+		pj_ctx_set_errno( P->ctx, 0 );
+		lp = (*P->inv)(xy, P);
+		if (P->ctx->last_errno == 0 && errno != 0)
+			pj_ctx_set_errno( P->ctx, errno );
+		if (P->ctx->last_errno) {
+			err = P->ctx->last_errno;
+			*xx = *yy = HUGE_VAL;
+		} else {
+			*xx = lp.lam;
+			*yy = lp.phi;
+		}
+	}
+	/* reduce from del lp.lam */
+	for (i = 0, xx = x, yy = y; i < n; ++i, xx += stride, yy += stride) {
+		if (*xx == HUGE_VAL)
+			continue;
+		*xx += P->lam0;
+		if (!P->over)
+			*xx = adjlon(*xx);
+		if (P->geoc && fabs(fabs(*yy)-HALFPI) > EPS)
+			*yy = atan(P->one_es * tan(*yy));
+	}
+	pj_ctx_set_errno( P->ctx, err );
+	return err;
+}
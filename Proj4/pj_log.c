@@ -0,0 +1,55 @@
+/* debug and error message logging through the projCtx logger */
+#include <projects.h>
+#include <string.h>
+#include <stdarg.h>
+
+#if defined(_MSC_VER) && !defined(vsnprintf)
+#  define vsnprintf _vsnprintf
+#endif
+
+#define MAX_LOG_MSG 2048
+
+/************************************************************************/
+/*                          pj_stderr_logger()                          */
+/************************************************************************/
+
+void pj_stderr_logger( void *app_data, int level, const char *msg )
+
+{
+    fprintf( stderr, "%s\n", msg );
+}
+
+/************************************************************************/
+/*                              pj_vlog()                               */
+/************************************************************************/
+
+void pj_vlog( projCtx ctx, int level, const char *fmt, va_list args )
+
+{
+    char msg_buf[MAX_LOG_MSG];
+
+    if( level > ctx->debug_level || ctx->logger == NULL )
+        return;
+
+    vsnprintf( msg_buf, sizeof(msg_buf), fmt, args );
+    msg_buf[sizeof(msg_buf)-1] = '\0';
+
+    ctx->logger( ctx->app_data, level, msg_buf );
+}
+
+/************************************************************************/
+/*                               pj_log()                               */
+/************************************************************************/
+
+void pj_log( projCtx ctx, int level, const char *fmt, ... )
+
+{
+    va_list args;
+
+    if( level > ctx->debug_level )
+        return;
+
+    va_start( args, fmt );
+    pj_vlog( ctx, level, fmt, args );
+    va_end( args );
+}
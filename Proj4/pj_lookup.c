@@ -0,0 +1,140 @@
+/* Keyword lookup in the projection, ellipsoid, datum, units and pm tables */
+#include <projects.h>
+#include <string.h>
+
+/*
+** Each table is a NULL id terminated array of structs starting with
+** the char *id keyword.  On first use a sorted index of the entries is
+** built, after which lookups are a binary search.  Entries with equal
+** ids stay in table order, so the first one still wins as it did with
+** the old linear scans.
+*/
+
+typedef struct {
+    const void  *table;
+    size_t      stride;
+    int         count;
+    int         *order;         /* entry numbers sorted by id */
+} PJ_TABLE_INDEX;
+
+#define TABLE_ID(t,i) (*(const char * const *) \
+                       ((const char *) (t)->table + (size_t) (i) * (t)->stride))
+
+static PJ_TABLE_INDEX *sort_table = NULL;  /* for qsort() comparisons */
+
+static PJ_TABLE_INDEX proj_index   = { pj_list, sizeof(struct PJ_LIST), 0, NULL };
+static PJ_TABLE_INDEX ellps_index  = { pj_ellps, sizeof(struct PJ_ELLPS), 0, NULL };
+static PJ_TABLE_INDEX datums_index = { pj_datums, sizeof(struct PJ_DATUMS), 0, NULL };
+static PJ_TABLE_INDEX units_index  = { pj_units, sizeof(struct PJ_UNITS), 0, NULL };
+static PJ_TABLE_INDEX pm_index     = { pj_prime_meridians,
+                                       sizeof(struct PJ_PRIME_MERIDIANS), 0, NULL };
+
+/************************************************************************/
+/*                            compare_ids()                             */
+/************************************************************************/
+
+static int compare_ids( const void *a, const void *b )
+
+{
+    int ia = *(const int *) a, ib = *(const int *) b;
+    int result = strcmp( TABLE_ID(sort_table,ia), TABLE_ID(sort_table,ib) );
+
+    if( result != 0 )
+        return result;
+
+    return ia < ib ? -1 : ia > ib;
+}
+
+/************************************************************************/
+/*                            table_lookup()                            */
+/*                                                                      */
+/*      Return the number of the first entry with the given id, or      */
+/*      -1 if there is none.                                            */
+/************************************************************************/
+
+static int table_lookup( PJ_TABLE_INDEX *t, const char *name )
+
+{
+    int lo, hi, result = -1;
+
+    pj_acquire_lock();
+
+    if( t->order == NULL )
+    {
+        int *order, i;
+
+        for( t->count = 0; TABLE_ID(t,t->count) != NULL; t->count++ ) {}
+
+        order = (int *) pj_malloc(sizeof(int) * (t->count+1));
+        if( order == NULL )
+        {
+            /* fall back to a linear scan */
+            for( i = 0; i < t->count; i++ )
+                if( strcmp(name, TABLE_ID(t,i)) == 0 )
+                    break;
+            pj_release_lock();
+            return i < t->count ? i : -1;
+        }
+
+        for( i = 0; i < t->count; i++ )
+            order[i] = i;
+
+        sort_table = t;
+        qsort( order, t->count, sizeof(int), compare_ids );
+        sort_table = NULL;
+
+        t->order = order;
+    }
+
+    /* find the first sorted entry not less than name */
+    lo = 0;
+    hi = t->count;
+    while( lo < hi )
+    {
+        int mid = (lo + hi) / 2;
+
+        if( strcmp(TABLE_ID(t,t->order[mid]), name) < 0 )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if( lo < t->count && strcmp(TABLE_ID(t,t->order[lo]), name) == 0 )
+        result = t->order[lo];
+
+    pj_release_lock();
+
+    return result;
+}
+
+/************************************************************************/
+/*                           pj_find_proj()                             */
+/*                                                                      */
+/*      Lookups by keyword, returning the index of the entry in the     */
+/*      corresponding table, or -1 if not found.                        */
+/************************************************************************/
+
+int pj_find_proj( const char *name )
+{
+    return table_lookup( &proj_index, name );
+}
+
+int pj_find_ellps( const char *name )
+{
+    return table_lookup( &ellps_index, name );
+}
+
+int pj_find_datum( const char *name )
+{
+    return table_lookup( &datums_index, name );
+}
+
+int pj_find_units( const char *name )
+{
+    return table_lookup( &units_index, name );
+}
+
+int pj_find_prime_meridian( const char *name )
+{
+    return table_lookup( &pm_index, name );
+}
@@ -5,6 +5,35 @@
 #include <projects.h>
 #include <errno.h>
 
+/*
+** The counters are updated without the lock, since pj_malloc() is also
+** called with it held.  With gcc style atomics they are exact, otherwise
+** they may miss updates made concurrently.
+*/
+#if defined(__GNUC__) && !defined(PJ_NO_ATOMIC_COUNTERS)
+#  define PJ_COUNT(counter,n)	__sync_fetch_and_add(&(counter), (n))
+#else
+#  define PJ_COUNT(counter,n)	((counter) += (n))
+#endif
+
+static void *(*alloc_func)(size_t) = malloc;
+static void (*free_func)(void *) = free;
+static long alloc_count = 0, free_count = 0, alloc_bytes = 0;
+
+	void /* replace the allocator, before anything has been allocated */
+pj_set_allocator(void *(*alloc)(size_t), void (*dealloc)(void *)) {
+	alloc_func = alloc ? alloc : malloc;
+	free_func = dealloc ? dealloc : free;
+}
+	void /* allocations and frees made so far, and bytes requested */
+pj_get_alloc_stats(long *allocs, long *frees, long *bytes) {
+	if (allocs)
+		*allocs = alloc_count;
+	if (frees)
+		*frees = free_count;
+	if (bytes)
+		*bytes = alloc_bytes;
+}
 	void *
 pj_malloc(size_t size) {
 // Currently, pj_malloc is a hack to solve an errno problem.
@@ -14,12 +43,19 @@ pj_malloc(size_t size) {
 // (under debian/glibs-2.3.2) assume that pj_malloc resets 
 // errno after success. pj_malloc tries to mimic this.
         int old_errno = errno;
-        void *res = malloc(size);       
+        void *res = alloc_func(size);
+        if ( res ) {
+                PJ_COUNT(alloc_count, 1);
+                PJ_COUNT(alloc_bytes, (long) size);
+        }
         if ( res && !old_errno )
                 errno = 0;        	 
         return res;
 }
 	void
 pj_dalloc(void *ptr) {
-	free(ptr);
+	if (ptr) {
+		PJ_COUNT(free_count, 1);
+		free_func(ptr);
+	}
 }
@@ -91,6 +91,18 @@ static void pj_init_lock()
 {
 }
 
+/************************************************************************/
+/*         pj_acquire_gridcache_lock(), pj_release_gridcache_lock()     */
+/************************************************************************/
+
+void pj_acquire_gridcache_lock()
+{
+}
+
+void pj_release_gridcache_lock()
+{
+}
+
 #endif // def MUTEX_stub
 
 /************************************************************************/
@@ -104,6 +116,7 @@ static void pj_init_lock()
 #include "pthread.h"
 
 static pthread_mutex_t core_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t gridcache_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /************************************************************************/
 /*                          pj_acquire_lock()                           */
@@ -143,6 +156,27 @@ static void pj_init_lock()
 {
 }
 
+/************************************************************************/
+/*                      pj_acquire_gridcache_lock()                     */
+/*                                                                      */
+/*      Acquire the lock of the grid shift tile cache, which is held    */
+/*      for every cell lookup and so kept apart from the PROJ.4 lock.   */
+/************************************************************************/
+
+void pj_acquire_gridcache_lock()
+{
+    pthread_mutex_lock( &gridcache_lock );
+}
+
+/************************************************************************/
+/*                      pj_release_gridcache_lock()                     */
+/************************************************************************/
+
+void pj_release_gridcache_lock()
+{
+    pthread_mutex_unlock( &gridcache_lock );
+}
+
 #endif // def MUTEX_pthread
 
 /************************************************************************/
@@ -156,6 +190,7 @@ static void pj_init_lock()
 #include <windows.h>
 
 static HANDLE mutex_lock = NULL;
+static HANDLE gridcache_lock = NULL;
 
 /************************************************************************/
 /*                          pj_acquire_lock()                           */
@@ -195,6 +230,11 @@ void pj_cleanup_lock()
         CloseHandle( mutex_lock );
         mutex_lock = NULL;
     }
+    if( gridcache_lock != NULL )
+    {
+        CloseHandle( gridcache_lock );
+        gridcache_lock = NULL;
+    }
 }
 
 /************************************************************************/
@@ -208,5 +248,29 @@ static void pj_init_lock()
         mutex_lock = CreateMutex( NULL, TRUE, NULL );
 }
 
+/************************************************************************/
+/*                      pj_acquire_gridcache_lock()                     */
+/*                                                                      */
+/*      Acquire the lock of the grid shift tile cache, which is held    */
+/*      for every cell lookup and so kept apart from the PROJ.4 lock.   */
+/************************************************************************/
+
+void pj_acquire_gridcache_lock()
+{
+    if( gridcache_lock == NULL )
+        gridcache_lock = CreateMutex( NULL, FALSE, NULL );
+
+    WaitForSingleObject( gridcache_lock, INFINITE );
+}
+
+/************************************************************************/
+/*                      pj_release_gridcache_lock()                     */
+/************************************************************************/
+
+void pj_release_gridcache_lock()
+{
+    ReleaseMutex( gridcache_lock );
+}
+
 #endif // def MUTEX_win32
 
@@ -2,6 +2,117 @@
 #include <projects.h>
 #include <stdio.h>
 #include <string.h>
+
+/*
+** Once a PJ's parameter list is complete it is packed (see
+** pj_param_pack()) into a single allocation holding an index followed
+** by the entries.  The index, found through the head entry, is an open
+** addressing hash table of the first entry for each name, which also
+** keeps numeric values once parsed.  Entries appended to the list after
+** that, like the temporary ellipsoid values of pj_ell_set(), live on
+** the heap as before and are found by a linear scan past the last
+** packed entry.
+*/
+typedef struct {
+	paralist *node;
+	unsigned long hash;
+	int keylen;
+	char have_d, have_r;
+	double d, r;
+} PARAM_SLOT;
+
+struct PJ_PARAM_INDEX {
+	paralist *last;		/* last entry packed */
+	char *begin, *end;	/* where the packed entries are */
+	int alloc;		/* slots, a power of two */
+	PARAM_SLOT slots[1];
+};
+
+/* packed entries are aligned for the pointer they start with */
+#define PARAM_ALIGN(n)	(((n) + sizeof(paralist *) - 1) & \
+			 ~(sizeof(paralist *) - 1))
+
+	static unsigned long /* FNV-1a hash of the first len chars of key */
+param_hash(const char *key, int len) {
+	unsigned long hash = 2166136261UL;
+
+	while (len-- > 0)
+		hash = ((hash ^ (unsigned char) *key++) * 16777619UL) & 0xffffffffUL;
+	return hash;
+}
+
+	static PARAM_SLOT * /* slot for a name, or empty slot where it belongs */
+param_probe(struct PJ_PARAM_INDEX *index, const char *key, int len,
+            unsigned long hash) {
+	int i = (int) (hash & (index->alloc - 1));
+	PARAM_SLOT *slot;
+
+	while ((slot = index->slots + i)->node &&
+	  (slot->hash != hash || slot->keylen != len ||
+	   strncmp(slot->node->param, key, len)))
+		i = (i + 1) & (index->alloc - 1);
+	return slot;
+}
+
+	paralist * /* pack and index a complete, unpacked parameter list */
+pj_param_pack(paralist *pl) {
+	struct PJ_PARAM_INDEX *index;
+	paralist *curr, *head = 0, *tail = 0;
+	size_t head_size, size;
+	char *next;
+	int alloc, n;
+
+	for (n = 0, size = 0, curr = pl; curr; curr = curr->next, ++n)
+		size += PARAM_ALIGN(sizeof(paralist) + strlen(curr->param));
+	for (alloc = 8; alloc < 2 * n; alloc *= 2) ;
+	head_size = PARAM_ALIGN(sizeof(struct PJ_PARAM_INDEX) +
+	  sizeof(PARAM_SLOT) * (alloc - 1));
+	if (!pl || !(index = (struct PJ_PARAM_INDEX *)pj_malloc(head_size + size)))
+		return pl; /* lookups stay linear */
+	memset(index, 0, head_size);
+	index->alloc = alloc;
+	index->begin = next = (char *)index + head_size;
+	index->end = index->begin + size;
+	for (curr = pl; curr; curr = curr->next) {
+		paralist *item = (paralist *)next;
+		int len = strcspn(curr->param, "=");
+		unsigned long hash = param_hash(curr->param, len);
+		PARAM_SLOT *slot = param_probe(index, curr->param, len, hash);
+
+		next += PARAM_ALIGN(sizeof(paralist) + strlen(curr->param));
+		item->next = 0;
+		item->index = 0;
+		item->used = curr->used;
+		strcpy(item->param, curr->param);
+		if (tail)
+			tail = tail->next = item;
+		else
+			head = tail = item;
+		if (!slot->node) { /* first one wins */
+			slot->node = item;
+			slot->hash = hash;
+			slot->keylen = len;
+		}
+	}
+	index->last = tail;
+	head->index = index;
+	pj_param_free(pl);
+	return head;
+}
+
+	void /* free a parameter list, packed or not */
+pj_param_free(paralist *pl) {
+	struct PJ_PARAM_INDEX *index = pl ? pl->index : 0;
+	paralist *n;
+
+	for ( ; pl; pl = n) {
+		n = pl->next;
+		if (!index || (char *)pl < index->begin || (char *)pl >= index->end)
+			pj_dalloc(pl);
+	}
+	pj_dalloc(index);
+}
+
 	paralist * /* create parameter list entry */
 pj_mkparam(char *str) {
 	paralist *newitem;
@@ -9,6 +120,7 @@ pj_mkparam(char *str) {
 	if ((newitem = (paralist *)pj_malloc(sizeof(paralist) + strlen(str)))) {
 		newitem->used = 0;
 		newitem->next = 0;
+		newitem->index = 0;
 		if (*str == '+')
 			++str;
 		(void)strcpy(newitem->param, str);
@@ -34,17 +146,28 @@ pj_mkparam(char *str) {
 /************************************************************************/
 
 	PVALUE /* test for presence or get parameter value */
-pj_param(paralist *pl, char *opt) {
+pj_param(projCtx ctx, paralist *pl, char *opt) {
 	int type;
 	unsigned l;
 	PVALUE value;
+	PARAM_SLOT *slot = 0;
 
 	type = *opt++;
-	/* simple linear lookup */
 	l = strlen(opt);
-	while (pl && !(!strncmp(pl->param, opt, l) &&
-	  (!pl->param[l] || pl->param[l] == '=')))
-		pl = pl->next;
+	if (pl && pl->index) {
+		slot = param_probe(pl->index, opt, l, param_hash(opt, l));
+		if (slot->node)
+			pl = slot->node;
+		else {
+			slot = 0;
+			pl = pl->index->last->next;
+		}
+	}
+	/* simple linear lookup */
+	if (!slot)
+		while (pl && !(!strncmp(pl->param, opt, l) &&
+		  (!pl->param[l] || pl->param[l] == '=')))
+			pl = pl->next;
 	if (type == 't')
 		value.i = pl != 0;
 	else if (pl) {
@@ -57,10 +180,29 @@ pj_param(paralist *pl, char *opt) {
 			value.i = atoi(opt);
 			break;
 		case 'd':	/* simple real input */
-			value.f = atof(opt);
+			if (slot && slot->have_d)
+				value.f = slot->d;
+			else {
+				value.f = atof(opt);
+				if (slot) {
+					slot->d = value.f;
+					slot->have_d = 1;
+				}
+			}
 			break;
 		case 'r':	/* degrees input */
-			value.f = dmstor(opt, 0);
+			if (slot && slot->have_r)
+				value.f = slot->r;
+			else {
+				int err = ctx->last_errno;
+
+				value.f = dmstor_ctx(ctx, opt, 0);
+				/* keep it only if it parsed cleanly */
+				if (slot && !err && !ctx->last_errno) {
+					slot->r = value.f;
+					slot->have_r = 1;
+				}
+			}
 			break;
 		case 's':	/* char string */
 			value.s = opt;
@@ -74,7 +216,7 @@ pj_param(paralist *pl, char *opt) {
 				value.i = 1;
 				break;
 			default:
-				pj_errno = -8;
+				pj_ctx_set_errno( ctx, -8 );
 				value.i = 0;
 				break;
 			}
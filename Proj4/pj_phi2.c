@@ -6,7 +6,7 @@
 #define N_ITER 15
 
 	double
-pj_phi2(double ts, double e) {
+pj_phi2(projCtx ctx, double ts, double e) {
 	double eccnth, Phi, con, dphi;
 	int i;
 
@@ -20,6 +20,53 @@ pj_phi2(double ts, double e) {
 		Phi += dphi;
 	} while ( fabs(dphi) > TOL && --i);
 	if (i <= 0)
-		pj_errno = -18;
+		pj_ctx_set_errno( ctx, -18 );
 	return Phi;
 }
+/*
+** pj_phi2() of n values of ts, in place.  Values are taken LANES at a
+** time and every lane of a group is iterated together, with lanes that
+** have converged masked out of the update.  The inner loop is then free
+** of data dependent exits, and each lane sees exactly the iterations
+** the scalar version would, giving identical results.  Lanes that fail
+** to converge are set to HUGE_VAL, HUGE_VAL input passes through.
+*/
+#define LANES 4
+	void
+pj_phi2_n(projCtx ctx, long n, int stride, double *ts, double e) {
+	double eccnth, Phi[LANES], t[LANES], con, dphi;
+	int active[LANES], left, lanes, i, j;
+	long b;
+
+	eccnth = .5 * e;
+	for (b = 0; b < n; b += LANES, ts += LANES * stride) {
+		lanes = n - b < LANES ? (int)(n - b) : LANES;
+		left = 0;
+		for (j = 0; j < LANES; ++j) {
+			active[j] = j < lanes && ts[j * stride] != HUGE_VAL;
+			t[j] = active[j] ? ts[j * stride] : 0.;
+			Phi[j] = HALFPI - 2. * atan (t[j]);
+			left += active[j];
+		}
+		for (i = N_ITER; left && i; --i) {
+			left = 0;
+			for (j = 0; j < LANES; ++j) {
+				con = e * sin (Phi[j]);
+				dphi = HALFPI - 2. * atan (t[j] * pow((1. - con) /
+				   (1. + con), eccnth)) - Phi[j];
+				Phi[j] = active[j] ? Phi[j] + dphi : Phi[j];
+				active[j] = active[j] && fabs(dphi) > TOL;
+				left += active[j];
+			}
+		}
+		for (j = 0; j < lanes; ++j) {
+			if (ts[j * stride] == HUGE_VAL)
+				continue;
+			if (active[j]) {
+				ts[j * stride] = HUGE_VAL;
+				pj_ctx_set_errno( ctx, -18 );
+			} else
+				ts[j * stride] = Phi[j];
+		}
+	}
+}
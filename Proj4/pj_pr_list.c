@@ -50,6 +50,10 @@ pj_pr_list(PJ *P) {
 /*      Returns the PROJ.4 command string that would produce this       */
 /*      definition expanded as much as possible.  For instance,         */
 /*      +init= calls and +datum= defintions would be expanded.          */
+/*                                                                      */
+/*      With PJ_DEF_ALL_PARAMS in options, parameters that were never   */
+/*      consulted are kept too, so the string reproduces the original   */
+/*      parameter list exactly.                                         */
 /************************************************************************/
 
 char *pj_get_def( PJ *P, int options )
@@ -66,7 +70,7 @@ char *pj_get_def( PJ *P, int options )
     for (t = P->params; t; t = t->next)
     {
         /* skip unused parameters ... mostly appended defaults and stuff */
-        if (!t->used)
+        if (!t->used && !(options & PJ_DEF_ALL_PARAMS))
             continue;
 
         /* grow the resulting string if needed */
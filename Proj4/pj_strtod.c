@@ -0,0 +1,310 @@
+/* Locale independent conversion between doubles and decimal text */
+#include <projects.h>
+#include <string.h>
+#include <ctype.h>
+#include <float.h>
+#include <locale.h>
+
+#if defined(_MSC_VER) && !defined(snprintf)
+#  define snprintf _snprintf
+#endif
+
+/*
+** pj_strtod() reads plain decimal numbers, [sign] digits [. digits]
+** [e [sign] digits], with '.' as the decimal point whatever the locale.
+** When the significant digits fit a double exactly and the power of ten
+** is at most 22, one multiplication or division of two exact values
+** gives the correctly rounded result (Clinger's fast path).  Anything
+** else goes through strtod(), which also rounds correctly.
+**
+** pj_format_double() formats "%f" style conversions itself, rounding
+** the scaled value to an integer and writing its digits.  When the
+** scaled value is too close to a rounding boundary for that to be sure
+** of matching printf(), or for any other conversion, it uses snprintf().
+*/
+
+#define MAX_EXACT       9007199254740992.0      /* 2^53 */
+#define MAX_POW10       22
+#define MAX_FAST_DIGITS 17                      /* fractional digits */
+#define NUMBER_BUF      64
+
+/* exact powers of ten */
+static const double pow10_tab[MAX_POW10+1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+** The fast path needs each operation rounded straight to double, which
+** excess precision (x87 without precision control) would break.
+*/
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+#  define NO_FAST_PATH
+#endif
+
+/************************************************************************/
+/*                          locale_strtod()                             */
+/*                                                                      */
+/*      strtod() on the count characters of a scanned number, with      */
+/*      '.' swapped for the decimal point of the current locale.        */
+/************************************************************************/
+
+static double locale_strtod( const char *number, int count )
+
+{
+    char        buf[NUMBER_BUF], *work = buf, point;
+    double      result;
+    int         i;
+
+    if( count >= NUMBER_BUF )
+    {
+        work = (char *) pj_malloc( count + 1 );
+        if( work == NULL )
+            return strtod( number, NULL );
+    }
+
+    point = localeconv()->decimal_point[0];
+    for( i = 0; i < count; i++ )
+        work[i] = number[i] == '.' ? point : number[i];
+    work[count] = '\0';
+
+    result = strtod( work, NULL );
+
+    if( work != buf )
+        pj_dalloc( work );
+
+    return result;
+}
+
+/************************************************************************/
+/*                             pj_strtod()                              */
+/*                                                                      */
+/*      As strtod(), but independent of the locale.  Only decimal       */
+/*      numbers are read, so a 'd' ends the number as dmstor() needs.   */
+/*      Text without leading digits (inf, nan) and hexadecimal numbers  */
+/*      are passed on to strtod() as they are.                          */
+/************************************************************************/
+
+double pj_strtod( const char *nptr, char **endptr )
+
+{
+    const char  *s = nptr, *start;
+    double      mantissa = 0.0, result;
+    int         negative = 0, inexact = 0, exponent = 0;
+
+    while( isspace((unsigned char) *s) )
+        s++;
+
+    start = s;
+    if( *s == '+' || *s == '-' )
+        negative = *s++ == '-';
+
+    if( !isdigit((unsigned char) *s)
+        && !(*s == '.' && isdigit((unsigned char) s[1])) )
+        return strtod( nptr, endptr );
+
+    if( s[0] == '0' && (s[1] == 'x' || s[1] == 'X') )
+        return strtod( nptr, endptr );
+
+/* -------------------------------------------------------------------- */
+/*      Collect the digits while they are exact in a double, only       */
+/*      keeping track of the scale for the rest.                        */
+/* -------------------------------------------------------------------- */
+    for( ; isdigit((unsigned char) *s); s++ )
+    {
+        if( mantissa <= (MAX_EXACT - 9) / 10 )
+            mantissa = mantissa * 10 + (*s - '0');
+        else
+        {
+            exponent++;
+            inexact |= *s != '0';
+        }
+    }
+
+    if( *s == '.' )
+    {
+        for( s++; isdigit((unsigned char) *s); s++ )
+        {
+            if( mantissa <= (MAX_EXACT - 9) / 10 )
+            {
+                mantissa = mantissa * 10 + (*s - '0');
+                exponent--;
+            }
+            else
+                inexact |= *s != '0';
+        }
+    }
+
+    if( (*s == 'e' || *s == 'E')
+        && (isdigit((unsigned char) s[1])
+            || ((s[1] == '+' || s[1] == '-')
+                && isdigit((unsigned char) s[2]))) )
+    {
+        int exp_negative = 0, value = 0;
+
+        s++;
+        if( *s == '+' || *s == '-' )
+            exp_negative = *s++ == '-';
+        for( ; isdigit((unsigned char) *s); s++ )
+            if( value < 100000 )
+                value = value * 10 + (*s - '0');
+
+        exponent += exp_negative ? -value : value;
+    }
+
+    if( endptr )
+        *endptr = (char *) s;
+
+#ifndef NO_FAST_PATH
+    if( mantissa == 0.0 )
+        return negative ? -0.0 : 0.0;
+
+    if( !inexact && exponent >= -MAX_POW10 && exponent <= MAX_POW10 )
+    {
+        if( exponent < 0 )
+            result = mantissa / pow10_tab[-exponent];
+        else
+            result = mantissa * pow10_tab[exponent];
+
+        return negative ? -result : result;
+    }
+#endif
+
+    return locale_strtod( start, (int) (s - start) );
+}
+
+/************************************************************************/
+/*                           format_fixed()                             */
+/*                                                                      */
+/*      Write value with precision fractional digits, right justified   */
+/*      in width, as printf() would.  Returns the length, 0 if the      */
+/*      value cannot be done exactly here, or -1 if size is too small.  */
+/************************************************************************/
+
+static int format_fixed( char *buf, int size, double value, int width,
+                         int precision )
+
+{
+    char        digits[48], *d = digits + sizeof(digits);
+    double      scaled, whole, fraction, rest;
+    unsigned long low, high;
+    int         negative, count, length, i;
+
+    if( precision > MAX_FAST_DIGITS )
+        return 0;
+
+    negative = value < 0.0 || (value == 0.0 && 1.0 / value < 0.0);
+    scaled = fabs(value) * pow10_tab[precision];
+
+    /* also false for NaN */
+    if( !(scaled < MAX_EXACT / 2) )
+        return 0;
+
+/* -------------------------------------------------------------------- */
+/*      scaled is within half an ulp of the exact product, so away      */
+/*      from the halfway points it rounds to the same integer.          */
+/* -------------------------------------------------------------------- */
+    whole = floor( scaled );
+    fraction = scaled - whole;
+    if( fabs(fraction - 0.5) <= scaled * (4.0 / MAX_EXACT) )
+        return 0;
+    if( fraction > 0.5 )
+        whole += 1.0;
+
+/* -------------------------------------------------------------------- */
+/*      Split into two parts of up to nine digits, which fit in an      */
+/*      unsigned long, and write the digits backwards.                  */
+/* -------------------------------------------------------------------- */
+    high = (unsigned long) floor( whole / 1e9 );
+    rest = whole - high * 1e9;
+    if( rest < 0.0 )
+    {
+        high--;
+        rest += 1e9;
+    }
+    else if( rest >= 1e9 )
+    {
+        high++;
+        rest -= 1e9;
+    }
+    low = (unsigned long) rest;
+
+    for( count = 0; count <= precision || low != 0 || high != 0; count++ )
+    {
+        if( count == precision && precision > 0 )
+            *--d = '.';
+        *--d = (char) ('0' + low % 10);
+        low /= 10;
+        if( count % 9 == 8 )
+        {
+            low = high;
+            high = 0;
+        }
+    }
+
+    if( negative )
+        *--d = '-';
+
+    length = (int) (digits + sizeof(digits) - d);
+    if( width < length )
+        width = length;
+    if( width >= size )
+        return -1;
+
+    for( i = 0; i < width - length; i++ )
+        buf[i] = ' ';
+    memcpy( buf + i, d, length );
+    buf[width] = '\0';
+
+    return width;
+}
+
+/************************************************************************/
+/*                          pj_format_double()                          */
+/*                                                                      */
+/*      Format value with a printf() format holding one double          */
+/*      conversion, such as the -f option of proj and cs2cs takes,      */
+/*      giving the same text as printf() in the "C" locale.  Returns    */
+/*      the length written to buf, or -1 if it does not fit in size.    */
+/************************************************************************/
+
+int pj_format_double( char *buf, int size, const char *format, double value )
+
+{
+    const char  *f = format;
+    int         width = 0, precision = 6, length;
+    char        point, *p;
+
+    /* only "%[width][.precision]f", without flags */
+    if( f[0] == '%' && f[1] != '0' )
+    {
+        for( f++; isdigit((unsigned char) *f); f++ )
+            if( width < 1000 )
+                width = width * 10 + (*f - '0');
+
+        if( *f == '.' )
+        {
+            for( precision = 0, f++; isdigit((unsigned char) *f); f++ )
+                if( precision < 1000 )
+                    precision = precision * 10 + (*f - '0');
+        }
+
+        if( f[0] == 'f' && f[1] == '\0' && width < 1000 )
+        {
+            length = format_fixed( buf, size, value, width, precision );
+            if( length != 0 )
+                return length;
+        }
+    }
+
+    length = snprintf( buf, size, format, value );
+    if( length < 0 || length >= size )
+        return -1;
+
+    point = localeconv()->decimal_point[0];
+    if( point != '.' && point != '\0' )
+        for( p = buf; (p = strchr( p, point )) != NULL; p++ )
+            *p = '.';
+
+    return length;
+}
@@ -32,6 +32,7 @@
 #include <projects.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
 #include "geocent.h"
 
 PJ_CVSID("$Id: pj_transform.c 1504 2009-01-06 02:11:57Z warmerdam $");
@@ -85,9 +86,10 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
 
 {
     long      i;
-    int       need_datum_shift;
+    int       err;
 
-    pj_errno = 0;
+    pj_ctx_set_errno( srcdefn->ctx, 0 );
+    pj_ctx_set_errno( dstdefn->ctx, 0 );
 
     if( point_offset == 0 )
         point_offset = 1;
@@ -99,7 +101,7 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
     {
         if( z == NULL )
         {
-            pj_errno = PJD_ERR_GEOCENTRIC;
+            pj_ctx_set_errno( srcdefn->ctx, PJD_ERR_GEOCENTRIC );
             return PJD_ERR_GEOCENTRIC;
         }
 
@@ -115,10 +117,14 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
             }
         }
 
-        if( pj_geocentric_to_geodetic( srcdefn->a_orig, srcdefn->es_orig,
-                                       point_count, point_offset, 
-                                       x, y, z ) != 0) 
-            return pj_errno;
+        err = pj_geocentric_to_geodetic( srcdefn->a_orig, srcdefn->es_orig,
+                                         point_count, point_offset, 
+                                         x, y, z );
+        if( err != 0 )
+        {
+            pj_ctx_set_errno( srcdefn->ctx, err );
+            return err;
+        }
     }
 
 /* -------------------------------------------------------------------- */
@@ -129,13 +135,11 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
     {
         if( srcdefn->inv == NULL )
         {
-            pj_errno = -17; /* this isn't correct, we need a no inverse err */
-            if( getenv( "PROJ_DEBUG" ) != NULL )
-            {
-                fprintf( stderr, 
-                       "pj_transform(): source projection not invertable\n" );
-            }
-            return pj_errno;
+            /* this isn't correct, we need a no inverse err */
+            pj_ctx_set_errno( srcdefn->ctx, -17 );
+            pj_log( srcdefn->ctx, PJ_LOG_ERROR,
+                    "pj_transform(): source projection not invertable" );
+            return -17;
         }
 
         for( i = 0; i < point_count; i++ )
@@ -150,12 +154,13 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
                 continue;
 
             geodetic_loc = pj_inv( projected_loc, srcdefn );
-            if( pj_errno != 0 )
+            err = srcdefn->ctx->last_errno;
+            if( err != 0 )
             {
-                if( (pj_errno != 33 /*EDOM*/ && pj_errno != 34 /*ERANGE*/ )
-                    && (pj_errno > 0 || pj_errno < -44 || point_count == 1
-                        || transient_error[-pj_errno] == 0 ) )
-                    return pj_errno;
+                if( (err != 33 /*EDOM*/ && err != 34 /*ERANGE*/ )
+                    && (err > 0 || err < -44 || point_count == 1
+                        || transient_error[-err] == 0 ) )
+                    return err;
                 else
                 {
                     geodetic_loc.u = HUGE_VAL;
@@ -183,9 +188,10 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
 /* -------------------------------------------------------------------- */
 /*      Convert datums if needed, and possible.                         */
 /* -------------------------------------------------------------------- */
-    if( pj_datum_transform( srcdefn, dstdefn, point_count, point_offset, 
-                            x, y, z ) != 0 )
-        return pj_errno;
+    err = pj_datum_transform( srcdefn, dstdefn, point_count, point_offset, 
+                              x, y, z );
+    if( err != 0 )
+        return err;
 
 /* -------------------------------------------------------------------- */
 /*      But if they are staying lat long, adjust for the prime          */
@@ -208,7 +214,7 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
     {
         if( z == NULL )
         {
-            pj_errno = PJD_ERR_GEOCENTRIC;
+            pj_ctx_set_errno( dstdefn->ctx, PJD_ERR_GEOCENTRIC );
             return PJD_ERR_GEOCENTRIC;
         }
 
@@ -246,12 +252,13 @@ int pj_transform( PJ *srcdefn, PJ *dstdefn, long point_count, int point_offset,
                 continue;
 
             projected_loc = pj_fwd( geodetic_loc, dstdefn );
-            if( pj_errno != 0 )
+            err = dstdefn->ctx->last_errno;
+            if( err != 0 )
             {
-                if( (pj_errno != 33 /*EDOM*/ && pj_errno != 34 /*ERANGE*/ )
-                    && (pj_errno > 0 || pj_errno < -44 || point_count == 1
-                        || transient_error[-pj_errno] == 0 ) )
-                    return pj_errno;
+                if( (err != 33 /*EDOM*/ && err != 34 /*ERANGE*/ )
+                    && (err > 0 || err < -44 || point_count == 1
+                        || transient_error[-err] == 0 ) )
+                    return err;
                 else
                 {
                     projected_loc.u = HUGE_VAL;
@@ -295,10 +302,8 @@ int pj_geodetic_to_geocentric( double a, double es,
 
 {
     double b;
-    int    i;
     GeocentricInfo gi;
-
-    pj_errno = 0;
+    int    ret_errno = 0;
 
     if( es == 0.0 )
         b = a;
@@ -306,28 +311,14 @@ int pj_geodetic_to_geocentric( double a, double es,
         b = a * sqrt(1-es);
 
     if( pj_Set_Geocentric_Parameters( &gi, a, b ) != 0 )
-    {
-        pj_errno = PJD_ERR_GEOCENTRIC;
-        return pj_errno;
-    }
+        return PJD_ERR_GEOCENTRIC;
 
-    for( i = 0; i < point_count; i++ )
-    {
-        long io = i * point_offset;
-
-        if( x[io] == HUGE_VAL  )
-            continue;
+    /* points that fail are set to HUGE_VAL, but keep processing points! */
+    if( pj_Convert_Geodetic_To_Geocentric_Array( &gi, point_count, point_offset,
+                                                 x, y, z ) != 0 )
+        ret_errno = -14;
 
-        if( pj_Convert_Geodetic_To_Geocentric( &gi, y[io], x[io], z[io], 
-                                               x+io, y+io, z+io ) != 0 )
-        {
-            pj_errno = -14;
-            x[io] = y[io] = HUGE_VAL;
-            /* but keep processing points! */
-        }
-    }
-
-    return pj_errno;
+    return ret_errno;
 }
 
 /************************************************************************/
@@ -340,7 +331,6 @@ int pj_geocentric_to_geodetic( double a, double es,
 
 {
     double b;
-    int    i;
     GeocentricInfo gi;
 
     if( es == 0.0 )
@@ -349,21 +339,10 @@ int pj_geocentric_to_geodetic( double a, double es,
         b = a * sqrt(1-es);
 
     if( pj_Set_Geocentric_Parameters( &gi, a, b ) != 0 )
-    {
-        pj_errno = PJD_ERR_GEOCENTRIC;
-        return pj_errno;
-    }
-
-    for( i = 0; i < point_count; i++ )
-    {
-        long io = i * point_offset;
-
-        if( x[io] == HUGE_VAL )
-            continue;
+        return PJD_ERR_GEOCENTRIC;
 
-        pj_Convert_Geocentric_To_Geodetic( &gi, x[io], y[io], z[io], 
-                                           y+io, x+io, z+io );
-    }
+    pj_Convert_Geocentric_To_Geodetic_Array( &gi, point_count, point_offset,
+                                             x, y, z );
 
     return 0;
 }
@@ -407,8 +386,8 @@ int pj_compare_datums( PJ *srcdefn, PJ *dstdefn )
     }
     else if( srcdefn->datum_type == PJD_GRIDSHIFT )
     {
-        return strcmp( pj_param(srcdefn->params,"snadgrids").s,
-                       pj_param(dstdefn->params,"snadgrids").s ) == 0;
+        return strcmp( pj_param(srcdefn->ctx,srcdefn->params,"snadgrids").s,
+                       pj_param(dstdefn->ctx,dstdefn->params,"snadgrids").s ) == 0;
     }
     else
         return 1;
@@ -425,8 +404,6 @@ int pj_geocentric_to_wgs84( PJ *defn,
 {
     int       i;
 
-    pj_errno = 0;
-
     if( defn->datum_type == PJD_3PARAM )
     {
         for( i = 0; i < point_count; i++ )
@@ -475,8 +452,6 @@ int pj_geocentric_from_wgs84( PJ *defn,
 {
     int       i;
 
-    pj_errno = 0;
-
     if( defn->datum_type == PJD_3PARAM )
     {
         for( i = 0; i < point_count; i++ )
@@ -515,22 +490,61 @@ int pj_geocentric_from_wgs84( PJ *defn,
 }
 
 /************************************************************************/
-/*                         pj_datum_transform()                         */
+/* ==================================================================== */
+/*                           Datum shifting                             */
+/* ==================================================================== */
 /*                                                                      */
-/*      The input should be long/lat/z coordinates in radians in the    */
-/*      source datum, and the output should be long/lat/z               */
-/*      coordinates in radians in the destination datum.                */
+/*      What a datum shift involves is decided by datum_shift_init()    */
+/*      and carried out by datum_shift_apply().  Points are normally    */
+/*      taken through the shift PJ_DATUM_BLOCK at a time, each block    */
+/*      going through every step while it is still in cache, rather     */
+/*      than each step going through all the points.  The arithmetic    */
+/*      is the same, in the same order, as the step by step version,    */
+/*      which is still used when a step would fail for every point.     */
 /************************************************************************/
 
-int pj_datum_transform( PJ *srcdefn, PJ *dstdefn, 
-                        long point_count, int point_offset,
-                        double *x, double *y, double *z )
+#ifndef PJ_DATUM_BLOCK
+#  define PJ_DATUM_BLOCK 256
+#endif
 
-{
+static long datum_block = PJ_DATUM_BLOCK;
+
+typedef struct {
+    PJ          *srcdefn, *dstdefn;
+    int         src_grid, dst_grid;       /* apply nadgrids */
+    int         geocentric;               /* go through geocentric */
+    int         src_helmert, dst_helmert; /* PJD_3PARAM, PJD_7PARAM or 0 */
     double      src_a, src_es, dst_a, dst_es;
-    int         z_is_temp = FALSE;
+    int         gi_ok;                    /* src_gi and dst_gi are set */
+    GeocentricInfo src_gi, dst_gi;
+} PJ_DATUM_SHIFT;
+
+/************************************************************************/
+/*                      pj_set_datum_block_size()                       */
+/*                                                                      */
+/*      Set the number of points taken through the datum shift at a     */
+/*      time, for benchmarking.  A size of at least the point count     */
+/*      runs each step over all the points before the next, as the      */
+/*      step by step version does.  Zero restores PJ_DATUM_BLOCK.       */
+/*      Not to be called while a transformation is running.             */
+/************************************************************************/
+
+void pj_set_datum_block_size( long points )
+
+{
+    datum_block = points > 0 ? points : PJ_DATUM_BLOCK;
+}
+
+/************************************************************************/
+/*                          datum_shift_init()                          */
+/*                                                                      */
+/*      Returns FALSE if there is nothing to do.                        */
+/************************************************************************/
 
-    pj_errno = 0;
+static int datum_shift_init( PJ_DATUM_SHIFT *ds, PJ *srcdefn, PJ *dstdefn )
+
+{
+    memset( ds, 0, sizeof(PJ_DATUM_SHIFT) );
 
 /* -------------------------------------------------------------------- */
 /*      We cannot do any meaningful datum transformation if either      */
@@ -540,107 +554,718 @@ int pj_datum_transform( PJ *srcdefn, PJ *dstdefn,
 /* -------------------------------------------------------------------- */
     if( srcdefn->datum_type == PJD_UNKNOWN
         || dstdefn->datum_type == PJD_UNKNOWN )
-        return 0;
+        return FALSE;
 
 /* -------------------------------------------------------------------- */
 /*      Short cut if the datums are identical.                          */
 /* -------------------------------------------------------------------- */
     if( pj_compare_datums( srcdefn, dstdefn ) )
-        return 0;
+        return FALSE;
 
-    src_a = srcdefn->a_orig;
-    src_es = srcdefn->es_orig;
+    ds->srcdefn = srcdefn;
+    ds->dstdefn = dstdefn;
 
-    dst_a = dstdefn->a_orig;
-    dst_es = dstdefn->es_orig;
+    ds->src_a = srcdefn->a_orig;
+    ds->src_es = srcdefn->es_orig;
 
-/* -------------------------------------------------------------------- */
-/*      Create a temporary Z array if one is not provided.              */
-/* -------------------------------------------------------------------- */
-    if( z == NULL )
+    ds->dst_a = dstdefn->a_orig;
+    ds->dst_es = dstdefn->es_orig;
+
+    if( srcdefn->datum_type == PJD_GRIDSHIFT )
     {
-        int	bytes = sizeof(double) * point_count * point_offset;
-        z = (double *) pj_malloc(bytes);
-        memset( z, 0, bytes );
-        z_is_temp = TRUE;
+        ds->src_grid = TRUE;
+        ds->src_a = SRS_WGS84_SEMIMAJOR;
+        ds->src_es = SRS_WGS84_ESQUARED;
     }
 
-#define CHECK_RETURN {if( pj_errno != 0 && (pj_errno > 0 || transient_error[-pj_errno] == 0) ) { if( z_is_temp ) pj_dalloc(z); return pj_errno; }}
+    if( dstdefn->datum_type == PJD_GRIDSHIFT )
+    {
+        ds->dst_grid = TRUE;
+        ds->dst_a = SRS_WGS84_SEMIMAJOR;
+        ds->dst_es = SRS_WGS84_ESQUARED;
+    }
+
+    if( srcdefn->datum_type == PJD_3PARAM 
+        || srcdefn->datum_type == PJD_7PARAM )
+        ds->src_helmert = srcdefn->datum_type;
+
+    if( dstdefn->datum_type == PJD_3PARAM 
+        || dstdefn->datum_type == PJD_7PARAM )
+        ds->dst_helmert = dstdefn->datum_type;
+
+/* -------------------------------------------------------------------- */
+/*      Do we need to go through geocentric coordinates?                */
+/* -------------------------------------------------------------------- */
+    ds->geocentric = ds->src_es != ds->dst_es || ds->src_a != ds->dst_a
+        || ds->src_helmert || ds->dst_helmert;
+
+/* -------------------------------------------------------------------- */
+/*      Set up both ellipsoids once, for as long as the shift is kept.  */
+/*      If that fails the error comes from the step by step version.    */
+/* -------------------------------------------------------------------- */
+    if( ds->geocentric )
+        ds->gi_ok = 
+            pj_Set_Geocentric_Parameters( &ds->src_gi, ds->src_a, 
+                   ds->src_es == 0.0 ? ds->src_a 
+                                     : ds->src_a * sqrt(1-ds->src_es) ) == 0
+            && pj_Set_Geocentric_Parameters( &ds->dst_gi, ds->dst_a, 
+                   ds->dst_es == 0.0 ? ds->dst_a 
+                                     : ds->dst_a * sqrt(1-ds->dst_es) ) == 0;
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                        datum_shift_stepwise()                        */
+/*                                                                      */
+/*      Each step over all the points before the next, stopping at      */
+/*      the first error that is not transient.                          */
+/************************************************************************/
+
+static int datum_shift_stepwise( const PJ_DATUM_SHIFT *ds,
+                                 long point_count, int point_offset,
+                                 double *x, double *y, double *z )
+
+{
+    projCtx     ctx = ds->srcdefn->ctx;
+
+#define CHECK_RETURN {if( ctx->last_errno != 0 && (ctx->last_errno > 0 || transient_error[-ctx->last_errno] == 0) ) return ctx->last_errno;}
 
 /* -------------------------------------------------------------------- */
 /*	If this datum requires grid shifts, then apply it to geodetic   */
 /*      coordinates.                                                    */
 /* -------------------------------------------------------------------- */
-    if( srcdefn->datum_type == PJD_GRIDSHIFT )
+    if( ds->src_grid )
     {
-        pj_apply_gridshift( pj_param(srcdefn->params,"snadgrids").s, 0, 
-                            point_count, point_offset, x, y, z );
+        pj_ctx_set_errno( ctx, 
+                          pj_apply_gridshift_2( ds->srcdefn, 0, point_count, 
+                                                point_offset, x, y, z ) );
         CHECK_RETURN;
-
-        src_a = SRS_WGS84_SEMIMAJOR;
-        src_es = SRS_WGS84_ESQUARED;
     }
 
-    if( dstdefn->datum_type == PJD_GRIDSHIFT )
-    {
-        dst_a = SRS_WGS84_SEMIMAJOR;
-        dst_es = SRS_WGS84_ESQUARED;
-    }
-        
-/* ==================================================================== */
-/*      Do we need to go through geocentric coordinates?                */
-/* ==================================================================== */
-    if( src_es != dst_es || src_a != dst_a
-        || srcdefn->datum_type == PJD_3PARAM 
-        || srcdefn->datum_type == PJD_7PARAM
-        || dstdefn->datum_type == PJD_3PARAM 
-        || dstdefn->datum_type == PJD_7PARAM)
+    if( ds->geocentric )
     {
 /* -------------------------------------------------------------------- */
 /*      Convert to geocentric coordinates.                              */
 /* -------------------------------------------------------------------- */
-        pj_geodetic_to_geocentric( src_a, src_es,
-                                   point_count, point_offset, x, y, z );
+        pj_ctx_set_errno( ctx, 
+                          pj_geodetic_to_geocentric( ds->src_a, ds->src_es,
+                                                     point_count, point_offset,
+                                                     x, y, z ) );
         CHECK_RETURN;
 
 /* -------------------------------------------------------------------- */
 /*      Convert between datums.                                         */
 /* -------------------------------------------------------------------- */
-        if( srcdefn->datum_type == PJD_3PARAM 
-            || srcdefn->datum_type == PJD_7PARAM )
+        if( ds->src_helmert )
         {
-            pj_geocentric_to_wgs84( srcdefn, point_count, point_offset,x,y,z);
+            pj_geocentric_to_wgs84( ds->srcdefn, point_count, point_offset,
+                                    x, y, z );
             CHECK_RETURN;
         }
 
-        if( dstdefn->datum_type == PJD_3PARAM 
-            || dstdefn->datum_type == PJD_7PARAM )
+        if( ds->dst_helmert )
         {
-            pj_geocentric_from_wgs84( dstdefn, point_count,point_offset,x,y,z);
+            pj_geocentric_from_wgs84( ds->dstdefn, point_count, point_offset,
+                                      x, y, z );
             CHECK_RETURN;
         }
 
 /* -------------------------------------------------------------------- */
 /*      Convert back to geodetic coordinates.                           */
 /* -------------------------------------------------------------------- */
-        pj_geocentric_to_geodetic( dst_a, dst_es,
-                                   point_count, point_offset, x, y, z );
+        pj_ctx_set_errno( ctx,
+                          pj_geocentric_to_geodetic( ds->dst_a, ds->dst_es,
+                                                     point_count, point_offset,
+                                                     x, y, z ) );
         CHECK_RETURN;
     }
 
 /* -------------------------------------------------------------------- */
 /*      Apply grid shift to destination if required.                    */
 /* -------------------------------------------------------------------- */
-    if( dstdefn->datum_type == PJD_GRIDSHIFT )
+    if( ds->dst_grid )
     {
-        pj_apply_gridshift( pj_param(dstdefn->params,"snadgrids").s, 1,
-                            point_count, point_offset, x, y, z );
+        pj_ctx_set_errno( ctx, 
+                          pj_apply_gridshift_2( ds->dstdefn, 1, point_count, 
+                                                point_offset, x, y, z ) );
         CHECK_RETURN;
     }
 
+    return 0;
+}
+
+/************************************************************************/
+/*                         datum_shift_block()                          */
+/*                                                                      */
+/*      The geocentric round trip with the Helmert transformations      */
+/*      in between, for points that stay in cache from one step to      */
+/*      the next.  Each step is still its own loop, which keeps the     */
+/*      points independent of each other within it.                     */
+/************************************************************************/
+
+static void datum_shift_block( PJ_DATUM_SHIFT *ds, 
+                               long point_count, int point_offset,
+                               double *x, double *y, double *z )
+
+{
+    pj_Convert_Geodetic_To_Geocentric_Array( &ds->src_gi, point_count, 
+                                             point_offset, x, y, z );
+
+    if( ds->src_helmert )
+        pj_geocentric_to_wgs84( ds->srcdefn, point_count, point_offset,
+                                x, y, z );
+
+    if( ds->dst_helmert )
+        pj_geocentric_from_wgs84( ds->dstdefn, point_count, point_offset,
+                                  x, y, z );
+
+    pj_Convert_Geocentric_To_Geodetic_Array( &ds->dst_gi, point_count, 
+                                             point_offset, x, y, z );
+}
+
+/************************************************************************/
+/*                          datum_shift_apply()                         */
+/************************************************************************/
+
+static int datum_shift_apply( PJ_DATUM_SHIFT *ds,
+                              long point_count, int point_offset,
+                              double *x, double *y, double *z )
+
+{
+    projCtx     ctx = ds->srcdefn->ctx;
+    int         z_is_temp = FALSE, blocked = TRUE, err;
+    int         src_err = 0, dst_err = 0, hard_err = 0;
+    long        first, block = datum_block;
+
+/* -------------------------------------------------------------------- */
+/*      Create a temporary Z array if one is not provided.              */
+/* -------------------------------------------------------------------- */
+    if( z == NULL )
+    {
+        size_t	bytes = sizeof(double) * point_count * point_offset;
+        z = (double *) pj_malloc(bytes);
+        memset( z, 0, bytes );
+        z_is_temp = TRUE;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Errors that would stop the shift before any point was           */
+/*      touched must be met where the step by step version meets        */
+/*      them, so leave those cases to it.  Resolving the grid lists     */
+/*      up front is the same work the first block would do.            */
+/* -------------------------------------------------------------------- */
+    if( ds->geocentric && !ds->gi_ok )
+        blocked = FALSE;
+    else if( ds->src_grid
+             && pj_apply_gridshift_2( ds->srcdefn, 0, 0, point_offset, 
+                                      x, y, z ) != 0 )
+        blocked = FALSE;
+    else if( ds->dst_grid
+             && pj_apply_gridshift_2( ds->dstdefn, 1, 0, point_offset, 
+                                      x, y, z ) != 0 )
+        blocked = FALSE;
+
+    if( !blocked )
+    {
+        err = datum_shift_stepwise( ds, point_count, point_offset, x, y, z );
+        if( z_is_temp )
+            pj_dalloc( z );
+        return err;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Block by block.  A grid shift leaves the points it cannot       */
+/*      shift and carries on, so a failure in one block is only         */
+/*      remembered for the error left at the end.  Only a grid that     */
+/*      cannot be read stops the shift, as it would step by step.       */
+/* -------------------------------------------------------------------- */
+    for( first = 0; first < point_count && hard_err == 0; first += block )
+    {
+        long   count = point_count - first;
+        long   io = first * point_offset;
+
+        if( count > block )
+            count = block;
+
+        if( ds->src_grid )
+        {
+            err = pj_apply_gridshift_2( ds->srcdefn, 0, count, 
+                                        point_offset, x+io, y+io, z+io );
+            if( src_err == 0 )
+                src_err = err;
+            if( err > 0 || (err < 0 && transient_error[-err] == 0) )
+            {
+                hard_err = err;
+                break;
+            }
+        }
+
+        /* a -14 is cleared by the conversion back to geodetic anyway */
+        if( ds->geocentric )
+            datum_shift_block( ds, count, point_offset, x+io, y+io, z+io );
+
+        if( ds->dst_grid )
+        {
+            err = pj_apply_gridshift_2( ds->dstdefn, 1, count, 
+                                        point_offset, x+io, y+io, z+io );
+            if( dst_err == 0 )
+                dst_err = err;
+            if( err > 0 || (err < 0 && transient_error[-err] == 0) )
+                hard_err = err;
+        }
+    }
+
+    /* leave the error the last step of the step by step version would */
+    if( hard_err != 0 )
+        pj_ctx_set_errno( ctx, hard_err );
+    else if( ds->dst_grid )
+        pj_ctx_set_errno( ctx, dst_err );
+    else if( ds->geocentric )
+        pj_ctx_set_errno( ctx, 0 );
+    else if( ds->src_grid )
+        pj_ctx_set_errno( ctx, src_err );
+
     if( z_is_temp )
         pj_dalloc( z );
 
+    return hard_err;
+}
+
+/************************************************************************/
+/*                         pj_datum_transform()                         */
+/*                                                                      */
+/*      The input should be long/lat/z coordinates in radians in the    */
+/*      source datum, and the output should be long/lat/z               */
+/*      coordinates in radians in the destination datum.                */
+/************************************************************************/
+
+int pj_datum_transform( PJ *srcdefn, PJ *dstdefn, 
+                        long point_count, int point_offset,
+                        double *x, double *y, double *z )
+
+{
+    PJ_DATUM_SHIFT ds;
+
+    pj_ctx_set_errno( srcdefn->ctx, 0 );
+
+    if( !datum_shift_init( &ds, srcdefn, dstdefn ) )
+        return 0;
+
+    return datum_shift_apply( &ds, point_count, point_offset, x, y, z );
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                        Transformation plans                          */
+/* ==================================================================== */
+/*                                                                      */
+/*      A plan is the sequence of stages pj_transform() goes through    */
+/*      for one pair of coordinate systems, decided once.  Each stage   */
+/*      runs over the whole batch with the constants it was given, so   */
+/*      executing a plan gives the same points, errors and error        */
+/*      state as pj_transform() without re-examining the definitions.   */
+/************************************************************************/
+
+#define MAX_PLAN_STAGES 16
+
+typedef struct PJ_PLAN_STAGE PJ_PLAN_STAGE;
+
+struct PJ_PLAN_STAGE {
+    int         (*run)( const PJ_PLAN_STAGE *, long, int,
+                        double *, double *, double * );
+    PJ          *defn;          /* the definition the stage works for */
+    PJ_DATUM_SHIFT *datum;
+    double      a, es, value;
+};
+
+struct PJ_TRANSFORM_PLAN {
+    PJ          *srcdefn, *dstdefn;
+    int         stage_count;
+    PJ_DATUM_SHIFT datum;
+    PJ_PLAN_STAGE stages[MAX_PLAN_STAGES];
+};
+
+/************************************************************************/
+/*                         stage_geocent_in()                           */
+/************************************************************************/
+
+static int stage_geocent_in( const PJ_PLAN_STAGE *st, long point_count,
+                             int point_offset, double *x, double *y, double *z )
+
+{
+    long  i;
+    int   err;
+
+    if( z == NULL )
+    {
+        pj_ctx_set_errno( st->defn->ctx, PJD_ERR_GEOCENTRIC );
+        return PJD_ERR_GEOCENTRIC;
+    }
+
+    if( st->value != 1.0 )
+    {
+        for( i = 0; i < point_count; i++ )
+        {
+            if( x[point_offset*i] != HUGE_VAL )
+            {
+                x[point_offset*i] *= st->value;
+                y[point_offset*i] *= st->value;
+            }
+        }
+    }
+
+    err = pj_geocentric_to_geodetic( st->a, st->es, point_count, point_offset,
+                                     x, y, z );
+    if( err != 0 )
+        pj_ctx_set_errno( st->defn->ctx, err );
+
+    return err;
+}
+
+/************************************************************************/
+/*                        stage_no_inverse()                            */
+/************************************************************************/
+
+static int stage_no_inverse( const PJ_PLAN_STAGE *st, long point_count,
+                             int point_offset, double *x, double *y, double *z )
+
+{
+    /* this isn't correct, we need a no inverse err */
+    pj_ctx_set_errno( st->defn->ctx, -17 );
+    pj_log( st->defn->ctx, PJ_LOG_ERROR,
+            "pj_transform(): source projection not invertable" );
+    return -17;
+}
+
+/************************************************************************/
+/*                          stage_inverse()                             */
+/************************************************************************/
+
+static int stage_inverse( const PJ_PLAN_STAGE *st, long point_count,
+                          int point_offset, double *x, double *y, double *z )
+
+{
+    PJ    *defn = st->defn;
+    long  i;
+    int   err;
+
+    for( i = 0; i < point_count; i++ )
+    {
+        XY         projected_loc;
+        LP         geodetic_loc;
+
+        projected_loc.u = x[point_offset*i];
+        projected_loc.v = y[point_offset*i];
+
+        if( projected_loc.u == HUGE_VAL )
+            continue;
+
+        geodetic_loc = pj_inv( projected_loc, defn );
+        err = defn->ctx->last_errno;
+        if( err != 0 )
+        {
+            if( (err != 33 /*EDOM*/ && err != 34 /*ERANGE*/ )
+                && (err > 0 || err < -44 || point_count == 1
+                    || transient_error[-err] == 0 ) )
+                return err;
+            else
+            {
+                geodetic_loc.u = HUGE_VAL;
+                geodetic_loc.v = HUGE_VAL;
+            }
+        }
+
+        x[point_offset*i] = geodetic_loc.u;
+        y[point_offset*i] = geodetic_loc.v;
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/*                          stage_forward()                             */
+/************************************************************************/
+
+static int stage_forward( const PJ_PLAN_STAGE *st, long point_count,
+                          int point_offset, double *x, double *y, double *z )
+
+{
+    PJ    *defn = st->defn;
+    long  i;
+    int   err;
+
+    for( i = 0; i < point_count; i++ )
+    {
+        XY         projected_loc;
+        LP         geodetic_loc;
+
+        geodetic_loc.u = x[point_offset*i];
+        geodetic_loc.v = y[point_offset*i];
+
+        if( geodetic_loc.u == HUGE_VAL )
+            continue;
+
+        projected_loc = pj_fwd( geodetic_loc, defn );
+        err = defn->ctx->last_errno;
+        if( err != 0 )
+        {
+            if( (err != 33 /*EDOM*/ && err != 34 /*ERANGE*/ )
+                && (err > 0 || err < -44 || point_count == 1
+                    || transient_error[-err] == 0 ) )
+                return err;
+            else
+            {
+                projected_loc.u = HUGE_VAL;
+                projected_loc.v = HUGE_VAL;
+            }
+        }
+
+        x[point_offset*i] = projected_loc.u;
+        y[point_offset*i] = projected_loc.v;
+    }
+
     return 0;
 }
 
+/************************************************************************/
+/*                         stage_lon_shift()                            */
+/*                                                                      */
+/*      Prime meridian adjustment; x - pm and x + (-pm) are the same    */
+/*      in IEEE arithmetic, so one stage does both directions.          */
+/************************************************************************/
+
+static int stage_lon_shift( const PJ_PLAN_STAGE *st, long point_count,
+                            int point_offset, double *x, double *y, double *z )
+
+{
+    long  i;
+
+    for( i = 0; i < point_count; i++ )
+    {
+        if( x[point_offset*i] != HUGE_VAL )
+            x[point_offset*i] += st->value;
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/*                        stage_datum_reset()                           */
+/*                                                                      */
+/*      pj_datum_transform() always starts by clearing the error of     */
+/*      the source context, whether or not there is a shift to do.      */
+/************************************************************************/
+
+static int stage_datum_reset( const PJ_PLAN_STAGE *st, long point_count,
+                              int point_offset, double *x, double *y, double *z )
+
+{
+    pj_ctx_set_errno( st->defn->ctx, 0 );
+    return 0;
+}
+
+/************************************************************************/
+/*                           stage_datum()                              */
+/************************************************************************/
+
+static int stage_datum( const PJ_PLAN_STAGE *st, long point_count,
+                        int point_offset, double *x, double *y, double *z )
+
+{
+    return datum_shift_apply( st->datum, point_count, point_offset, x, y, z );
+}
+
+/************************************************************************/
+/*                         stage_geocent_out()                          */
+/************************************************************************/
+
+static int stage_geocent_out( const PJ_PLAN_STAGE *st, long point_count,
+                              int point_offset, double *x, double *y, double *z )
+
+{
+    long  i;
+
+    if( z == NULL )
+    {
+        pj_ctx_set_errno( st->defn->ctx, PJD_ERR_GEOCENTRIC );
+        return PJD_ERR_GEOCENTRIC;
+    }
+
+    pj_geodetic_to_geocentric( st->a, st->es, point_count, point_offset,
+                               x, y, z );
+
+    if( st->value != 1.0 )
+    {
+        for( i = 0; i < point_count; i++ )
+        {
+            if( x[point_offset*i] != HUGE_VAL )
+            {
+                x[point_offset*i] *= st->value;
+                y[point_offset*i] *= st->value;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/*                         stage_long_wrap()                            */
+/************************************************************************/
+
+static int stage_long_wrap( const PJ_PLAN_STAGE *st, long point_count,
+                            int point_offset, double *x, double *y, double *z )
+
+{
+    long  i;
+
+    for( i = 0; i < point_count; i++ )
+    {
+        if( x[point_offset*i] == HUGE_VAL )
+            continue;
+
+        while( x[point_offset*i] < st->value - HALFPI )
+            x[point_offset*i] += PI;
+        while( x[point_offset*i] > st->value + HALFPI )
+            x[point_offset*i] -= PI;
+    }
+
+    return 0;
+}
+
+/************************************************************************/
+/*                            plan_stage()                              */
+/************************************************************************/
+
+static PJ_PLAN_STAGE *plan_stage( PJ_TRANSFORM_PLAN *plan,
+                                  int (*run)( const PJ_PLAN_STAGE *, long, int,
+                                              double *, double *, double * ),
+                                  PJ *defn )
+
+{
+    PJ_PLAN_STAGE *st = plan->stages + plan->stage_count++;
+
+    memset( st, 0, sizeof(PJ_PLAN_STAGE) );
+    st->run = run;
+    st->defn = defn;
+
+    return st;
+}
+
+/************************************************************************/
+/*                      pj_transform_plan_create()                      */
+/*                                                                      */
+/*      Work out the stages pj_transform() would run from srcdefn to    */
+/*      dstdefn.  The plan refers to both definitions, which must       */
+/*      outlive it.  Returns NULL only if out of memory.                */
+/************************************************************************/
+
+PJ_TRANSFORM_PLAN *pj_transform_plan_create( PJ *srcdefn, PJ *dstdefn )
+
+{
+    PJ_TRANSFORM_PLAN *plan;
+    PJ_PLAN_STAGE *st;
+
+    plan = (PJ_TRANSFORM_PLAN *) pj_malloc(sizeof(PJ_TRANSFORM_PLAN));
+    if( plan == NULL )
+    {
+        pj_ctx_set_errno( srcdefn->ctx, ENOMEM );
+        return NULL;
+    }
+
+    plan->srcdefn = srcdefn;
+    plan->dstdefn = dstdefn;
+    plan->stage_count = 0;
+
+/* -------------------------------------------------------------------- */
+/*      Source to lat/long.                                             */
+/* -------------------------------------------------------------------- */
+    if( srcdefn->is_geocent )
+    {
+        st = plan_stage( plan, stage_geocent_in, srcdefn );
+        st->value = srcdefn->to_meter;
+        st->a = srcdefn->a_orig;
+        st->es = srcdefn->es_orig;
+    }
+    else if( !srcdefn->is_latlong )
+    {
+        if( srcdefn->inv == NULL )
+            plan_stage( plan, stage_no_inverse, srcdefn );
+        else
+            plan_stage( plan, stage_inverse, srcdefn );
+    }
+
+    if( srcdefn->from_greenwich != 0.0 )
+        plan_stage( plan, stage_lon_shift, srcdefn )->value = 
+            srcdefn->from_greenwich;
+
+/* -------------------------------------------------------------------- */
+/*      Datum conversion, as decided by pj_datum_transform().           */
+/* -------------------------------------------------------------------- */
+    plan_stage( plan, stage_datum_reset, srcdefn );
+
+    if( datum_shift_init( &plan->datum, srcdefn, dstdefn ) )
+        plan_stage( plan, stage_datum, srcdefn )->datum = &plan->datum;
+
+/* -------------------------------------------------------------------- */
+/*      Lat/long to destination.                                        */
+/* -------------------------------------------------------------------- */
+    if( dstdefn->from_greenwich != 0.0 )
+        plan_stage( plan, stage_lon_shift, dstdefn )->value = 
+            -dstdefn->from_greenwich;
+
+    if( dstdefn->is_geocent )
+    {
+        st = plan_stage( plan, stage_geocent_out, dstdefn );
+        st->value = dstdefn->fr_meter;
+        st->a = dstdefn->a_orig;
+        st->es = dstdefn->es_orig;
+    }
+    else if( !dstdefn->is_latlong )
+        plan_stage( plan, stage_forward, dstdefn );
+    else if( dstdefn->long_wrap_center != 0 )
+        plan_stage( plan, stage_long_wrap, dstdefn )->value = 
+            dstdefn->long_wrap_center;
+
+    return plan;
+}
+
+/************************************************************************/
+/*                     pj_transform_plan_execute()                      */
+/*                                                                      */
+/*      Same as pj_transform() on the plan's definitions.               */
+/************************************************************************/
+
+int pj_transform_plan_execute( PJ_TRANSFORM_PLAN *plan,
+                               long point_count, int point_offset,
+                               double *x, double *y, double *z )
+
+{
+    int       i, err = 0;
+
+    pj_ctx_set_errno( plan->srcdefn->ctx, 0 );
+    pj_ctx_set_errno( plan->dstdefn->ctx, 0 );
+
+    if( point_offset == 0 )
+        point_offset = 1;
+
+    for( i = 0; i < plan->stage_count && err == 0; i++ )
+    {
+        const PJ_PLAN_STAGE *st = plan->stages + i;
+
+        err = st->run( st, point_count, point_offset, x, y, z );
+    }
+
+    return err;
+}
+
+/************************************************************************/
+/*                       pj_transform_plan_free()                       */
+/************************************************************************/
+
+void pj_transform_plan_free( PJ_TRANSFORM_PLAN *plan )
+
+{
+    pj_dalloc( plan );
+}
@@ -0,0 +1,374 @@
+/* pj_transform_parallel(): pj_transform() split over worker threads,
+   and the pj_run_threads() it is built on */
+
+/* projects.h and windows.h conflict - avoid this! */
+
+#ifndef _WIN32
+#include <projects.h>
+#else
+#include <proj_api.h>
+#endif
+#include <string.h>
+
+#ifdef _WIN32
+#  define MUTEX_win32
+#endif
+
+#if !defined(MUTEX_stub) && !defined(MUTEX_pthread) && !defined(MUTEX_win32)
+#  define MUTEX_stub
+#endif
+
+/*
+** Points handed to a worker at a time.  4096 points of x/y/z is 96K,
+** which keeps one chunk resident in L2 while every pj_transform()
+** stage walks over it.
+*/
+#ifndef PJ_TRANSFORM_CHUNK
+#  define PJ_TRANSFORM_CHUNK 4096
+#endif
+
+#define MAX_WORKERS 64
+
+typedef struct {
+    projPJ      srcdefn, dstdefn;
+    long        point_count;
+    int         point_offset;
+    double      *x, *y, *z;
+
+    long        chunk_count;
+    long        next_chunk;     /* protected by pj_acquire_lock() */
+
+    long        err_chunk;      /* lowest chunk that failed, or -1 */
+    int         err;
+
+    long        errno_chunk;    /* lowest chunk leaving a context errno */
+    int         ctx_errno;
+} TransformJob;
+
+/* what a thread started by pj_run_threads() runs */
+typedef struct {
+    void        (*func)( void * );
+    void        *arg;
+} ThreadStart;
+
+typedef struct {
+    TransformJob *job;
+    projCtx     ctx;
+    projPJ      src, dst;
+} TransformWorker;
+
+/************************************************************************/
+/*                          transform_worker()                          */
+/*                                                                      */
+/*      Pull chunks off the job until none are left.                    */
+/************************************************************************/
+
+static void transform_worker( void *arg )
+
+{
+    TransformWorker *worker = (TransformWorker *) arg;
+    TransformJob *job = worker->job;
+
+    for( ;; )
+    {
+        long chunk, first, count;
+        int  err;
+
+        pj_acquire_lock();
+        chunk = job->next_chunk++;
+        pj_release_lock();
+
+        if( chunk >= job->chunk_count )
+            break;
+
+        /* the last chunk absorbs the remainder so no chunk is tiny */
+        first = chunk * PJ_TRANSFORM_CHUNK;
+        if( chunk == job->chunk_count - 1 )
+            count = job->point_count - first;
+        else
+            count = PJ_TRANSFORM_CHUNK;
+
+        first *= job->point_offset;
+        err = pj_transform( worker->src, worker->dst, count,
+                            job->point_offset,
+                            job->x + first, job->y + first,
+                            job->z ? job->z + first : NULL );
+
+        if( err != 0 )
+        {
+            pj_acquire_lock();
+            if( job->err_chunk < 0 || chunk < job->err_chunk )
+            {
+                job->err_chunk = chunk;
+                job->err = err;
+            }
+            pj_release_lock();
+        }
+        else if( pj_ctx_get_errno( worker->ctx ) != 0 )
+        {
+            /* a transient error, such as a point off the grids */
+            pj_acquire_lock();
+            if( job->errno_chunk < 0 || chunk < job->errno_chunk )
+            {
+                job->errno_chunk = chunk;
+                job->ctx_errno = pj_ctx_get_errno( worker->ctx );
+            }
+            pj_release_lock();
+        }
+    }
+}
+
+/************************************************************************/
+/*                   pj_cpu_count(), pj_run_threads()                   */
+/*                                                                      */
+/*      pj_run_threads() calls func on each of count arguments, laid    */
+/*      out arg_size bytes apart in args, each in a thread of its own   */
+/*      (the first in the calling thread), and returns when all are     */
+/*      done.  Any that no thread could be started for run in the       */
+/*      calling thread too, so all are always run.                      */
+/************************************************************************/
+
+/************************************************************************/
+/* ==================================================================== */
+/*                       stub thread implementation                     */
+/* ==================================================================== */
+/************************************************************************/
+
+#ifdef MUTEX_stub
+
+int pj_cpu_count() { return 1; }
+
+void pj_run_threads( void (*func)( void * ), void *args, size_t arg_size,
+                     int count )
+
+{
+    int i;
+
+    for( i = 0; i < count; i++ )
+        func( (char *) args + i * arg_size );
+}
+
+#endif // def MUTEX_stub
+
+/************************************************************************/
+/* ==================================================================== */
+/*                     pthread thread implementation                    */
+/* ==================================================================== */
+/************************************************************************/
+
+#ifdef MUTEX_pthread
+
+#include "pthread.h"
+#include <unistd.h>
+
+int pj_cpu_count()
+
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf( _SC_NPROCESSORS_ONLN );
+    if( n > 0 )
+        return (int) n;
+#endif
+    return 1;
+}
+
+static void *pthread_worker( void *arg )
+
+{
+    ThreadStart *start = (ThreadStart *) arg;
+
+    start->func( start->arg );
+    return NULL;
+}
+
+void pj_run_threads( void (*func)( void * ), void *args, size_t arg_size,
+                     int count )
+
+{
+    pthread_t   threads[MAX_WORKERS];
+    ThreadStart starts[MAX_WORKERS];
+    int         i, started;
+
+    for( started = 1; started < count && started < MAX_WORKERS; started++ )
+    {
+        starts[started].func = func;
+        starts[started].arg = (char *) args + started * arg_size;
+        if( pthread_create( threads + started, NULL, pthread_worker,
+                            starts + started ) != 0 )
+            break;
+    }
+
+    /* the calling thread runs the first, and any without a thread */
+    func( args );
+    for( i = started; i < count; i++ )
+        func( (char *) args + i * arg_size );
+
+    for( i = 1; i < started; i++ )
+        pthread_join( threads[i], NULL );
+}
+
+#endif // def MUTEX_pthread
+
+/************************************************************************/
+/* ==================================================================== */
+/*                      win32 thread implementation                     */
+/* ==================================================================== */
+/************************************************************************/
+
+#ifdef MUTEX_win32
+
+#include <windows.h>
+
+int pj_cpu_count()
+
+{
+    SYSTEM_INFO info;
+
+    GetSystemInfo( &info );
+    return info.dwNumberOfProcessors > 0 ? (int) info.dwNumberOfProcessors : 1;
+}
+
+static DWORD WINAPI win32_worker( LPVOID arg )
+
+{
+    ThreadStart *start = (ThreadStart *) arg;
+
+    start->func( start->arg );
+    return 0;
+}
+
+void pj_run_threads( void (*func)( void * ), void *args, size_t arg_size,
+                     int count )
+
+{
+    HANDLE      threads[MAX_WORKERS];
+    ThreadStart starts[MAX_WORKERS];
+    int         i, started;
+
+    for( started = 1; started < count && started < MAX_WORKERS; started++ )
+    {
+        starts[started].func = func;
+        starts[started].arg = (char *) args + started * arg_size;
+        threads[started] = CreateThread( NULL, 0, win32_worker,
+                                         starts + started, 0, NULL );
+        if( threads[started] == NULL )
+            break;
+    }
+
+    /* the calling thread runs the first, and any without a thread */
+    func( args );
+    for( i = started; i < count; i++ )
+        func( (char *) args + i * arg_size );
+
+    for( i = 1; i < started; i++ )
+    {
+        WaitForSingleObject( threads[i], INFINITE );
+        CloseHandle( threads[i] );
+    }
+}
+
+#endif // def MUTEX_win32
+
+/************************************************************************/
+/*                       pj_transform_parallel()                        */
+/*                                                                      */
+/*      Same as pj_transform(), but the points are split into           */
+/*      chunks of PJ_TRANSFORM_CHUNK points which are transformed       */
+/*      by up to thread_count workers.  A thread_count of zero or       */
+/*      less uses one worker per online CPU.                            */
+/*                                                                      */
+/*      Each point is transformed exactly as pj_transform() would,      */
+/*      including HUGE_VAL marking of points that fail.  Errors that    */
+/*      abandon the rest of a pj_transform() batch (such as a point     */
+/*      falling outside a required grid) only abandon the rest of the   */
+/*      chunk.  The error of the earliest failing chunk is returned.    */
+/*      If there is none, the context errno is set from the earliest    */
+/*      chunk that left one, as pj_transform() would leave it.          */
+/************************************************************************/
+
+int pj_transform_parallel( projPJ srcdefn, projPJ dstdefn,
+                           long point_count, int point_offset,
+                           double *x, double *y, double *z,
+                           int thread_count )
+
+{
+    TransformJob    job;
+    TransformWorker workers[MAX_WORKERS];
+    int             worker_count, i;
+
+    if( point_offset == 0 )
+        point_offset = 1;
+
+    if( thread_count <= 0 )
+        thread_count = pj_cpu_count();
+    if( thread_count > MAX_WORKERS )
+        thread_count = MAX_WORKERS;
+
+    job.chunk_count = point_count / PJ_TRANSFORM_CHUNK;
+
+/* -------------------------------------------------------------------- */
+/*      Not worth spinning up threads for a single chunk.               */
+/* -------------------------------------------------------------------- */
+    if( thread_count < 2 || job.chunk_count < 2 )
+        return pj_transform( srcdefn, dstdefn, point_count, point_offset,
+                             x, y, z );
+
+    worker_count = thread_count;
+    if( worker_count > job.chunk_count )
+        worker_count = (int) job.chunk_count;
+
+    job.srcdefn = srcdefn;
+    job.dstdefn = dstdefn;
+    job.point_count = point_count;
+    job.point_offset = point_offset;
+    job.x = x;
+    job.y = y;
+    job.z = z;
+    job.next_chunk = 0;
+    job.err_chunk = -1;
+    job.err = 0;
+    job.errno_chunk = -1;
+    job.ctx_errno = 0;
+
+/* -------------------------------------------------------------------- */
+/*      Give every worker its own context and coordinate systems.       */
+/* -------------------------------------------------------------------- */
+    memset( workers, 0, sizeof(workers) );
+    for( i = 0; i < worker_count; i++ )
+    {
+        workers[i].job = &job;
+        workers[i].ctx = pj_ctx_alloc();
+        if( workers[i].ctx == NULL )
+            break;
+
+        workers[i].src = pj_clone_ctx( workers[i].ctx, srcdefn );
+        workers[i].dst = pj_clone_ctx( workers[i].ctx, dstdefn );
+        if( workers[i].src == NULL || workers[i].dst == NULL )
+        {
+            pj_free( workers[i].src );
+            pj_free( workers[i].dst );
+            pj_ctx_free( workers[i].ctx );
+            break;
+        }
+    }
+    worker_count = i;
+
+    if( worker_count == 0 )
+        return pj_transform( srcdefn, dstdefn, point_count, point_offset,
+                             x, y, z );
+
+    pj_run_threads( transform_worker, workers, sizeof(TransformWorker),
+                    worker_count );
+
+    for( i = 0; i < worker_count; i++ )
+    {
+        pj_free( workers[i].src );
+        pj_free( workers[i].dst );
+        pj_ctx_free( workers[i].ctx );
+    }
+
+    pj_ctx_set_errno( pj_get_ctx(srcdefn), 
+                      job.err != 0 ? job.err : job.ctx_errno );
+
+    return job.err;
+}
@@ -7,4 +7,17 @@ pj_tsfn(double phi, double sinphi, double e) {
 	sinphi *= e;
 	return (tan (.5 * (HALFPI - phi)) /
 	   pow((1. - sinphi) / (1. + sinphi), .5 * e));
+}
+	void /* pj_tsfn() of n latitudes, in place; HUGE_VAL passes through */
+pj_tsfn_n(long n, int stride, double *phi, double e) {
+	double sinphi, eccnth = .5 * e;
+	long i;
+
+	for (i = 0; i < n; ++i, phi += stride) {
+		if (*phi == HUGE_VAL)
+			continue;
+		sinphi = e * sin(*phi);
+		*phi = tan (.5 * (HALFPI - *phi)) /
+		   pow((1. - sinphi) / (1. + sinphi), eccnth);
+	}
 }
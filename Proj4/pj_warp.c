@@ -0,0 +1,460 @@
+/* Approximate transformation of a regular grid of points */
+#include <projects.h>
+#include <string.h>
+#include <errno.h>
+
+/*
+** pj_warp_mesh() transforms the points of a grid, such as the pixel
+** centres of a raster, without transforming every one of them.  A
+** block of the grid is transformed at its corners, edge midpoints and
+** centre.  If bilinear interpolation between the corners reproduces
+** the other five points to within the tolerance, the whole block is
+** interpolated.  Otherwise it is split in four and each quarter is
+** treated the same way.  Blocks that are down to PJ_WARP_MIN_BLOCK
+** points across, or whose error shows they would have to get that
+** small, are transformed point by point, so that a transformation too
+** curved for the tolerance costs little more than transforming every
+** point.  This is the 2D version of the approximating transformer
+** GDAL uses for warping.
+**
+** The blocks are dealt with a level at a time, so that each level
+** costs one pj_transform_plan_execute() rather than one per block.
+*/
+
+#ifndef PJ_WARP_MAX_BLOCK
+#  define PJ_WARP_MAX_BLOCK 64  /* largest block span ever interpolated */
+#endif
+#ifndef PJ_WARP_MIN_BLOCK
+#  define PJ_WARP_MIN_BLOCK 4   /* blocks this small are not split again */
+#endif
+
+typedef struct {
+    int         i0, j0, i1, j1;
+    double      cx[4], cy[4];   /* (i0,j0), (i1,j0), (i0,j1), (i1,j1) */
+} WARP_BLOCK;
+
+typedef struct {
+    PJ          *src, *dst;
+    PJ_TRANSFORM_PLAN *plan;
+    int         width, height;
+    double      x0, y0, dx, dy;
+    double      tolerance;
+    double      *x, *y;
+} WARP_MESH;
+
+/************************************************************************/
+/*                            mesh_exact()                              */
+/*                                                                      */
+/*      Transform the grid points whose coordinates have been put in    */
+/*      x/y.  Points that fail are HUGE_VAL.  The plan leaves a point   */
+/*      that misses the grid shift files unshifted, reporting it only   */
+/*      in the context errno, so if the batch reports any error its     */
+/*      points are done again one at a time to find which ones.         */
+/************************************************************************/
+
+static void mesh_exact( WARP_MESH *m, long count, double *x, double *y )
+
+{
+    double *save;
+    long k;
+
+    if( count <= 0 )
+        return;
+
+    save = (double *) pj_malloc( sizeof(double) * 2 * count );
+    if( save != NULL )
+    {
+        memcpy( save, x, sizeof(double) * count );
+        memcpy( save + count, y, sizeof(double) * count );
+    }
+
+    if( pj_transform_plan_execute( m->plan, count, 1, x, y, NULL ) == 0
+        && pj_ctx_get_errno( m->src->ctx ) == 0
+        && pj_ctx_get_errno( m->dst->ctx ) == 0 )
+    {
+        pj_dalloc( save );
+        return;
+    }
+
+    for( k = 0; k < count; k++ )
+    {
+        if( save == NULL )
+        {
+            x[k] = y[k] = HUGE_VAL;
+            continue;
+        }
+
+        x[k] = save[k];
+        y[k] = save[count + k];
+        pj_ctx_set_errno( m->src->ctx, 0 );
+        pj_ctx_set_errno( m->dst->ctx, 0 );
+        if( pj_transform( m->src, m->dst, 1, 0, x + k, y + k, NULL ) != 0
+            || pj_ctx_get_errno( m->src->ctx ) != 0
+            || pj_ctx_get_errno( m->dst->ctx ) != 0 )
+            x[k] = y[k] = HUGE_VAL;
+    }
+
+    pj_dalloc( save );
+}
+
+/************************************************************************/
+/*                           mesh_interp()                              */
+/*                                                                      */
+/*      Bilinear interpolation in a block at grid point (i,j).          */
+/************************************************************************/
+
+static void mesh_interp( const WARP_BLOCK *b, int i, int j,
+                         double *x, double *y )
+
+{
+    double s = b->i1 > b->i0 ? (double) (i - b->i0) / (b->i1 - b->i0) : 0.0;
+    double t = b->j1 > b->j0 ? (double) (j - b->j0) / (b->j1 - b->j0) : 0.0;
+    double lx = b->cx[0] + (b->cx[2] - b->cx[0]) * t;
+    double ly = b->cy[0] + (b->cy[2] - b->cy[0]) * t;
+    double rx = b->cx[1] + (b->cx[3] - b->cx[1]) * t;
+    double ry = b->cy[1] + (b->cy[3] - b->cy[1]) * t;
+
+    *x = lx + (rx - lx) * s;
+    *y = ly + (ry - ly) * s;
+}
+
+/************************************************************************/
+/*                            mesh_owned()                              */
+/*                                                                      */
+/*      Neighbouring blocks share their edges, so a block only owns    */
+/*      its last column and row at the edge of the grid.  Returns the   */
+/*      number of points the block owns.                                */
+/************************************************************************/
+
+static long mesh_owned( WARP_MESH *m, const WARP_BLOCK *b,
+                        int *i_end, int *j_end )
+
+{
+    *i_end = b->i1 == m->width - 1 ? b->i1 : b->i1 - 1;
+    *j_end = b->j1 == m->height - 1 ? b->j1 : b->j1 - 1;
+
+    return (long) (*i_end - b->i0 + 1) * (*j_end - b->j0 + 1);
+}
+
+/************************************************************************/
+/*                            mesh_fill()                               */
+/************************************************************************/
+
+static void mesh_fill( WARP_MESH *m, const WARP_BLOCK *b )
+
+{
+    int i, j, i_end, j_end;
+
+    mesh_owned( m, b, &i_end, &j_end );
+    for( j = b->j0; j <= j_end; j++ )
+    {
+        long row = (long) j * m->width;
+
+        for( i = b->i0; i <= i_end; i++ )
+            mesh_interp( b, i, j, m->x + row + i, m->y + row + i );
+    }
+}
+
+/************************************************************************/
+/*                            mesh_split()                              */
+/*                                                                      */
+/*      Split a block in four, or in two if it is only two points       */
+/*      across one way, given its 3x3 grid of known points (rows top    */
+/*      to bottom).  Returns the number of blocks written to out.       */
+/************************************************************************/
+
+static int mesh_split( const WARP_BLOCK *b, const double *gx, const double *gy,
+                       WARP_BLOCK *out )
+
+{
+    int im = (b->i0 + b->i1) / 2, jm = (b->j0 + b->j1) / 2;
+    int ci[3], cj[3], ei[3], ej[3], ni, nj, u, v, n = 0;
+
+    if( b->i1 - b->i0 < 2 )
+    {
+        ci[0] = 0; ci[1] = 2; ei[0] = b->i0; ei[1] = b->i1; ni = 1;
+    }
+    else
+    {
+        ci[0] = 0; ci[1] = 1; ci[2] = 2; 
+        ei[0] = b->i0; ei[1] = im; ei[2] = b->i1; ni = 2;
+    }
+
+    if( b->j1 - b->j0 < 2 )
+    {
+        cj[0] = 0; cj[1] = 2; ej[0] = b->j0; ej[1] = b->j1; nj = 1;
+    }
+    else
+    {
+        cj[0] = 0; cj[1] = 1; cj[2] = 2; 
+        ej[0] = b->j0; ej[1] = jm; ej[2] = b->j1; nj = 2;
+    }
+
+    for( v = 0; v < nj; v++ )
+    {
+        for( u = 0; u < ni; u++ )
+        {
+            WARP_BLOCK *q = out + n++;
+            int c0 = ci[u], c1 = ci[u+1], r0 = cj[v], r1 = cj[v+1];
+
+            q->i0 = ei[u]; q->i1 = ei[u+1];
+            q->j0 = ej[v]; q->j1 = ej[v+1];
+            q->cx[0] = gx[r0*3+c0]; q->cy[0] = gy[r0*3+c0];
+            q->cx[1] = gx[r0*3+c1]; q->cy[1] = gy[r0*3+c1];
+            q->cx[2] = gx[r1*3+c0]; q->cy[2] = gy[r1*3+c0];
+            q->cx[3] = gx[r1*3+c1]; q->cy[3] = gy[r1*3+c1];
+        }
+    }
+
+    return n;
+}
+
+/************************************************************************/
+/*                            mesh_level()                              */
+/*                                                                      */
+/*      Deal with one level of blocks: sample them all in a single      */
+/*      transformation, interpolate the ones that pass, and split the   */
+/*      others into next, which has room for four times count, or       */
+/*      transform them point by point.  Returns the number of blocks    */
+/*      in next, or -1 if out of memory.                                */
+/************************************************************************/
+
+static int mesh_level( WARP_MESH *m, const WARP_BLOCK *blocks, int count,
+                       WARP_BLOCK *next )
+
+{
+    static const int si[5] = { 1, 0, 1, 2, 1 }, sj[5] = { 0, 1, 1, 1, 2 };
+    double *sx, *sy, *px, *py;
+    long   npoints = 0, k;
+    int    n, next_count = 0, s, i_end, j_end;
+    char   *exact;
+
+    sx = (double *) pj_malloc( sizeof(double) * 10 * count + count );
+    if( sx == NULL )
+        return -1;
+    sy = sx + 5 * count;
+    exact = (char *) (sy + 5 * count);
+
+/* -------------------------------------------------------------------- */
+/*      The edge midpoints and centre of every block.                   */
+/* -------------------------------------------------------------------- */
+    for( n = 0; n < count; n++ )
+    {
+        const WARP_BLOCK *b = blocks + n;
+        int  gi[3], gj[3];
+
+        gi[0] = b->i0; gi[1] = (b->i0 + b->i1) / 2; gi[2] = b->i1;
+        gj[0] = b->j0; gj[1] = (b->j0 + b->j1) / 2; gj[2] = b->j1;
+
+        for( s = 0; s < 5; s++ )
+        {
+            sx[5*n+s] = m->x0 + gi[si[s]] * m->dx;
+            sy[5*n+s] = m->y0 + gj[sj[s]] * m->dy;
+        }
+    }
+    mesh_exact( m, 5L * count, sx, sy );
+
+    for( n = 0; n < count; n++ )
+    {
+        const WARP_BLOCK *b = blocks + n;
+        int    span = b->i1 - b->i0 > b->j1 - b->j0 
+                    ? b->i1 - b->i0 : b->j1 - b->j0;
+        double err = 0.0;
+
+        exact[n] = FALSE;
+
+/* -------------------------------------------------------------------- */
+/*      How far the samples are from the interpolation.                 */
+/* -------------------------------------------------------------------- */
+        for( s = 0; s < 4 && err != HUGE_VAL; s++ )
+            if( b->cx[s] == HUGE_VAL )
+                err = HUGE_VAL;
+
+        for( s = 0; s < 5 && err != HUGE_VAL; s++ )
+        {
+            double ix, iy;
+            int    gi = si[s] == 0 ? b->i0 : si[s] == 2 ? b->i1 
+                                   : (b->i0 + b->i1) / 2;
+            int    gj = sj[s] == 0 ? b->j0 : sj[s] == 2 ? b->j1 
+                                   : (b->j0 + b->j1) / 2;
+
+            mesh_interp( b, gi, gj, &ix, &iy );
+            if( sx[5*n+s] == HUGE_VAL )
+                err = HUGE_VAL;
+            else
+            {
+                if( fabs(ix - sx[5*n+s]) > err )
+                    err = fabs(ix - sx[5*n+s]);
+                if( fabs(iy - sy[5*n+s]) > err )
+                    err = fabs(iy - sy[5*n+s]);
+            }
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Interpolate if that is close enough.  Otherwise, as the error   */
+/*      of bilinear interpolation goes as the square of the span, see   */
+/*      whether splitting could ever get there before the blocks are    */
+/*      too small to be worth it, and if not transform every point.     */
+/* -------------------------------------------------------------------- */
+        if( err <= m->tolerance && span <= PJ_WARP_MAX_BLOCK )
+            mesh_fill( m, b );
+        else if( span <= PJ_WARP_MIN_BLOCK
+                 || ( err > m->tolerance 
+                      && span * sqrt(m->tolerance / err) < PJ_WARP_MIN_BLOCK ) )
+        {
+            exact[n] = TRUE;
+            npoints += mesh_owned( m, b, &i_end, &j_end );
+        }
+        else
+        {
+            double gx[9], gy[9];
+
+            gx[0] = b->cx[0];   gy[0] = b->cy[0];
+            gx[1] = sx[5*n];    gy[1] = sy[5*n];
+            gx[2] = b->cx[1];   gy[2] = b->cy[1];
+            gx[3] = sx[5*n+1];  gy[3] = sy[5*n+1];
+            gx[4] = sx[5*n+2];  gy[4] = sy[5*n+2];
+            gx[5] = sx[5*n+3];  gy[5] = sy[5*n+3];
+            gx[6] = b->cx[2];   gy[6] = b->cy[2];
+            gx[7] = sx[5*n+4];  gy[7] = sy[5*n+4];
+            gx[8] = b->cx[3];   gy[8] = b->cy[3];
+
+            next_count += mesh_split( b, gx, gy, next + next_count );
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Every point of the blocks that could not be interpolated.       */
+/* -------------------------------------------------------------------- */
+    if( npoints > 0 )
+    {
+        px = (double *) pj_malloc( sizeof(double) * 2 * npoints );
+        if( px == NULL )
+        {
+            pj_dalloc( sx );
+            return -1;
+        }
+        py = px + npoints;
+
+        for( k = 0, n = 0; n < count; n++ )
+        {
+            const WARP_BLOCK *b = blocks + n;
+            int  i, j, i_end, j_end;
+
+            if( !exact[n] )
+                continue;
+            mesh_owned( m, b, &i_end, &j_end );
+            for( j = b->j0; j <= j_end; j++ )
+                for( i = b->i0; i <= i_end; i++, k++ )
+                {
+                    px[k] = m->x0 + i * m->dx;
+                    py[k] = m->y0 + j * m->dy;
+                }
+        }
+
+        mesh_exact( m, npoints, px, py );
+
+        for( k = 0, n = 0; n < count; n++ )
+        {
+            const WARP_BLOCK *b = blocks + n;
+            int  i, j, i_end, j_end;
+
+            if( !exact[n] )
+                continue;
+            mesh_owned( m, b, &i_end, &j_end );
+            for( j = b->j0; j <= j_end; j++ )
+                for( i = b->i0; i <= i_end; i++, k++ )
+                {
+                    m->x[(long) j * m->width + i] = px[k];
+                    m->y[(long) j * m->width + i] = py[k];
+                }
+        }
+
+        pj_dalloc( px );
+    }
+
+    pj_dalloc( sx );
+
+    return next_count;
+}
+
+/************************************************************************/
+/*                            pj_warp_mesh()                            */
+/*                                                                      */
+/*      Transform the width x height grid of points x0 + i*dx,          */
+/*      y0 + j*dy from src to dst, into the row major arrays x and y,   */
+/*      to within tolerance in the units of dst.  Points that cannot    */
+/*      be transformed are HUGE_VAL.  Returns 0, or the error if the    */
+/*      transformation could not be set up or memory ran out.           */
+/************************************************************************/
+
+int pj_warp_mesh( PJ *src, PJ *dst, int width, int height,
+                  double x0, double y0, double dx, double dy,
+                  double tolerance, double *x, double *y )
+
+{
+    WARP_MESH  m;
+    WARP_BLOCK *blocks, *next;
+    double     cx[4], cy[4];
+    int        count, err = 0;
+
+    if( width <= 0 || height <= 0 )
+        return 0;
+
+    m.plan = pj_transform_plan_create( src, dst );
+    if( m.plan == NULL )
+        return src->ctx->last_errno ? src->ctx->last_errno : ENOMEM;
+
+    m.src = src;
+    m.dst = dst;
+    m.width = width;
+    m.height = height;
+    m.x0 = x0;
+    m.y0 = y0;
+    m.dx = dx;
+    m.dy = dy;
+    m.tolerance = tolerance;
+    m.x = x;
+    m.y = y;
+
+    blocks = (WARP_BLOCK *) pj_malloc( sizeof(WARP_BLOCK) );
+    if( blocks == NULL )
+    {
+        pj_transform_plan_free( m.plan );
+        return ENOMEM;
+    }
+
+    cx[0] = x0;                     cy[0] = y0;
+    cx[1] = x0 + (width-1) * dx;    cy[1] = y0;
+    cx[2] = x0;                     cy[2] = y0 + (height-1) * dy;
+    cx[3] = cx[1];                  cy[3] = cy[2];
+    mesh_exact( &m, 4, cx, cy );
+
+    blocks->i0 = 0;
+    blocks->j0 = 0;
+    blocks->i1 = width - 1;
+    blocks->j1 = height - 1;
+    memcpy( blocks->cx, cx, sizeof(cx) );
+    memcpy( blocks->cy, cy, sizeof(cy) );
+
+    for( count = 1; count > 0; )
+    {
+        next = (WARP_BLOCK *) pj_malloc( sizeof(WARP_BLOCK) * 4 * count );
+        if( next != NULL )
+            count = mesh_level( &m, blocks, count, next );
+        pj_dalloc( blocks );
+        blocks = next;
+
+        if( next == NULL || count < 0 )
+        {
+            err = ENOMEM;
+            break;
+        }
+    }
+
+    if( blocks != NULL )
+        pj_dalloc( blocks );
+    pj_transform_plan_free( m.plan );
+
+    return err;
+}
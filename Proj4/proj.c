@@ -48,6 +48,15 @@ facs;
 	static double
 (*informat)(const char *, char **),	/* input data deformatter function */
 fscale = 0.;	/* cartesian scale factor */
+	static void	/* output value with oform */
+put_oform(double value) {
+	char buf[100];
+
+	if (pj_format_double(buf, sizeof(buf), oform, value) >= 0)
+		(void)fputs(buf, stdout);
+	else
+		(void)printf(oform, value);
+}
 	static projUV
 int_proj(projUV data) {
 	if (prescale) { data.u *= fscale; data.v *= fscale; }
@@ -130,11 +139,11 @@ process(FILE *fid) {
 				data.u *= RAD_TO_DEG;
 			}
 			if (reverseout) {
-				(void)printf(oform,data.v); putchar('\t');
-				(void)printf(oform,data.u);
+				put_oform(data.v); putchar('\t');
+				put_oform(data.u);
 			} else {
-				(void)printf(oform,data.u); putchar('\t');
-				(void)printf(oform,data.v);
+				put_oform(data.u); putchar('\t');
+				put_oform(data.v);
 			}
 		}
 		if (dofactors) /* print scale factor data */
@@ -185,8 +194,8 @@ vprocess(FILE *fid) {
 				emess(-1,"inverse for this projection not avail.\n");
 				continue;
 			}
-			dat_xy.u = strtod(s, &s);
-			dat_xy.v = strtod(s, &s);
+			dat_xy.u = pj_strtod(s, &s);
+			dat_xy.v = pj_strtod(s, &s);
 			if (dat_xy.u == HUGE_VAL || dat_xy.v == HUGE_VAL) {
 				emess(-1,"lon-lat input conversion failure\n");
 				continue;
@@ -221,9 +230,9 @@ vprocess(FILE *fid) {
 		(void)fputs(rtodms(pline, dat_ll.v, 'N', 'S'), stdout);
 		(void)printf(" [ %.11g ]\n", dat_ll.v * RAD_TO_DEG);
 		(void)fputs("Easting (x):   ", stdout);
-		(void)printf(oform, dat_xy.u); putchar('\n');
+		put_oform(dat_xy.u); putchar('\n');
 		(void)fputs("Northing (y):  ", stdout);
-		(void)printf(oform, dat_xy.v); putchar('\n');
+		put_oform(dat_xy.v); putchar('\n');
 		(void)printf("Meridian scale (h)%c: %.8f  ( %.4g %% error )\n",
 			facs.code & IS_ANAL_HK ? '*' : ' ', facs.h, (facs.h-1.)*100.);
 		(void)printf("Parallel scale (k)%c: %.8f  ( %.4g %% error )\n",
@@ -455,7 +464,7 @@ int main(int argc, char **argv) {
         }
     }
     if (inverse)
-        informat = strtod;
+        informat = pj_strtod;
     else {
         informat = dmstor;
         if (!oform)
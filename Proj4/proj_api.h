@@ -53,10 +53,16 @@ extern int pj_errno;	/* global error return code */
 #if !defined(PROJECTS_H)
     typedef struct { double u, v; } projUV;
     typedef void *projPJ;
+    typedef void *projCtx;
+    typedef void *projTransformPlan;
+    typedef void *projApprox;
     #define projXY projUV
     #define projLP projUV
 #else
     typedef PJ *projPJ;
+    typedef projCtx_t *projCtx;
+    typedef PJ_TRANSFORM_PLAN *projTransformPlan;
+    typedef PJ_APPROX *projApprox;
 #   define projXY	XY
 #   define projLP       LP
 #endif
@@ -65,9 +71,33 @@ extern int pj_errno;	/* global error return code */
 
 projXY pj_fwd(projLP, projPJ);
 projLP pj_inv(projXY, projPJ);
+int pj_fwd_array(projPJ, long point_count, int point_offset,
+                 double *x, double *y);
+int pj_inv_array(projPJ, long point_count, int point_offset,
+                 double *x, double *y);
+int pj_utm_fwd_array(projPJ, long point_count, int point_offset,
+                     const int *zone, double *x, double *y);
+int pj_utm_inv_array(projPJ, long point_count, int point_offset,
+                     const int *zone, double *x, double *y);
 
 int pj_transform( projPJ src, projPJ dst, long point_count, int point_offset,
                   double *x, double *y, double *z );
+int pj_transform_parallel( projPJ src, projPJ dst,
+                           long point_count, int point_offset,
+                           double *x, double *y, double *z, int thread_count );
+projTransformPlan pj_transform_plan_create( projPJ src, projPJ dst );
+int pj_transform_plan_execute( projTransformPlan,
+                               long point_count, int point_offset,
+                               double *x, double *y, double *z );
+void pj_transform_plan_free( projTransformPlan );
+projApprox pj_approx_create( projPJ, int inverse, projUV min, projUV max,
+                             double max_error );
+int pj_approx_eval( projApprox, long point_count, int point_offset,
+                    double *x, double *y );
+void pj_approx_free( projApprox );
+int pj_warp_mesh( projPJ src, projPJ dst, int width, int height,
+                  double x0, double y0, double dx, double dy,
+                  double tolerance, double *x, double *y );
 int pj_datum_transform( projPJ src, projPJ dst, long point_count, int point_offset,
                         double *x, double *y, double *z );
 int pj_geocentric_to_geodetic( double a, double es,
@@ -80,6 +110,9 @@ int pj_compare_datums( projPJ srcdefn, projPJ dstdefn );
 int pj_apply_gridshift( const char *, int, 
                         long point_count, int point_offset,
                         double *x, double *y, double *z );
+int pj_apply_gridshift_ctx( projCtx, const char *, int, 
+                            long point_count, int point_offset,
+                            double *x, double *y, double *z );
 void pj_deallocate_grids(void);
 int pj_is_latlong(projPJ);
 int pj_is_geocent(projPJ);
@@ -87,19 +120,49 @@ void pj_pr_list(projPJ);
 void pj_free(projPJ);
 void pj_set_finder( const char *(*)(const char *) );
 void pj_set_searchpath ( int count, const char **path );
+void pj_set_grid_cache_size( long max_bytes );
 projPJ pj_init(int, char **);
 projPJ pj_init_plus(const char *);
+projPJ pj_clone(projPJ);
 char *pj_get_def(projPJ, int);
+#define PJ_DEF_ALL_PARAMS 0x1   /* pj_get_def() option: keep unused params */
 projPJ pj_latlong_from_proj( projPJ );
 void *pj_malloc(size_t);
 void pj_dalloc(void *);
+void pj_set_allocator( void *(*)(size_t), void (*)(void *) );
+void pj_get_alloc_stats( long *allocs, long *frees, long *bytes );
 char *pj_strerrno(int);
+double pj_strtod( const char *nptr, char **endptr );
+int pj_format_double( char *buf, int size, const char *format, double value );
 int *pj_get_errno_ref(void);
 const char *pj_get_release(void);
 void pj_acquire_lock(void);
 void pj_release_lock(void);
 void pj_cleanup_lock(void);
 
+projCtx pj_get_default_ctx(void);
+projCtx pj_get_ctx( projPJ );
+void pj_set_ctx( projPJ, projCtx );
+projCtx pj_ctx_alloc(void);
+void    pj_ctx_free( projCtx );
+int pj_ctx_get_errno( projCtx );
+void pj_ctx_set_errno( projCtx, int );
+void pj_ctx_set_debug( projCtx, int );
+void pj_ctx_set_logger( projCtx, void (*)(void *, int, const char *) );
+void pj_ctx_set_app_data( projCtx, void * );
+void *pj_ctx_get_app_data( projCtx );
+projPJ pj_init_ctx( projCtx, int, char ** );
+projPJ pj_init_plus_ctx( projCtx, const char * );
+projPJ pj_clone_ctx( projCtx, projPJ );
+
+void pj_log( projCtx ctx, int level, const char *fmt, ... );
+void pj_stderr_logger( void *, int, const char * );
+
+#define PJ_LOG_NONE        0
+#define PJ_LOG_ERROR       1
+#define PJ_LOG_DEBUG_MAJOR 2
+#define PJ_LOG_DEBUG_MINOR 3
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,269 @@
+/* Time pj_transform_parallel() against pj_transform() at 1..N threads,
+** or with -d, the datum shift a block of points at a time against step
+** by step, or with -a, pj_fwd_array()/pj_inv_array() against
+** pj_fwd()/pj_inv() and check that they agree to within -u ulps
+** (default 0) */
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <projects.h>
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <sys/time.h>
+#endif
+	static char
+*usage = "[ -n points ] [ -t threads | -d ] [ -b lon0,lat0,lon1,lat1 ] +src_opts +to +dst_opts\n"
+"   or: projbench [ -n points ] [ -b lon0,lat0,lon1,lat1 ] -a [ -u ulps ] +proj_opts";
+
+	static double
+now(void) {
+#ifdef _WIN32
+	LARGE_INTEGER freq, t;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&t);
+	return (double)t.QuadPart / (double)freq.QuadPart;
+#else
+	struct timeval t;
+
+	gettimeofday(&t, NULL);
+	return t.tv_sec + t.tv_usec * 1e-6;
+#endif
+}
+	static long /* points of x, y, z that differ from xs, ys, zs */
+differ_count(long n, double *x, double *y, double *z,
+		double *xs, double *ys, double *zs) {
+	long i, differ = 0;
+
+	for (i = 0; i < n; i++)
+		if (memcmp(x + i, xs + i, sizeof(double))
+			|| memcmp(y + i, ys + i, sizeof(double))
+			|| memcmp(z + i, zs + i, sizeof(double)))
+			differ++;
+	return differ;
+}
+	static double /* distance of b from a in units in the last place of a */
+ulps(double a, double b) {
+	int e;
+
+	if (a == b)
+		return 0.;
+	if (a == HUGE_VAL || b == HUGE_VAL)
+		return HUGE_VAL;
+	(void)frexp(a, &e);
+	return fabs(a - b) / ldexp(1., e - 53);
+}
+	static double /* largest ulps() between two sets of n points from in */
+max_ulps(long n, double *in, double *xa, double *ya, double *xb, double *yb) {
+	double d, max = 0.;
+	long i;
+
+	for (i = 0; i < n; i++) {
+		/* the array calls pass HUGE_VAL through, pj_inv() does not */
+		if (in[i] == HUGE_VAL)
+			continue;
+		if ((d = ulps(xa[i], xb[i])) > max) max = d;
+		if ((d = ulps(ya[i], yb[i])) > max) max = d;
+	}
+	return max;
+}
+	static int /* pj_fwd_array() and pj_inv_array() against pj_fwd() and pj_inv() */
+array_bench(projPJ P, long n, double *box, double bound) {
+	double *lam, *phi, *xs, *ys, *x, *y, t, serial, d, fwd_max, inv_max;
+	size_t size = sizeof(double) * n;
+	projUV lp, xy;
+	long i;
+	int err;
+
+	if (!(lam = (double *)malloc(size)) || !(phi = (double *)malloc(size))
+		|| !(xs = (double *)malloc(size)) || !(ys = (double *)malloc(size))
+		|| !(x = (double *)malloc(size)) || !(y = (double *)malloc(size))) {
+		perror("mem. alloc");
+		exit(1);
+	}
+	srand(1);
+	for (i = 0; i < n; i++) {
+		lam[i] = (box[0] + (box[2] - box[0]) * rand() / RAND_MAX) * DEG_TO_RAD;
+		phi[i] = (box[1] + (box[3] - box[1]) * rand() / RAND_MAX) * DEG_TO_RAD;
+	}
+
+	t = now();
+	for (i = 0; i < n; i++) {
+		lp.u = lam[i];
+		lp.v = phi[i];
+		xy = pj_fwd(lp, P);
+		xs[i] = xy.u;
+		ys[i] = xy.v;
+	}
+	serial = now() - t;
+	memcpy(x, lam, size);
+	memcpy(y, phi, size);
+	t = now();
+	err = pj_fwd_array(P, n, 1, x, y);
+	t = now() - t;
+	fwd_max = max_ulps(n, lam, xs, ys, x, y);
+	printf("%ld points, pj_fwd(): %.3fs (%.2f Mpts/s), pj_fwd_array(): "
+		"%.3fs (%.2f Mpts/s) x%.2f, returned %d, %.0f ulps\n",
+		n, serial, n / serial * 1e-6, t, n / t * 1e-6, serial / t,
+		err, fwd_max);
+
+	/* back again from the points pj_fwd() made */
+	t = now();
+	for (i = 0; i < n; i++) {
+		xy.u = xs[i];
+		xy.v = ys[i];
+		lp = pj_inv(xy, P);
+		lam[i] = lp.u;
+		phi[i] = lp.v;
+	}
+	serial = now() - t;
+	memcpy(x, xs, size);
+	memcpy(y, ys, size);
+	t = now();
+	err = pj_inv_array(P, n, 1, x, y);
+	t = now() - t;
+	inv_max = max_ulps(n, xs, lam, phi, x, y);
+	printf("%ld points, pj_inv(): %.3fs (%.2f Mpts/s), pj_inv_array(): "
+		"%.3fs (%.2f Mpts/s) x%.2f, returned %d, %.0f ulps\n",
+		n, serial, n / serial * 1e-6, t, n / t * 1e-6, serial / t,
+		err, inv_max);
+
+	d = fwd_max > inv_max ? fwd_max : inv_max;
+	if (d > bound) {
+		printf("FAILED: %.0f ulps, more than the %.0f allowed\n", d, bound);
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	projPJ src, dst, geo;
+	double *x0, *y0, *z0, *xs, *ys, *zs, *x, *y, *z;
+	double box[4] = { -180., -80., 180., 80. }, t, serial, bound = 0.;
+	long n = 1000000, i;
+	int threads = pj_cpu_count(), th, err, to, a, bad = 0, array = 0;
+	int datum = 0;
+	size_t size;
+
+	for (a = 1; a < argc && argv[a][0] == '-' && !bad; a++) {
+		if (!strcmp(argv[a], "-a"))
+			array = 1;
+		else if (!strcmp(argv[a], "-d"))
+			datum = 1;
+		else if (a + 1 >= argc)
+			bad = 1;
+		else if (!strcmp(argv[a], "-n"))
+			n = atol(argv[++a]);
+		else if (!strcmp(argv[a], "-t"))
+			threads = atoi(argv[++a]);
+		else if (!strcmp(argv[a], "-b"))
+			bad = sscanf(argv[++a], "%lf,%lf,%lf,%lf",
+				box, box + 1, box + 2, box + 3) != 4;
+		else if (!strcmp(argv[a], "-u"))
+			bound = atof(argv[++a]);
+		else
+			bad = 1;
+	}
+	if (array) {
+		if (bad || datum || a == argc || n <= 0 || bound < 0.) {
+			fprintf(stderr, "usage: %s %s\n", argv[0], usage);
+			exit(1);
+		}
+		if (!(src = pj_init(argc - a, argv + a))) {
+			fprintf(stderr, "projection initialization failure: %s\n",
+				pj_strerrno(pj_errno));
+			exit(1);
+		}
+		exit(array_bench(src, n, box, bound));
+	}
+	for (to = a; to < argc && strcmp(argv[to], "+to"); to++)
+		;
+	if (bad || a == to || to >= argc - 1 || n <= 0 || threads <= 0) {
+		fprintf(stderr, "usage: %s %s\n", argv[0], usage);
+		exit(1);
+	}
+	if (!(src = pj_init(to - a, argv + a))
+		|| !(dst = pj_init(argc - to - 1, argv + to + 1))
+		|| !(geo = pj_latlong_from_proj(src))) {
+		fprintf(stderr, "projection initialization failure: %s\n",
+			pj_strerrno(pj_errno));
+		exit(1);
+	}
+
+	size = sizeof(double) * n;
+	if (!(x0 = (double *)malloc(size)) || !(y0 = (double *)malloc(size))
+		|| !(z0 = (double *)malloc(size)) || !(xs = (double *)malloc(size))
+		|| !(ys = (double *)malloc(size)) || !(zs = (double *)malloc(size))
+		|| !(x = (double *)malloc(size)) || !(y = (double *)malloc(size))
+		|| !(z = (double *)malloc(size))) {
+		perror("mem. alloc");
+		exit(1);
+	}
+
+	/* the same random points of the box every run, in src coordinates */
+	srand(1);
+	for (i = 0; i < n; i++) {
+		x0[i] = (box[0] + (box[2] - box[0]) * rand() / RAND_MAX) * DEG_TO_RAD;
+		y0[i] = (box[1] + (box[3] - box[1]) * rand() / RAND_MAX) * DEG_TO_RAD;
+		z0[i] = 0.;
+	}
+	pj_transform(geo, src, n, 1, x0, y0, z0);
+
+	memcpy(xs, x0, size);
+	memcpy(ys, y0, size);
+	memcpy(zs, z0, size);
+	t = now();
+	err = pj_transform(src, dst, n, 1, xs, ys, zs);
+	serial = now() - t;
+	printf("%ld points, pj_transform(): %.3fs (%.2f Mpts/s), returned %d\n",
+		n, serial, n / serial * 1e-6, err);
+
+	if (datum) {
+		/* blocks as big as the input run each step over every point in
+		** turn; best of three runs of each, alternating */
+		double blocked = serial, stepwise = 0.;
+		long differ = 0;
+		int round;
+
+		for (round = 0; round < 3; round++) {
+			memcpy(x, x0, size);
+			memcpy(y, y0, size);
+			memcpy(z, z0, size);
+			pj_set_datum_block_size(n);
+			t = now();
+			err = pj_transform(src, dst, n, 1, x, y, z);
+			t = now() - t;
+			if (round == 0 || t < stepwise)
+				stepwise = t;
+			differ = differ_count(n, x, y, z, xs, ys, zs);
+			memcpy(x, x0, size);
+			memcpy(y, y0, size);
+			memcpy(z, z0, size);
+			pj_set_datum_block_size(0);
+			t = now();
+			pj_transform(src, dst, n, 1, x, y, z);
+			t = now() - t;
+			if (t < blocked)
+				blocked = t;
+		}
+		printf("datum shift by block: %.3fs (%.2f Mpts/s), step by step: "
+			"%.3fs (%.2f Mpts/s) x%.2f, returned %d, %ld points differ\n",
+			blocked, n / blocked * 1e-6, stepwise, n / stepwise * 1e-6,
+			stepwise / blocked, err, differ);
+		exit(0);
+	}
+	for (th = 1; th <= threads; th++) {
+		memcpy(x, x0, size);
+		memcpy(y, y0, size);
+		memcpy(z, z0, size);
+		t = now();
+		err = pj_transform_parallel(src, dst, n, 1, x, y, z, th);
+		t = now() - t;
+		printf("%3d threads: %.3fs (%.2f Mpts/s) x%.2f, returned %d, "
+			"%ld points differ\n", th, t, n / t * 1e-6, serial / t,
+			err, differ_count(n, x, y, z, xs, ys, zs));
+	}
+	exit(0); /* normal completion */
+}
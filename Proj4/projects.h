@@ -44,6 +44,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 
 #ifdef __cplusplus
 #define C_NAMESPACE extern "C"
@@ -200,17 +201,35 @@ struct FACTORS {
     /* parameter list struct */
 typedef struct ARG_list {
 	struct ARG_list *next;
+	struct PJ_PARAM_INDEX *index; /* head entry only, see pj_param_pack() */
 	char used;
 	char param[1]; } paralist;
+
+    /* context -- per thread error state, debug level and logger */
+typedef struct projCtx_t {
+	int	last_errno;	/* last error code set in this context */
+	int	debug_level;	/* PJ_LOG_NONE ... PJ_LOG_DEBUG_MINOR */
+	void	(*logger)(void *, int, const char *); /* message sink */
+	void	*app_data;	/* passed through to logger */
+} projCtx_t;
+
 	/* base projection data structure */
 
 
 typedef struct PJconsts {
 	XY  (*fwd)(LP, struct PJconsts *);
 	LP  (*inv)(XY, struct PJconsts *);
+	/* optional batch versions of fwd/inv: transform n points in place,  */
+	/* every stride'th double of x/y.  Points with x HUGE_VAL on input   */
+	/* come out as HUGE_VAL, points that fail are set to HUGE_VAL and    */
+	/* the error is left in ctx, which the caller clears beforehand.     */
+	void (*fwd_n)(struct PJconsts *, long, int, double *, double *);
+	void (*inv_n)(struct PJconsts *, long, int, double *, double *);
 	void (*spc)(LP, struct PJconsts *, struct FACTORS *);
 	void (*pfree)(struct PJconsts *);
 	const char *descr;
+	projCtx_t *ctx;     /* error state and logging for this object */
+	struct PJconsts *link; /* projection this one wraps (ob_tran), or 0 */
 	paralist *params;   /* parameter list */
 	int over;   /* over-range flag */
 	int geoc;   /* geocentric latitude flag */
@@ -234,12 +253,23 @@ typedef struct PJconsts {
         double  datum_params[7];
         double  from_greenwich; /* prime meridian offset (in radians) */
         double  long_wrap_center; /* 0.0 for -180 to 180, actually in radians*/
+
+        struct _pj_gridlist *gridlist; /* nadgrids list, resolved on use */
+        int     gridlist_generation;   /* pj_gridlist_generation() then */
+        int     params_expanded; /* params after +init= and defaults, before
+                                    pj_datum_set() appended to them */
         
 #ifdef PROJ_PARMS__
 PROJ_PARMS__
 #endif /* end of optional extensions */
 } PJ;
 
+    /* stage sequence of a pj_transform(), see pj_transform_plan_create() */
+typedef struct PJ_TRANSFORM_PLAN PJ_TRANSFORM_PLAN;
+
+    /* fitted series for a projection, see pj_approx_create() */
+typedef struct PJ_APPROX PJ_APPROX;
+
 /* public API */
 #include "proj_api.h"
 
@@ -288,18 +318,23 @@ extern struct PJ_PRIME_MERIDIANS pj_prime_meridians[];
 	C_NAMESPACE PJ *pj_##name(PJ *P) { if (!P) { \
 	if( (P = (PJ*) pj_malloc(sizeof(PJ))) != NULL) { \
 	P->pfree = freeup; P->fwd = 0; P->inv = 0; \
+	P->fwd_n = 0; P->inv_n = 0; P->link = 0; \
 	P->spc = 0; P->descr = des_##name;
 #define ENTRYX } return P; } else {
 #define ENTRY0(name) ENTRYA(name) ENTRYX
 #define ENTRY1(name, a) ENTRYA(name) P->a = 0; ENTRYX
 #define ENTRY2(name, a, b) ENTRYA(name) P->a = 0; P->b = 0; ENTRYX
 #define ENDENTRY(p) } return (p); }
-#define E_ERROR(err) { pj_errno = err; freeup(P); return(0); }
+#define E_ERROR(err) { pj_ctx_set_errno( P->ctx, err); freeup(P); return(0); }
 #define E_ERROR_0 { freeup(P); return(0); }
-#define F_ERROR { pj_errno = -20; return(xy); }
-#define I_ERROR { pj_errno = -20; return(lp); }
+#define F_ERROR { pj_ctx_set_errno( P->ctx, -20); return(xy); }
+#define I_ERROR { pj_ctx_set_errno( P->ctx, -20); return(lp); }
 #define FORWARD(name) static XY name(LP lp, PJ *P) { XY xy = {0.0,0.0}
 #define INVERSE(name) static LP name(XY xy, PJ *P) { LP lp = {0.0,0.0}
+#define FORWARD_N(name) static void name(PJ *P, long n, int stride, \
+	double *x, double *y) { long i; int n_err = 0
+#define INVERSE_N(name) FORWARD_N(name)
+#define N_ERROR(err) { x[i*stride] = y[i*stride] = HUGE_VAL; n_err = err; continue; }
 #define FREEUP static void freeup(PJ *P) {
 #define SPECIAL(name) static void name(LP lp, PJ *P, struct FACTORS *fac)
 #endif
@@ -313,6 +348,21 @@ struct CTABLE {
 	LP del;     /* size of cells */
 	ILP lim;    /* limits of conversion matrix */
 	FLP *cvs;   /* conversion matrix */
+
+	/* runtime only, not part of a ctable file header */
+	float *ntv2;    /* mapped NTv2 records, converted in nad_intr() */
+	void *map;      /* memory mapping holding cvs or ntv2, if any */
+	size_t map_size;
+	struct PJ_GRIDTILES *tiles; /* tile cache, when paged in by tile */
+};
+
+/* ctable file header, the leading members of struct CTABLE */
+struct CTABLE_HDR {
+	char id[MAX_TAB_ID];
+	LP ll;
+	LP del;
+	ILP lim;
+	FLP *cvs;
 };
 
 typedef struct _pj_gi {
@@ -330,37 +380,78 @@ typedef struct _pj_gi {
     struct _pj_gi *child;
 } PJ_GRIDINFO;
 
+/* bucket index over an ordered set of grids, see pj_gridlist.c */
+typedef struct {
+    PJ_GRIDINFO **grids;    /* in search order */
+    int   count;
+    unsigned char *solo;    /* set if no earlier grid overlaps this one */
+    LP    ll, del;          /* bucket layout */
+    int   nx, ny;
+    int   *start;           /* first item of each bucket, nx*ny+1 entries */
+    int   *items;           /* grid numbers, ascending within a bucket */
+} PJ_GRIDSET;
+
+/* grids resolved from one nadgrids string, never changed once built */
+typedef struct _pj_gridlist {
+    struct _pj_gridlist *next;
+    char  *nadgrids;
+    int   count;
+    int   max;
+    PJ_GRIDINFO **list;
+    PJ_GRIDSET *tables;     /* index of list, NULL until complete */
+    PJ_GRIDSET *children;   /* index of the children of each table */
+} PJ_GRIDLIST;
+
+/* the grid used for the previous point, see pj_gridlist_find() */
+typedef struct { int table, child; } PJ_GRIDHIT;
+
 /* procedure prototypes */
 double dmstor(const char *, char **);
+double dmstor_ctx(projCtx ctx, const char *, char **);
 void set_rtodms(int, int);
 char *rtodms(char *, double, int, int);
 double adjlon(double);
-double aacos(double), aasin(double), asqrt(double), aatan2(double, double);
-PVALUE pj_param(paralist *, char *);
+double aacos(projCtx,double), aasin(projCtx,double), asqrt(double), aatan2(double, double);
+PVALUE pj_param(projCtx ctx, paralist *, char *);
 paralist *pj_mkparam(char *);
-int pj_ell_set(paralist *, double *, double *);
+paralist *pj_param_pack(paralist *);
+void pj_param_free(paralist *);
+int pj_ell_set(projCtx ctx, paralist *, double *, double *);
 int pj_datum_set(paralist *, PJ *);
 int pj_prime_meridian_set(paralist *, PJ *);
 int pj_angular_units_set(paralist *, PJ *);
 
 paralist *pj_clone_paralist( const paralist* );
+int pj_cpu_count(void);
+void pj_run_threads( void (*)(void *), void *, size_t, int );
+void pj_set_datum_block_size( long );
+int pj_find_proj( const char * );
+int pj_find_ellps( const char * );
+int pj_find_datum( const char * );
+int pj_find_units( const char * );
+int pj_find_prime_meridian( const char * );
 void pj_clear_initcache(void);
 paralist*pj_search_initcache( const char *filekey );
 void pj_insert_initcache( const char *filekey, const paralist *list);
+paralist*pj_search_defncache( const char *definition );
+void pj_insert_defncache( const char *definition, const paralist *list,
+                          int count );
 
 double *pj_enfn(double);
 double pj_mlfn(double, double, double, double *);
-double pj_inv_mlfn(double, double, double *);
+double pj_inv_mlfn(projCtx, double, double, double *);
 double pj_qsfn(double, double, double);
 double pj_tsfn(double, double, double);
 double pj_msfn(double, double, double);
-double pj_phi2(double, double);
+double pj_phi2(projCtx, double, double);
+void pj_tsfn_n(long, int, double *, double);
+void pj_phi2_n(projCtx, long, int, double *, double);
 double pj_qsfn_(double, PJ *);
 double *pj_authset(double);
 double pj_authlat(double, double *);
 COMPLEX pj_zpoly1(COMPLEX, COMPLEX *, int);
 COMPLEX pj_zpolyd1(COMPLEX, COMPLEX *, int, COMPLEX *);
-FILE *pj_open_lib(char *, char *);
+FILE *pj_open_lib(projCtx, char *, char *);
 
 int pj_deriv(LP, double, PJ *, struct DERIVS *);
 int pj_factors(LP, PJ *, double, struct FACTORS *);
@@ -379,6 +470,8 @@ typedef struct {	/* Chebyshev or Power series structure */
 	int power;		/* != 0 if power series, else Chebyshev */
 } Tseries;
 Tseries *mk_cheby(projUV, projUV, double, projUV *, projUV (*)(projUV), int, int, int);
+Tseries *mk_cheby_r(projUV, projUV, double, projUV *,
+	projUV (*)(projUV, void *), void *, int, int, int);
 projUV bpseval(projUV, Tseries *);
 projUV bcheval(projUV, Tseries *);
 projUV biveval(projUV, Tseries *);
@@ -386,30 +479,50 @@ void *vector1(int, int);
 void **vector2(int, int, int);
 void freev2(void **v, int nrows);
 int bchgen(projUV, projUV, int, int, projUV **, projUV(*)(projUV));
+int bchgen_r(projUV, projUV, int, int, projUV **,
+	projUV(*)(projUV, void *), void *);
 int bch2bps(projUV, projUV, projUV **, int, int);
 /* nadcon related protos */
 LP nad_intr(LP, struct CTABLE *);
+LP nad_intr_ctx(projCtx, LP, struct CTABLE *);
 LP nad_cvt(LP, int, struct CTABLE *);
-struct CTABLE *nad_init(char *);
-struct CTABLE *nad_ctable_init( FILE * fid );
-int nad_ctable_load( struct CTABLE *, FILE * fid );
+LP nad_cvt_ctx(projCtx, LP, int, struct CTABLE *);
+struct CTABLE *nad_init(projCtx ctx, char *);
+struct CTABLE *nad_ctable_init( projCtx ctx, FILE * fid );
+int nad_ctable_load( projCtx ctx, struct CTABLE *, FILE * fid );
+void *nad_map_grid( struct CTABLE *, FILE * fid, long offset, size_t size );
 void nad_free(struct CTABLE *);
 
 /* higher level handling of datum grid shift files */
 
-PJ_GRIDINFO **pj_gridlist_from_nadgrids( const char *, int * );
+PJ_GRIDINFO **pj_gridlist_from_nadgrids( projCtx, const char *, int * );
+PJ_GRIDLIST *pj_gridlist_get( projCtx, const char * );
+int pj_gridlist_generation();
+int pj_apply_gridshift_2( PJ *, int, long, int, double *, double *, double * );
+int pj_apply_gridshift_3( projCtx, PJ_GRIDLIST *, int, long, int,
+                          double *, double *, double * );
+PJ_GRIDINFO *pj_gridlist_find( const PJ_GRIDLIST *, LP, int, PJ_GRIDHIT * );
 void pj_deallocate_grids();
 
-PJ_GRIDINFO *pj_gridinfo_init( const char * );
-int pj_gridinfo_load( PJ_GRIDINFO * );
+PJ_GRIDINFO *pj_gridinfo_init( projCtx, const char * );
+int pj_gridinfo_load( projCtx, PJ_GRIDINFO * );
 void pj_gridinfo_free( PJ_GRIDINFO * );
+int pj_gridinfo_read_cells( FILE *, const char *, long, struct CTABLE *,
+                            int row, int col, int count, FLP * );
+
+int pj_gridcache_on();
+int pj_gridcache_attach( PJ_GRIDINFO * );
+void pj_gridcache_detach( struct CTABLE * );
+int pj_gridcache_cell( projCtx, struct CTABLE *, int row, int col, FLP * );
+void pj_acquire_gridcache_lock(void);
+void pj_release_gridcache_lock(void);
 
 void *proj_mdist_ini(double);
 double proj_mdist(double, double, double, const void *);
-double proj_inv_mdist(double, const void *);
+double proj_inv_mdist(projCtx ctx, double, const void *);
 void *pj_gauss_ini(double, double, double *,double *);
 LP pj_gauss(LP, const void *);
-LP pj_inv_gauss(LP, const void *);
+LP pj_inv_gauss(projCtx, LP, const void *);
 
 extern char const pj_release[];
 
@@ -418,6 +531,8 @@ struct PJ_DATUMS *pj_get_datums_ref( void );
 struct PJ_UNITS *pj_get_units_ref( void );
 struct PJ_LIST  *pj_get_list_ref( void );
 struct PJ_PRIME_MERIDIANS  *pj_get_prime_meridians_ref( void );
+
+void pj_vlog( projCtx ctx, int level, const char *fmt, va_list args );
  
 #ifndef DISABLE_CVSID
 #  define PJ_CVSID(string)     static char pj_cvsid[] = string; \
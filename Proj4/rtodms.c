@@ -12,8 +12,10 @@ RES = 1000.,
 RES60 = 60000.,
 CONV = 206264806.24709635515796003417;
 	static char
-format[50] = "%dd%d'%.3f\"%c";
+format[50] = "%dd%d'%.3f\"%c",
+sec_format[8] = "%.3f";
 	static int
+sec_width = 0,
 dolong = 0;
 	void
 set_rtodms(int fract, int con_w) {
@@ -32,7 +34,48 @@ set_rtodms(int fract, int con_w) {
 			(void)sprintf(format,"%%dd%%02d'%%0%d.%df\"%%c",
 				fract+2+(fract?1:0), fract);
 		dolong = con_w;
+		(void)sprintf(sec_format,"%%.%df", fract);
+		sec_width = con_w ? fract+2+(fract?1:0) : 0;
 	}
+}
+/* write non-negative v, zero padded to width */
+	static char *
+put_int(char *s, int v, int width) {
+	char digits[12], *d = digits + sizeof(digits);
+
+	do {
+		*--d = (char)('0' + v % 10);
+		v /= 10;
+		--width;
+	} while (v);
+	for ( ; width > 0; --width)
+		*s++ = '0';
+	while (d < digits + sizeof(digits))
+		*s++ = *d++;
+	return s;
+}
+/* same as sprintf(s, format, deg, min, sec, sign), without the sprintf */
+	static void
+put_dms(char *s, int deg, int min, double sec, int sign) {
+	char sec_str[40];
+	int n;
+
+	n = pj_format_double(sec_str, sizeof(sec_str), sec_format, sec);
+	if (n < 0 || deg < 0 || sec != sec) {
+		(void)sprintf(s,format,deg,min,sec,sign);
+		return;
+	}
+	s = put_int(s, deg, 0);
+	*s++ = 'd';
+	s = put_int(s, min, dolong ? 2 : 0);
+	*s++ = '\'';
+	for ( ; n < sec_width; ++n)
+		*s++ = '0';
+	(void)strcpy(s, sec_str);
+	s += strlen(s);
+	*s++ = '"';
+	*s++ = (char)sign;
+	*s = '\0';
 }
 	char *
 rtodms(char *s, double r, int pos, int neg) {
@@ -54,11 +97,11 @@ rtodms(char *s, double r, int pos, int neg) {
         deg = r;
 
 	if (dolong)
-		(void)sprintf(ss,format,deg,min,sec,sign);
+		put_dms(ss,deg,min,sec,sign);
 	else if (sec) {
 		char *p, *q;
 
-		(void)sprintf(ss,format,deg,min,sec,sign);
+		put_dms(ss,deg,min,sec,sign);
 		for (q = p = ss + strlen(ss) - (sign ? 3 : 2); *p == '0'; --p) ;
 		if (*p != '.')
 			++p;